@@ -0,0 +1,35 @@
+# Script mode (cmake -P): writes the build ID header used to key the result cache.
+# Run by the backtester_build_id target on every build, so a commit or a local
+# edit changes the ID without re-running the configure step.
+#   -DSOURCE_DIR=<repo root> -DOUTPUT=<header path> -DFALLBACK=<project version>
+
+execute_process(
+    COMMAND git describe --always --dirty
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE BUILD_ID
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET
+)
+if(NOT BUILD_ID)
+    set(BUILD_ID "${FALLBACK}")
+endif()
+
+# "-dirty" (or no git at all) names no particular state of the tree; add a hash
+# of the sources so every edit gets its own ID
+if(BUILD_ID MATCHES "-dirty$" OR BUILD_ID STREQUAL "${FALLBACK}")
+    file(GLOB BUILD_SOURCES "${SOURCE_DIR}/include/*.h" "${SOURCE_DIR}/src/*.cpp")
+    list(SORT BUILD_SOURCES)
+    set(SOURCE_HASHES "")
+    foreach(SOURCE ${BUILD_SOURCES})
+        file(SHA1 ${SOURCE} SOURCE_HASH)
+        string(APPEND SOURCE_HASHES "${SOURCE_HASH}")
+    endforeach()
+    string(SHA1 TREE_HASH "${SOURCE_HASHES}")
+    string(SUBSTRING ${TREE_HASH} 0 12 TREE_HASH)
+    set(BUILD_ID "${BUILD_ID}-${TREE_HASH}")
+endif()
+
+# Only touch the header when the ID changes, so an unchanged tree rebuilds nothing
+file(WRITE "${OUTPUT}.tmp" "// Generated by cmake/BuildId.cmake\n#define BACKTESTER_BUILD_ID \"${BUILD_ID}\"\n")
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
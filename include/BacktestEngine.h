@@ -7,20 +7,92 @@
 #include "Strategy.h"
 #include "Bar.h"
 #include "DataLoader.h"
+#include "BarSeries.h"
+#include "RunResult.h"
+#include "SimClock.h"
+#include "TimerWheel.h"
 #include <vector>
 #include <string>
 #include <memory>
-#include <map> 
+#include <map>
+#include <atomic>
+#include <chrono>
 
 class BacktestEngine {
 private:
+    // A strategy hosted by the engine together with the account it trades
+    struct StrategySlot {
+        std::unique_ptr<Strategy> strategy;
+        Broker* account = nullptr;  // Sub-account broker or the shared portfolio broker (non-owning)
+        double allocation = 1.0;    // Share of starting cash (sub-account) or margin cap (shared)
+        int brokerStrategyId = -1;  // Id on the shared portfolio broker (-1 in sub-account mode)
+        size_t warmup = 0;          // Bars fed to indicators before next() is called
+        bool orderEvent = false;    // One of its orders was filled/rejected since next() last ran
+    };
+
     Config config; // Store the configuration
     std::vector<Bar> historicalData;
-    std::unique_ptr<Broker> broker; // Broker managed by engine
-    std::unique_ptr<Strategy> strategy; // Strategy managed by engine
+    BarSeries series; // Columnar view of historicalData, built once after loading
+    const std::vector<Bar>* bars; // Bars the loop runs over: historicalData, or the parent's in a segment engine
+    const BarSeries* barSeries;   // Columnar view matching bars
+    std::unique_ptr<Broker> broker; // Portfolio broker managed by engine
+    std::vector<std::unique_ptr<Broker>> subAccounts; // Per-strategy brokers in sub-account mode
+    std::vector<StrategySlot> strategies; // Strategies managed by engine, run in one data pass
+    std::vector<Broker*> accounts; // Distinct brokers processed each bar (non-owning)
+    bool sharedPortfolio; // true: all strategies trade the portfolio broker
     size_t currentBarIndex;
     std::map<std::string, double> currentPrices; // Map symbol to current price (close)
     double currentPrice;
+    SimClock clock; // Market time of the bar being processed, read by brokers and strategies
+    IntrabarPath intrabarPath = IntrabarPath::CLOSE; // Configured path (/Broker/INTRABAR_PATH)
+    IntrabarModel intrabar; // Path resolved against the loaded columns, shared by every account
+    CommissionModel commissionModel; // /Broker/COMMISSION_* settings
+    SlippageModel slippageModel;     // /Broker/SLIPPAGE_* settings (seed offset per account)
+    double participationRate = 0.0; // /Broker/PARTICIPATION_RATE: fraction of bar volume an account's opening fills may take (0 = off)
+    double marginCallLevel = 0.0;   // /Broker/MARGIN_CALL_LEVEL: % of used margin below which new positions are refused (0 = off)
+    double maintenanceMargin = 0.0; // /Broker/MAINTENANCE_MARGIN: % of used margin below which positions are liquidated (0 = off)
+    TimerWheel timers; // Strategy timers, owner = index into strategies
+    std::vector<TimerWheel::Expired> expiredTimers; // Timers due on the current bar (reused)
+    std::vector<double> equityCurve; // Portfolio equity sampled after every bar
+    bool fastForward; // Honour strategy wake-up hints and skip bars where nothing can happen
+    std::vector<size_t> historySeen; // Per account: order history entries already routed to orderEvent
+
+    // --- Checkpointing ---
+    size_t checkpointInterval; // Bars between snapshots (0 = off)
+    std::string checkpointDir;
+    bool resumeFromCheckpoint;
+    size_t lastCheckpointBar;
+    std::vector<size_t> ledgerCount;  // Per account: order history entries already in its ledger file
+    std::vector<size_t> ledgerBytes;  // Per account: ledger file size at the last snapshot
+    size_t equityWritten;             // Equity samples already in the equity ledger
+    bool incremental;                 // Resume from a matching snapshot and snapshot again at the end
+    uint64_t configHash;              // Fingerprint of the config sections that affect results
+    uint64_t dataHash;                // FNV-1a over bars [0, dataHashBars)
+    size_t dataHashBars;
+
+    // --- Result Cache ---
+    bool useResultCache;
+    std::string resultCacheDir;
+    RunResult result; // Summary of the last run (or the cached one)
+    std::string tradeLogPath; // Order history export after a run ("" = off; *.csv = text, else columnar binary)
+
+    // --- Segment-parallel Runs ---
+    bool segmentParallel; // Cut the series at strategy reset points and simulate the pieces in parallel
+    size_t segmentThreads; // 0 = hardware concurrency
+
+    // --- Budgets ---
+    double maxSeconds;           // Wall-clock budget per run (0 = none)
+    size_t maxBars;              // Bars simulated per run (0 = none)
+    size_t maxOrders;            // Orders processed (filled or rejected) per run (0 = none)
+    double maxDrawdown;          // Stop once drawdown exceeds this percentage (0 = none)
+    bool stopOnLiquidation;      // Stop once any account has been liquidated
+    size_t budgetCheckInterval;  // Bars between budget checks
+    std::shared_ptr<std::atomic<bool>> cancelFlag; // Shared with segment engines
+    std::string stopReason;      // Why the last run stopped early (empty = ran to the end)
+    std::chrono::steady_clock::time_point runStart;
+    double budgetPeak;           // Equity peak over the samples scanned so far
+    size_t budgetScanned;        // Equity samples already scanned for the drawdown rule
+    size_t budgetOrigin;         // First bar of the run; the bar budget and check cadence count from it
 
     DataLoader dataLoader;
 
@@ -29,16 +101,96 @@ private:
     // Helper to create strategy instance based on config (if needed later)
     // std::unique_ptr<Strategy> createStrategy(const std::string& name);
 
+    // Creates the brokers for the current strategy set and links them up
+    void setupAccounts();
+    // Writes each account's order history to tradeLogPath
+    void exportTradeLog(const std::vector<const TradeLedger*>& histories) const;
+    std::unique_ptr<Broker> createBroker(double startingCash) const;
+    // Creates the accounts, links strategies to them and calls init() with
+    // the clock at startBar. Returns false if an init() threw.
+    bool initStrategies(size_t startBar);
+    // Feeds bars [fromBar, toBar) to strategies that have indicators
+    void replayIndicators(size_t fromBar, size_t toBar);
+    // The event loop over bars [startBar, endBar). Returns the number of
+    // fast-forwarded bars.
+    size_t simulate(size_t startBar, size_t endBar);
+
+    // --- Fast-forward ---
+    // Flags slots whose orders reached the account's history since the last call
+    void collectOrderEvents();
+    // Whether the slot's strategy should be called on this bar (clears its hint if so)
+    bool isAwake(StrategySlot& slot, size_t barIndex, double price);
+    // First bar after barIndex (at most endBar) on which any strategy, timer, pending order or TP/SL needs attention
+    size_t findNextActiveBar(size_t barIndex, size_t endBar) const;
+
+    // --- Checkpointing ---
+    // Appends new order history and equity to the ledgers, then writes the
+    // snapshot (tmp file + rename, so a crash never leaves a torn snapshot).
+    void saveCheckpoint(size_t nextBar);
+    // Restores the latest snapshot. Returns the bar to resume from, or 0 when
+    // there is no usable snapshot. Throws if a matching snapshot is corrupt.
+    size_t restoreCheckpoint();
+    void resetLedgers();
+    std::string checkpointPath(const std::string& file) const;
+
+    // --- Budgets ---
+    // Checks cancellation and the budgets/early-stop rules. Sets stopReason
+    // and returns true when the run has to stop after the current bar.
+    bool budgetExceeded(size_t barsRun);
+
+    // --- Result Cache ---
+    // Config (minus Engine/Sweep), data fingerprint and strategy build IDs/allocations
+    uint64_t resultCacheKey() const;
+    void buildResult(double finalValue);
+
+    // --- Segment-parallel Runs ---
+    // Segment boundaries [0, ..., totalBars]: reset points declared by every
+    // strategy, at most one per thread and spread evenly over the bars
+    std::vector<size_t> findSegmentCuts() const;
+    // Simulates the segments on child engines in parallel, then stitches
+    // their accounts and equity onto this engine in bar order. Segments start
+    // with the full starting cash, and the bar, order and drawdown budgets
+    // depend on everything before a bar, so both are checked on the stitched
+    // run: from the first segment whose cash or margin checks could have gone
+    // differently with the cash carried into it, or that a budget could stop
+    // in, the run is left to continue sequentially at resumeBar (the end of
+    // the series when every segment was used). Returns false (nothing
+    // changed) if the run cannot be segmented.
+    bool runSegments(size_t& skippedBars, size_t& resumeBar);
+    // Child side: init fresh strategies and simulate [startBar, endBar)
+    bool runSegment(size_t startBar, size_t endBar, size_t& skippedBars);
+
 public:
     // Constructor takes the config object
     explicit BacktestEngine(const Config& cfg);
+    // Runs on bars loaded elsewhere (e.g. one load shared by the engines of a
+    // parameter sweep) instead of calling loadData(). data and view must
+    // describe the same bars and outlive the engine.
+    BacktestEngine(const Config& cfg, const std::vector<Bar>& data, const BarSeries& view);
 
     // --- Setup ---
     bool loadData(); // Returns true on success
-    void setStrategy(std::unique_ptr<Strategy> strat); // Engine takes ownership
+    void setStrategy(std::unique_ptr<Strategy> strat); // Engine takes ownership, replaces any added strategies
+    // Adds a strategy to the portfolio. In sub-account mode allocation is its
+    // share of starting cash; in shared mode it caps the margin its positions
+    // may hold, as a share of portfolio equity.
+    void addStrategy(std::unique_ptr<Strategy> strat, double allocation = 1.0);
 
     // --- Execution ---
     void run();
+    // Thread-safe. The run stops at its next budget check (see
+    // /Engine/BUDGET_CHECK_INTERVAL) and reports what it had simulated.
+    void cancel() { cancelFlag->store(true); }
+
+    // --- Data Access ---
+    const BarSeries& getSeries() const { return *barSeries; }
+    const std::vector<Bar>& getBars() const { return *bars; }
+
+    // --- Results ---
+    const std::vector<double>& getEquityCurve() const { return equityCurve; }
+    const RunResult& getResult() const { return result; }
+    const std::string& getStopReason() const { return stopReason; }
+    double getPortfolioValue(double price) const;
 };
 
-#endif // BACKTESTENGINE_H
\ No newline at end of file
+#endif // BACKTESTENGINE_H
@@ -0,0 +1,60 @@
+// BarSeries.h
+#ifndef BARSERIES_H
+#define BARSERIES_H
+
+#include "Bar.h"
+#include "ColumnSpec.h"
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+// Column-major copy of the loaded bars: one contiguous array per column.
+// Built once after loading so whole-column scans (sweeps, look-backs,
+// vectorized passes) stream through memory instead of hopping between
+// per-bar heap vectors.
+class BarSeries {
+public:
+    // Column the engine and broker price from (Bar::columns[1])
+    static constexpr size_t PRICE_COLUMN = 1;
+
+    BarSeries() = default;
+    // Column names/types come from the ColumnSpecs used to parse the bars.
+    // Unnamed columns are called "col<N>"; short bars are padded with NaN.
+    BarSeries(const std::vector<Bar>& bars, const std::vector<ColumnSpec>& specs);
+
+    size_t size() const { return timestamps_.size(); }
+    bool empty() const { return timestamps_.empty(); }
+    size_t numColumns() const { return columns_.size(); }
+
+    const std::vector<std::chrono::system_clock::time_point>& timestamps() const { return timestamps_; }
+    const double* column(size_t col) const { return columns_[col].data(); }
+    double value(size_t bar, size_t col) const { return columns_[col][bar]; }
+    const double* prices() const { return columns_.size() > PRICE_COLUMN ? column(PRICE_COLUMN) : nullptr; }
+
+    const std::string& columnName(size_t col) const { return names_[col]; }
+    ColumnType columnType(size_t col) const { return types_[col]; }
+    int columnIndex(const std::string& name) const; // -1 if not present
+    int columnIndex(ColumnType type) const;         // First column of that type, -1 if not present
+
+    // First bar in [first, last) whose value in col is <= below or >= above,
+    // or last if there is none. Scans in fixed-size blocks so the compare
+    // loop vectorizes; NaN values never match.
+    size_t findCross(size_t col, size_t first, size_t last, double below, double above) const;
+
+    // Row-wise FNV-1a over timestamps and all columns of bars [first, last).
+    // Pass the previous result as seed to extend a prefix hash.
+    uint64_t hashRows(size_t first, size_t last, uint64_t seed) const;
+    uint64_t fingerprint() const; // hashRows over the whole series
+
+    // Copy of the first count bars (all of them when count >= size())
+    BarSeries head(size_t count) const;
+
+private:
+    std::vector<std::chrono::system_clock::time_point> timestamps_;
+    std::vector<std::vector<double>> columns_;
+    std::vector<std::string> names_;
+    std::vector<ColumnType> types_;
+};
+
+#endif // BARSERIES_H
@@ -0,0 +1,42 @@
+// BatchRandomStrategy.h
+#ifndef BATCHRANDOMSTRATEGY_H
+#define BATCHRANDOMSTRATEGY_H
+
+#include "BatchStrategy.h"
+#include <cstdint>
+#include <vector>
+
+// Lock-step version of RandomStrategy: random entries with fixed size and
+// TP/SL distances in price units. Swept parameters (per instance):
+//   /Strategy/ENTRY_PROBABILITY, /Strategy/BENCHMARK_FIXED_SIZE,
+//   /Strategy/TAKE_PROFIT_PIPS, /Strategy/STOP_LOSS_PIPS, /Strategy/SEED
+// Random draws come from a counter-based hash of (seed, bar), so instances
+// are independent and reproducible without per-instance generator state.
+// Without a SEED the stream is derived from the parameter set itself, so an
+// instance draws the same numbers whichever pass or chunk it runs in.
+class BatchRandomStrategy : public BatchStrategy {
+private:
+    const double* prices_ = nullptr;
+
+    // --- Parameters (SoA) ---
+    std::vector<double> entryProbability_;
+    std::vector<double> size_;
+    std::vector<double> takeProfit_;
+    std::vector<double> stopLoss_;
+    std::vector<uint64_t> seed_;
+
+    // --- State (SoA) ---
+    std::vector<double> entryRef_; // Price at the entry decision, TP/SL are measured from it
+
+public:
+    std::string getName() const override { return "BatchRandomStrategy"; }
+    void init(const std::vector<ParamSet>& params, const Config& config, const BarSeries& series) override;
+    void next(size_t barIndex, const double* positions, double* targets) override;
+    std::unique_ptr<BatchStrategy> clone() const override { return std::make_unique<BatchRandomStrategy>(); }
+    std::vector<std::string> getParamPaths() const override {
+        return {"/Strategy/ENTRY_PROBABILITY", "/Strategy/BENCHMARK_FIXED_SIZE", "/Strategy/TAKE_PROFIT_PIPS",
+                "/Strategy/STOP_LOSS_PIPS", "/Strategy/SEED"};
+    }
+};
+
+#endif // BATCHRANDOMSTRATEGY_H
@@ -0,0 +1,52 @@
+// BatchStrategy.h
+#ifndef BATCHSTRATEGY_H
+#define BATCHSTRATEGY_H
+
+#include "BarSeries.h"
+#include "json.hpp"
+#include "BuildInfo.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+
+class Config;
+
+// One point of a parameter sweep: JSON pointer path -> value, e.g.
+// {"/Strategy/ENTRY_PROBABILITY": 0.02}. Paths not present fall back to Config.
+using ParamSet = std::map<std::string, nlohmann::json>;
+
+// A strategy evaluated for many parameter sets at once in lock-step.
+// Implementations keep their state as struct-of-arrays (one contiguous
+// vector per field, one slot per instance) so each per-bar update is a
+// plain loop over instances that the compiler can vectorize.
+class BatchStrategy {
+public:
+    virtual ~BatchStrategy() = default;
+    virtual std::string getName() const = 0;
+    // Identifies the strategy code for the result cache (see Strategy::getBuildId)
+    virtual std::string getBuildId() const { return getName() + "@" + BuildInfo::buildId(); }
+
+    // Called once before the pass with the parameter set of every instance
+    virtual void init(const std::vector<ParamSet>& params, const Config& config, const BarSeries& series) = 0;
+
+    // Advance every instance by one bar. positions[k] is instance k's signed
+    // position after this bar's fills; write the desired signed position into
+    // targets[k]. Targets are filled at the next bar's price, like market
+    // orders submitted from Strategy::next.
+    virtual void next(size_t barIndex, const double* positions, double* targets) = 0;
+
+    // New, uninitialised instance, so parameter sets can be split across
+    // threads (nullptr: not supported, everything runs in one pass)
+    virtual std::unique_ptr<BatchStrategy> clone() const { return nullptr; }
+
+    // JSON pointer paths init() reads from a ParamSet; sweeps reject grid
+    // paths outside them (empty: not declared, nothing is checked)
+    virtual std::vector<std::string> getParamPaths() const { return {}; }
+
+protected:
+    // Parameter lookup with Config fallback
+    static double param(const ParamSet& params, const std::string& path, const Config& config, double defaultValue);
+};
+
+#endif // BATCHSTRATEGY_H
@@ -40,6 +40,9 @@ private:
     double entryPrice3_;
     int entryOrderId3_;
 
+    // Earliest fixed entry/exit bar after the given bar that is still to come
+    size_t nextEventBar(size_t afterBar) const;
+
 public:
     BenchmarkStrategy();
     virtual std::string getName() const override { return "BenchmarkStrategy"; }
@@ -48,6 +51,8 @@ public:
     void next(const Bar& currentBar, size_t currentBarIndex, const double currentPrice) override;
     void stop() override;
     void notifyOrder(const Order& order) override;
+    void saveState(BinaryWriter& writer) const override;
+    void loadState(BinaryReader& reader) override;
 };
 
 #endif // BENCHMARKSTRATEGY_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+// BinaryIO.h
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include "Order.h"
+#include "Position.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+// Little helpers for the engine's binary snapshots. Values are written in
+// native layout, so snapshots are only meant to be read back by the same
+// build on the same platform.
+class BinaryWriter {
+private:
+    std::ostream& out_;
+
+public:
+    explicit BinaryWriter(std::ostream& out) : out_(out) {}
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter::write needs a trivially copyable type");
+        writeBytes(&value, sizeof(T));
+    }
+    void writeSize(size_t value) { write(static_cast<uint64_t>(value)); }
+    void writeString(const std::string& value);
+    void writeTime(const std::chrono::system_clock::time_point& value);
+    void writeDoubles(const std::vector<double>& values);
+    void writeBytes(const void* data, size_t size);
+    bool good() const;
+};
+
+// Throws std::runtime_error on a short read, so a truncated snapshot never
+// restores half a state silently.
+class BinaryReader {
+private:
+    std::istream& in_;
+
+public:
+    explicit BinaryReader(std::istream& in) : in_(in) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "BinaryReader::read needs a trivially copyable type");
+        T value;
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+    size_t readSize() { return static_cast<size_t>(read<uint64_t>()); }
+    std::string readString();
+    std::chrono::system_clock::time_point readTime();
+    std::vector<double> readDoubles();
+    void readBytes(void* data, size_t size);
+};
+
+// --- Record Helpers ---
+void writeOrder(BinaryWriter& writer, const Order& order);
+Order readOrder(BinaryReader& reader);
+void writePosition(BinaryWriter& writer, const Position& position);
+Position readPosition(BinaryReader& reader);
+
+#endif // BINARYIO_H
@@ -5,14 +5,25 @@
 #include "Order.h"
 #include "Position.h"
 #include "Bar.h" // Needed for processOrders argument
+#include "SymbolRegistry.h"
+#include "OrderPool.h"
+#include "TradeLedger.h"
+#include "TriggerBook.h"
+#include "IntrabarModel.h"
+#include "CostModel.h"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <memory> // Maybe for future use, not strictly needed now
-#include <random> // For slippage generation
+#include <limits>
+#include <algorithm>
 
 // Forward declaration of Strategy class to break circular dependency
 class Strategy;
+class SimClock;
+class BinaryWriter;
+class BinaryReader;
 
 class Broker {
 private:
@@ -20,34 +31,190 @@ private:
     double cash;
     double leverage;
     double commissionRate; // Commission per unit traded (adjust if % based)
-    std::map<std::string, Position> positions; // Map symbol to open Position
-    std::vector<Order> pendingOrders;
-    std::vector<Order> orderHistory;
+    CommissionModel commissionModel; // PERCENT at commissionRate unless the engine sets another
+    SlippageModel slippage;          // Applied to MARKET and STOP fills (NONE by default)
+    // --- Per-symbol Tables (indexed by symbol id) ---
+    SymbolRegistry symbols;
+    std::vector<double> prices; // Latest price per symbol id (NaN before its first bar or fill)
+    // Running totals over a symbol's open positions
+    struct Holding {
+        int open = 0;          // Open positions (one per strategy)
+        double netSize = 0.0;  // Sum of signed sizes
+        double grossSize = 0.0;
+        double costBasis = 0.0;
+    };
+    std::vector<Holding> holdings;
+    // --- Position Tables (indexed by slot) ---
+    // Positions are netted per symbol and owning strategy, so strategies
+    // sharing a portfolio never close each other's positions. A slot is
+    // allocated per (symbol, strategyId) pair on its first fill.
+    std::vector<std::vector<int>> slotIds; // Symbol id -> slot per strategyId + 1 (-1 = none yet)
+    std::vector<Position> positions;       // Position per slot; only meaningful while open
+    std::vector<int> openIndex;            // Index into openPositions per slot, -1 when flat
+    std::vector<int> openPositions;        // Slots with an open position (unordered)
+    // --- Running Totals over open positions ---
+    // Kept up to date on fills and price updates, so account value is O(1)
+    // both at each symbol's latest price and with every symbol at one price
+    // (a single-instrument feed, as the engine runs).
+    double netSize;        // Sum of signed sizes
+    double grossSize;      // Sum of absolute sizes
+    double costBasis;      // Sum of entryPrice * size
+    double markedValue;    // Sum of size * latest price of the symbol
+    double markedExposure; // Sum of |size| * latest price of the symbol
+    int pricedSymbol;      // Symbol the bar being processed prices (-1 = every symbol)
+    std::vector<double> usedMargins; // Margin held by each shared strategy's positions, at entry prices
+    // --- Margin Monitoring ---
+    // Levels are equity as a percentage of the margin used by the open
+    // positions (0 = off). Below marginCallLevel new positions are refused;
+    // below maintenanceLevel positions are liquidated, largest first, until
+    // the level is restored.
+    double marginCallLevel;
+    double maintenanceLevel;
+    size_t liquidations; // Positions closed by liquidation
+    // --- Cash Dependence ---
+    // How far the run so far depends on the account's cash: every cash and
+    // margin check passed by at least cashHeadroom, and none failed unless
+    // cashBound. Less cash by up to the headroom, or more cash if not bound,
+    // would have given the same fills (segment-parallel runs rely on this).
+    double cashHeadroom;
+    bool cashBound;
+    // --- Fill Capacity ---
+    // Opening fills on a bar may take at most participationRate times its
+    // volume, shared by every order of the account; the rest of an order
+    // stays pending (partly filled, status ACCEPTED) for the next bars.
+    // Closing fills use up volume but are never capped.
+    double participationRate; // Fraction of bar volume (0 = unlimited)
+    int volumeColumn;         // Bar column holding traded volume (-1 = none)
+    double volumeLeft;        // Volume still available on the bar being processed
+    // --- Position Exits ---
+    // TP/SL levels of the open positions per symbol, keyed by level, so a
+    // bar only visits the levels its range crossed.
+    struct ExitRef {
+        int slot;
+        bool takeProfit; // false = stop loss
+    };
+    struct ExitIndex {
+        std::multimap<double, ExitRef> rising;                        // Long TPs and short SLs: hit when price >= level
+        std::multimap<double, ExitRef, std::greater<double>> falling; // Long SLs and short TPs: hit when price <= level
+        bool listed = false;                                          // In exitSymbols
+        bool empty() const { return rising.empty() && falling.empty(); }
+    };
+    std::vector<ExitIndex> exits;  // Per symbol id
+    std::vector<int> exitSymbols;  // Ids whose index is checked each bar (may have emptied since)
+    std::vector<ExitRef> exitsHit; // Exits reached by the current bar (reused)
+    OrderPool orderPool;                   // Storage for pending and resting orders
+    std::vector<OrderHandle> pendingOrders; // Handles into orderPool, in no particular order
+    // --- Resting Orders ---
+    std::vector<TriggerBook> books;                      // Limit/stop orders per symbol id
+    std::vector<int> bookSymbols;                        // Ids whose book is swept each bar (may have emptied since)
+    std::unordered_map<int, OrderHandle> restingOrders;  // Order id -> handle of every order sitting in a book
+    std::vector<OrderHandle> triggered;                  // Orders reached by the current sweep (reused)
+    TradeLedger orderHistory;
     int nextOrderId;
     Strategy* strategy; // Pointer to the strategy for notifications (non-owning)
-    std::mt19937 rng; // Random number generator for slippage
-    // std::uniform_real_distribution<double> slippageDist; // Distribution for slippage percentage
+    std::vector<Strategy*> strategies; // Strategies sharing this broker as a portfolio (non-owning), indexed by strategyId
+    std::vector<double> allocations; // Fraction of equity each shared strategy may commit as margin
+    int activeStrategyId; // Strategy currently submitting orders (-1 = primary strategy)
+    const SimClock* clock; // Engine's simulated clock (non-owning); orders are stamped with its time
+    IntrabarModel intrabar; // Bar columns and the path assumed inside each bar
 
     // --- Private Helpers ---
     double getFillPrice(const Bar& bar, OrderType orderType, double requestedPrice = 0.0) const;
     double calculateMarginNeeded(double size, double price) const;
-    double calculateCommission(double size, double price) const;
+    double calculateCommission(double size, double price) const { return commissionModel(size, price); }
+    // Fill price of a market-like fill of `quantity` units after slippage
+    double applySlippage(const Order& order, const Bar& bar, double price, double quantity) const {
+        if (!slippage.active()) return price;
+        const bool buy = order.type == OrderType::BUY;
+        return slippage.apply(price, buy, quantity, bar, SlippageModel::fillKey(bar.timestamp, order.symbolId, order.strategyId, buy));
+    }
     double getPointValue(const std::string& symbol) const; // Renamed from getPointValue
 
-    // NEW: Handles opening/increasing a position
-    void executeOpenOrder(Order& order, const Bar& executionBar);
+    // Fills (or rejects) an order at fillPrice, opening or closing as the position requires.
+    // With `slip` the fill is market-like: slippage is applied for the quantity actually filled.
+    void executeOrder(Order& order, const Bar& executionBar, double fillPrice, bool slip = false);
+
+    // NEW: Handles opening/increasing a position. With a participation rate
+    // it fills what the bar's volume allows and leaves the order live.
+    void executeOpenOrder(Order& order, const Bar& executionBar, double fillPrice, bool slip = false);
 
     // NEW: Handles closing/reducing/reversing a position
-    void executeCloseOrder(Order& order, Position& existingPosition, const Bar& executionBar);
+    void executeCloseOrder(Order& order, Position& existingPosition, const Bar& executionBar, double fillPrice, bool slip = false);
 
-    // Helper for handling rejected orders
+    // Helper for handling rejected orders. An order already partly filled is
+    // finished as FILLED at its filled size instead.
     void rejectOrder(Order& order, OrderStatus rejectionStatus, const Bar& executionBar);
 
-    // Check if positions hit take profit or stop loss levels
-    void checkTakeProfitStopLoss(const Bar& currentBar, const std::map<std::string, double>& currentPrices);
+    // Closes every position whose take profit or stop loss lies within [low, high]
+    // (positions in the priced symbol, or in every symbol).
+    // Given the start of the path leg (`from`), exits fill in the order the leg
+    // reaches them and a level the leg starts beyond fills at `from`; without
+    // it they fill at their level.
+    void checkTakeProfitStopLoss(const Bar& currentBar, double low, double high,
+                                 double from = std::numeric_limits<double>::quiet_NaN());
+    // Liquidates positions while equity is below the maintenance level
+    // anywhere in [low, high]. Given the start of the path leg (`from`), the
+    // fill is where the leg first breaches the level; without it, at `low`
+    // (= high).
+    void checkMargin(const Bar& currentBar, double low, double high,
+                     double from = std::numeric_limits<double>::quiet_NaN());
+    // Equity and used margin with the priced symbol (or every symbol) at
+    // `price` and the others at their latest prices
+    double valueAt(double price) const;
+    double usedMarginAt(double price) const;
+    // Equity above the maintenance requirement at the price. It is linear in
+    // price with this slope, so a price range is safe if both ends are.
+    double marginCushion(double price) const { return valueAt(price) - maintenanceLevel / 100.0 * usedMarginAt(price); }
+    double marginSlope() const;
+    // Price at which the cushion runs out (NaN if it does not depend on price)
+    double liquidationPrice() const;
+    // Adds/removes an open position's TP/SL to/from the exit index. Adding
+    // drops a stop loss on the wrong side of the entry price.
+    void indexExits(int slot);
+    void unindexExits(int slot);
+
+    // Interns the name and grows the per-symbol tables to cover its id
+    int ensureSymbol(const std::string& symbol);
+    // Slot of a strategy's position in a symbol, allocated on first use
+    int positionSlot(int symbolId, int strategyId);
+    // Same without allocating (-1 if the strategy never held the symbol)
+    int findSlot(int symbolId, int strategyId) const;
+    bool isOpen(int slot) const { return slot >= 0 && slot < static_cast<int>(openIndex.size()) && openIndex[slot] >= 0; }
+    // Adds/removes a slot to/from the open list (swap-remove, O(1)) and its exits to/from the index
+    void markOpen(int slot);
+    void markFlat(int slot);
+    // Adds (sign 1) or removes (sign -1) a position's share of the running totals
+    void trackPosition(const Position& position, double sign);
+    // Moves a symbol's latest price, and the marked totals with it
+    void markPrice(int symbolId, double price);
+    // Releases every pending and resting order back to the pool
+    void clearOrders();
+
+    // --- Resting Orders ---
+    // Level at which a limit/stop order is next reached, and whether the price must rise to it
+    static double triggerLevel(const Order& order, bool& rising);
+    // Fill price of a limit/stop order on a price path from `from` to `to`
+    // that passes every price in [low, high], or 0 if it does not execute.
+    // A STOP_LIMIT whose stop is reached is marked triggered and its limit is
+    // checked against the rest of the path only.
+    static double triggerFillPrice(Order& order, double from, double to, double low, double high);
+    // Puts an accepted order into its symbol's book
+    void restOrder(OrderHandle handle);
+    // Executes the resting orders reached on the path from `from` to `to`
+    // (NaN `from`: from each book's last price)
+    void sweepBooks(const Bar& currentBar, double from, double to);
+    // Fills or rests the pending orders that have arrived, at `price`
+    void processPending(const Bar& currentBar, double price);
+    // Whether the bar being processed prices the symbol
+    bool isPriced(int symbolId) const { return pricedSymbol < 0 || symbolId == pricedSymbol; }
 
-    // Apply random slippage to price
-    // double applySlippage(double basePrice, bool isFavorable);
+    // Route an order notification to the strategy that owns it (made the
+    // active strategy while it handles it)
+    void notifyStrategy(const Order& order);
+
+    // Margin an order's strategy may still commit at the price: cash, or on a
+    // shared broker its allocation of equity less what its positions hold
+    double getAvailableCash(int strategyId, double price) const;
 
 public:
     // Add a default constructor
@@ -57,29 +224,124 @@ public:
 
     // Set the strategy instance (called by engine)
     void setStrategy(Strategy* strat);
+    // Simulated clock for order timestamps and latency (called by engine).
+    // Without one, creation times stay unset and orders have no latency.
+    void setClock(const SimClock* simClock) { clock = simClock; }
+    // Bar columns and intrabar path (called by engine). With the default CLOSE
+    // path every bar is a single price; with OHLC/OLHC market orders fill at
+    // the open and exits and resting orders are checked along the bar's path.
+    void setIntrabarModel(const IntrabarModel& model) { intrabar = model; }
+    const IntrabarModel& getIntrabarModel() const { return intrabar; }
+    // Commission and slippage models (called by engine)
+    void setCostModels(const CommissionModel& commission, const SlippageModel& slip) {
+        commissionModel = commission;
+        slippage = slip;
+    }
+    // Caps opening fills at rate * the bar's volume column (called by engine; rate 0 = off)
+    void setParticipation(double rate, int column) {
+        participationRate = column >= 0 ? std::max(0.0, rate) : 0.0;
+        volumeColumn = column;
+    }
+    // Margin call and maintenance levels in percent of used margin (called by engine)
+    void setMarginLevels(double callLevel, double maintenance) {
+        marginCallLevel = std::max(0.0, callLevel);
+        maintenanceLevel = std::max(0.0, maintenance);
+    }
+
+    // --- Shared Portfolio ---
+    // Registers a strategy on a shared portfolio broker. Returns its strategyId;
+    // orders submitted while it is active are stamped with that id and their
+    // notifications are routed back to it. Each strategy's positions are
+    // netted per symbol separately from the others'.
+    int addStrategy(Strategy* strat, double allocation = 1.0);
+    // Unregisters every shared strategy and the primary one (called by engine before re-registering)
+    void clearStrategies();
+    // Selects the strategy whose orders are being submitted (called by engine)
+    void setActiveStrategy(int strategyId);
 
     // --- Account Info ---
     double getStartingCash() const;
     double getCash() const;
     double getValue(const std::map<std::string, double>& currentPrices); // Calculate total portfolio value
-    double getValue(const double currentPrices); // Calculate total portfolio value
+    // Cash plus unrealized P/L with every open position at the price (a
+    // single-instrument feed), O(1)
+    double getValue(const double currentPrices) const { return cash + getUnrealizedPnL(currentPrices); }
+    double getUnrealizedPnL(double price) const { return netSize * price - costBasis; }
+    double getExposure(double price) const { return grossSize * price; } // Gross notional of the open positions
+    double getUsedMargin(double price) const { return getExposure(price) / leverage; }
+    // The same with each position at its symbol's latest price, O(1)
+    double getValue() const { return cash + getUnrealizedPnL(); }
+    double getUnrealizedPnL() const { return markedValue - costBasis; }
+    double getExposure() const { return markedExposure; }
+    double getUsedMargin() const { return markedExposure / leverage; }
+    // Latest price of a symbol (NaN before its first bar or fill)
+    double getPrice(int symbolId) const {
+        return symbolId >= 0 && symbolId < static_cast<int>(prices.size()) ? prices[symbolId] : std::numeric_limits<double>::quiet_NaN();
+    }
+    size_t getLiquidations() const { return liquidations; }
+    double getCashHeadroom() const { return cashHeadroom; }
+    bool isCashBound() const { return cashBound; }
 
     // --- Order Management ---
     // Creates an order and adds it to pending queue. Returns the order ID.
     int submitOrder(Order order);
 
     // Processes pending orders based on the current market data bar.
-    // Notifies strategy of outcomes.
+    // Notifies strategy of outcomes. LIMIT/STOP/STOP_LIMIT orders that are not
+    // marketable on arrival rest in their symbol's book and are checked
+    // against the path from the previous bar's price to this one (or the
+    // bar's own open-high-low-close path with an intrabar model).
+    // The bar prices every symbol on the account (the engine's single feed).
     void processOrders(const Bar& currentBar);
+    // The same for a bar of one symbol (one feed per symbol): only its orders,
+    // resting orders and exits are processed, and margin is checked with the
+    // other symbols at their latest prices.
+    void processOrders(const Bar& currentBar, int symbolId);
+
+    // Cancels a pending or resting order (recorded in the history and
+    // notified). Returns false if the id is unknown or already done.
+    bool cancelOrder(int orderId);
+
+    // --- Symbols ---
+    // Dense id of a symbol on this broker (interned on first use). Setting
+    // Order::symbolId to it skips the name lookup on submit.
+    int getSymbolId(const std::string& symbol) { return ensureSymbol(symbol); }
+    const SymbolRegistry& getSymbols() const { return symbols; }
 
     // --- Position Info ---
-    const Position* getPosition(const std::string& symbol) const; // Get const pointer
-    const std::map<std::string, Position>& getAllPositions() const; // Get reference to all positions
+    // The active strategy's position (the only one on an unshared broker); nullptr when flat
+    const Position* getPosition(const std::string& symbol) const;
+    const Position* getPosition(int symbolId) const;
+    std::vector<Position> getAllPositions() const; // Copies of the open positions, for reporting
+    bool hasOpenPositions() const { return !openPositions.empty(); }
+    double getNetSize() const { return netSize; } // Sum of position sizes (value is linear in price with this slope)
+
+    // --- Fast-forward Support ---
+    bool hasPendingOrders() const { return !pendingOrders.empty(); }
+    bool hasRestingOrders() const { return !restingOrders.empty(); }
+    // Narrows [below, above] to the band inside which no open position's
+    // TP/SL, no resting order and no liquidation can trigger, i.e.
+    // processOrders(bar) would be a no-op (every symbol at the bar's price).
+    void getTriggerBand(double& below, double& above) const;
 
     // --- Configuration ---
 
     // --- History ---
-    const std::vector<Order>& getOrderHistory() const;
+    const TradeLedger& getOrderHistory() const;
+
+    // --- Checkpoint ---
+    // Cash, order ids, positions, pending and resting orders. The order history is
+    // kept in an append-only ledger by the engine and restored separately.
+    void saveState(BinaryWriter& writer) const;
+    void loadState(BinaryReader& reader);
+    void restoreOrderHistory(std::vector<Order> history);
+
+    // --- Segment-parallel Runs ---
+    // Continues this account with a later segment simulated on its own broker
+    // from the same starting cash: order history is appended with ids shifted
+    // past ours, positions, pending and resting orders are taken over and cash moves by
+    // the segment's net P/L. This account must be flat when called.
+    void appendSegment(const Broker& segment);
 };
 
 #endif // BROKER_H
\ No newline at end of file
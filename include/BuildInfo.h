@@ -0,0 +1,11 @@
+// BuildInfo.h
+#ifndef BUILDINFO_H
+#define BUILDINFO_H
+
+namespace BuildInfo {
+    // Regenerated by CMake on every build from the git revision; keys cached
+    // results to the code that produced them. "dev" outside a CMake build.
+    const char* buildId();
+}
+
+#endif // BUILDINFO_H
@@ -36,9 +36,16 @@ public:
     // --- Setter ---
     template <typename T>
     void set(const std::string& key, const T& value);
+    // Sets the value at a JSON pointer path like "/Strategy/EntryThreshold",
+    // creating missing objects on the way. Returns false for an invalid path.
+    bool setNested(const std::string& keyPath, const nlohmann::json& value);
 
     bool has(const std::string& key) const;
 
+    // Compact JSON of the whole config (keys sorted) minus the given top-level
+    // sections; used to fingerprint runs
+    std::string dump(const std::vector<std::string>& excludeSections = {}) const;
+
     // --- Explicit Template Instantiations ---
     // template <typename T>
     // template std::string Config::get<std::string>(const std::string& key, const std::string& defaultValue) const;
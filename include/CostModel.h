@@ -0,0 +1,223 @@
+// CostModel.h
+#ifndef COSTMODEL_H
+#define COSTMODEL_H
+
+#include "Bar.h"
+#include "BarSeries.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class Config;
+
+enum class CommissionKind {
+    PERCENT,    // rate percent of traded value (/Broker/COMMISSION_RATE)
+    PER_UNIT,   // rate per unit traded
+    TIERED,     // Percent rate chosen by the fill's traded value
+    MIN_TICKET  // PERCENT with a minimum fee per fill
+};
+
+enum class SlippageKind {
+    NONE,
+    FIXED_BPS,   // bps basis points of the price
+    SPREAD,      // factor * (ask - bid) of the bar
+    VOLATILITY,  // factor * (high - low) of the bar
+    SQRT_IMPACT  // factor * sigma * price * sqrt(size / bar volume)
+};
+
+// Volume discount of a TIERED commission: fills worth at least `notional` pay `rate` percent
+struct CommissionTier {
+    double notional;
+    double rate;
+};
+
+// Fee of one fill. Resolved once from config; evaluating it is a switch with no allocation or logging.
+struct CommissionModel {
+    CommissionKind kind = CommissionKind::PERCENT;
+    double rate = 0.0;                 // Percent of traded value (per unit for PER_UNIT; below the first tier for TIERED)
+    double minimum = 0.0;              // MIN_TICKET: smallest fee per fill
+    std::vector<CommissionTier> tiers; // TIERED: ascending notional thresholds
+
+    double operator()(double size, double price) const {
+        const double units = std::abs(size);
+        const double value = units * price;
+        switch (kind) {
+            case CommissionKind::PERCENT:
+                return value * (rate / 100.0);
+            case CommissionKind::PER_UNIT:
+                return units * rate;
+            case CommissionKind::TIERED: {
+                double tierRate = rate;
+                for (const CommissionTier& tier : tiers) {
+                    if (value < tier.notional) break;
+                    tierRate = tier.rate;
+                }
+                return value * (tierRate / 100.0);
+            }
+            case CommissionKind::MIN_TICKET:
+                return std::max(minimum, value * (rate / 100.0));
+        }
+        return 0.0;
+    }
+
+    // /Broker/COMMISSION_* settings; an unknown model is logged and PERCENT used
+    static CommissionModel fromConfig(const Config& config);
+
+    static bool parseKind(const std::string& name, CommissionKind& kind) {
+        if (name == "PERCENT") kind = CommissionKind::PERCENT;
+        else if (name == "PER_UNIT") kind = CommissionKind::PER_UNIT;
+        else if (name == "TIERED") kind = CommissionKind::TIERED;
+        else if (name == "MIN_TICKET") kind = CommissionKind::MIN_TICKET;
+        else return false;
+        return true;
+    }
+};
+
+// Price concession of a market or stop fill, always against the order. The
+// optional noise scales each cost by a uniform draw in [1 - noise, 1 + noise]
+// taken from a hash of the seed and the fill's bar, symbol and side rather
+// than a sequential generator, so it does not depend on how many fills came
+// before: parallel sweeps, segment-parallel and resumed runs all draw the
+// same values as a plain run.
+struct SlippageModel {
+    SlippageKind kind = SlippageKind::NONE;
+    double bps = 0.0;        // FIXED_BPS
+    double factor = 0.0;     // SPREAD, VOLATILITY, SQRT_IMPACT
+    double volatility = 0.0; // SQRT_IMPACT: sigma per bar (fraction of price) without High/Low columns
+    double noise = 0.0;
+    uint64_t seed = 0;
+    // Bar columns, from the loaded series (-1 = not present)
+    int bid = -1;
+    int ask = -1;
+    int high = -1;
+    int low = -1;
+    int volume = -1;
+
+    bool active() const { return kind != SlippageKind::NONE; }
+
+    void resolveColumns(const BarSeries& series) {
+        bid = series.columnIndex(ColumnType::Bid);
+        ask = series.columnIndex(ColumnType::Ask);
+        high = series.columnIndex(ColumnType::High);
+        low = series.columnIndex(ColumnType::Low);
+        volume = series.columnIndex(ColumnType::Volume);
+    }
+
+    // Fill price after slippage: buys pay up, sells receive less. `size` is
+    // the quantity of this fill and `key` identifies it for the noise draw.
+    // Columns the bar does not carry, or that are NaN, add no cost.
+    double apply(double price, bool buy, double size, const Bar& bar, uint64_t key) const {
+        return apply(price, buy, size, key, [&bar](int index) {
+            return (index >= 0 && index < static_cast<int>(bar.columns.size())) ? bar.columns[index]
+                                                                               : std::numeric_limits<double>::quiet_NaN();
+        });
+    }
+    // Same, for a fill on row `row` of a series (the columns resolved from it)
+    double apply(double price, bool buy, double size, const BarSeries& series, size_t row, uint64_t key) const {
+        return apply(price, buy, size, key, [&series, row](int index) {
+            return (index >= 0 && index < static_cast<int>(series.numColumns())) ? series.value(row, static_cast<size_t>(index))
+                                                                                 : std::numeric_limits<double>::quiet_NaN();
+        });
+    }
+
+    // Noise key of a fill: the same bar time, symbol, strategy and side give
+    // the same draw whatever ran before
+    static uint64_t fillKey(std::chrono::system_clock::time_point time, int symbolId, int strategyId, bool buy) {
+        uint64_t key = static_cast<uint64_t>(time.time_since_epoch().count());
+        key = key * 1000003 + static_cast<uint64_t>(symbolId);
+        key = key * 1000003 + static_cast<uint64_t>(strategyId + 1);
+        return key * 2 + (buy ? 1 : 0);
+    }
+
+    // Uniform [0, 1) from the seed and key (splitmix64 finaliser)
+    double uniform(uint64_t key) const {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (key + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // /Broker/SLIPPAGE_* settings (columns still to be resolved); an unknown model is logged and NONE used
+    static SlippageModel fromConfig(const Config& config);
+
+    static bool parseKind(const std::string& name, SlippageKind& kind) {
+        if (name == "NONE") kind = SlippageKind::NONE;
+        else if (name == "FIXED_BPS") kind = SlippageKind::FIXED_BPS;
+        else if (name == "SPREAD") kind = SlippageKind::SPREAD;
+        else if (name == "VOLATILITY") kind = SlippageKind::VOLATILITY;
+        else if (name == "SQRT_IMPACT") kind = SlippageKind::SQRT_IMPACT;
+        else return false;
+        return true;
+    }
+
+private:
+    // `column(index)` reads a bar column, NaN when absent
+    template <class Column>
+    double apply(double price, bool buy, double size, uint64_t key, Column column) const {
+        double cost = 0.0;
+        switch (kind) {
+            case SlippageKind::NONE:
+                return price;
+            case SlippageKind::FIXED_BPS:
+                cost = price * bps / 10000.0;
+                break;
+            case SlippageKind::SPREAD:
+                cost = factor * (column(ask) - column(bid));
+                break;
+            case SlippageKind::VOLATILITY:
+                cost = factor * (column(high) - column(low));
+                break;
+            case SlippageKind::SQRT_IMPACT: {
+                const double range = column(high) - column(low);
+                const double sigma = (!std::isnan(range) && price > 0.0) ? range / price : volatility;
+                const double traded = column(volume);
+                if (traded > 0.0) cost = factor * sigma * price * std::sqrt(std::abs(size) / traded);
+                break;
+            }
+        }
+        if (std::isnan(cost)) return price;
+        if (noise > 0.0) cost *= 1.0 + noise * (2.0 * uniform(key) - 1.0);
+        cost = std::max(cost, 0.0);
+        return buy ? price + cost : price - cost;
+    }
+};
+
+// Costs of moving a position in the series' symbol from `from` to `to` units
+// with market fills at `price` on row `row`, split into fills the way the
+// broker makes them: a position flattened or reversed is closed in full and
+// the new side opened, a resize on the same side is one fill of the
+// difference. Commission is charged on the slipped price; noise draws are
+// those of the first symbol of a single-strategy run.
+struct RebalanceCost {
+    double commission = 0.0;
+    double slippage = 0.0; // Price concession times size, summed over the fills
+
+    RebalanceCost(const CommissionModel& commissionModel, const SlippageModel& slippageModel,
+                  const BarSeries& series, size_t row, double price, double from, double to) {
+        auto fill = [&](double units) {
+            const bool buy = units > 0.0;
+            const double size = std::abs(units);
+            double fillPrice = price;
+            if (slippageModel.active()) {
+                const uint64_t key = SlippageModel::fillKey(series.timestamps()[row], 0, -1, buy);
+                fillPrice = slippageModel.apply(price, buy, size, series, row, key);
+            }
+            commission += commissionModel(size, fillPrice);
+            slippage += std::abs(fillPrice - price) * size;
+        };
+        if (from == to) return;
+        if (from != 0.0 && (to == 0.0 || (to > 0.0) != (from > 0.0))) {
+            fill(-from);
+            if (to != 0.0) fill(to);
+        } else {
+            fill(to - from);
+        }
+    }
+};
+
+#endif // COSTMODEL_H
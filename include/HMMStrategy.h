@@ -20,18 +20,25 @@ protected:
     int n_components_;
     float lastPrediction_;
     double trailStopPrice_;
-    std::vector<Bar> barHistory_;  // Store recent bars for sequence-based prediction
-    std::vector<Bar> allBarHistory_;  // Complete bar history for global predictions
     std::map<int, double> regimeVolatility_; // Store volatility levels for each regime
 
     std::unique_ptr<TradingMetrics> metrics;
+
+    static constexpr size_t MIN_HISTORY = 30;  // Bars before the first prediction
+    static constexpr size_t WINDOW_SIZE = 100; // Look-back window fed to the HMM
+    static constexpr size_t NUM_FEATURES = 4;  // Leading data columns used as model features
+    static constexpr size_t CLOSE_COLUMN = 3;  // Close price within the feature columns
 public:
     HMMStrategy();
     std::string getName() const override;
+    size_t getWarmupBars() const override { return MIN_HISTORY; }
     void init() override;
     void next(const Bar& currentBar, size_t currentBarIndex, const double currentPrice) override;
     void stop() override;
     void notifyOrder(const Order& order) override;
+    // Models are rebuilt by init(); only trading state is checkpointed
+    void saveState(BinaryWriter& writer) const override;
+    void loadState(BinaryReader& reader) override;
 
 protected:
     /**
@@ -0,0 +1,84 @@
+// IntrabarModel.h
+#ifndef INTRABARMODEL_H
+#define INTRABARMODEL_H
+
+#include "Bar.h"
+#include "BarSeries.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+// Order in which a bar is assumed to have visited its extremes
+enum class IntrabarPath {
+    CLOSE, // Bars are single prices (BarSeries::PRICE_COLUMN); nothing is simulated inside them
+    OHLC,  // Open, high, low, close
+    OLHC   // Open, low, high, close
+};
+
+// One straight leg of a bar's assumed path; it passes every price between its ends
+struct PathLeg {
+    double from;
+    double to;
+    double low() const { return std::min(from, to); }
+    double high() const { return std::max(from, to); }
+};
+
+// Where a bar's open/high/low/close sit in Bar::columns (taken from the
+// ColumnSpec types of the loaded series) and the path assumed through them.
+// A bar starts at its open, so a gap since the previous bar is not traded
+// through: levels inside the gap are reached at the open. The engine and
+// strategies mark at BarSeries::PRICE_COLUMN, so a path is only built when
+// the Close column is that one; otherwise its last leg would end at a price
+// the rest of the run never sees.
+struct IntrabarModel {
+    IntrabarPath path = IntrabarPath::CLOSE;
+    int open = -1;
+    int high = -1;
+    int low = -1;
+    int close = static_cast<int>(BarSeries::PRICE_COLUMN);
+
+    bool active() const { return path != IntrabarPath::CLOSE; }
+
+    // Falls back to CLOSE when the series lacks an Open, High, Low or Close
+    // column, or its Close column is not PRICE_COLUMN (see closeMarked)
+    static IntrabarModel fromSeries(const BarSeries& series, IntrabarPath path) {
+        IntrabarModel model;
+        model.open = series.columnIndex(ColumnType::Open);
+        model.high = series.columnIndex(ColumnType::High);
+        model.low = series.columnIndex(ColumnType::Low);
+        const int close = series.columnIndex(ColumnType::Close);
+        if (model.open >= 0 && model.high >= 0 && model.low >= 0 && close >= 0 && closeMarked(series)) {
+            model.close = close;
+            model.path = path;
+        }
+        return model;
+    }
+
+    // Whether the series' Close column is the one prices are marked at
+    static bool closeMarked(const BarSeries& series) {
+        return series.columnIndex(ColumnType::Close) == static_cast<int>(BarSeries::PRICE_COLUMN);
+    }
+
+    static bool parsePath(const std::string& name, IntrabarPath& path) {
+        if (name == "CLOSE") path = IntrabarPath::CLOSE;
+        else if (name == "OHLC") path = IntrabarPath::OHLC;
+        else if (name == "OLHC") path = IntrabarPath::OLHC;
+        else return false;
+        return true;
+    }
+
+    double openPrice(const Bar& bar) const { return bar.columns[active() ? open : close]; }
+
+    // The bar's three legs in path order (active models only)
+    void legs(const Bar& bar, PathLeg out[3]) const {
+        const double o = bar.columns[open];
+        const double c = bar.columns[close];
+        const double first = bar.columns[path == IntrabarPath::OHLC ? high : low];
+        const double second = bar.columns[path == IntrabarPath::OHLC ? low : high];
+        out[0] = PathLeg{o, first};
+        out[1] = PathLeg{first, second};
+        out[2] = PathLeg{second, c};
+    }
+};
+
+#endif // INTRABARMODEL_H
@@ -0,0 +1,79 @@
+// MarketFeed.h
+#ifndef MARKETFEED_H
+#define MARKETFEED_H
+
+#include "Span.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum class BookSide : uint8_t {
+    BID = 0,
+    ASK = 1
+};
+
+enum class UpdateAction : uint8_t {
+    LEVEL, // L2: displayed size at price on side (0 removes the level)
+    TOP,   // L1: the side now shows only this level
+    TRADE, // Print of size at price; side is the aggressor (BID = a buyer lifted the offer)
+    CLEAR  // Both sides emptied (snapshot or session boundary)
+};
+
+// One record of a replay feed. Fixed size with prices in integer ticks, so a
+// block of records is read straight into memory with no parsing.
+struct BookUpdate {
+    int64_t time = 0;   // Nanoseconds since the epoch
+    double size = 0.0;
+    int32_t price = 0;  // Ticks (price / tick size)
+    uint16_t symbol = 0; // Index into the feed's symbol table
+    BookSide side = BookSide::BID;
+    UpdateAction action = UpdateAction::LEVEL;
+};
+static_assert(sizeof(BookUpdate) == 24, "BookUpdate is a 24-byte feed record");
+
+// Reads a recorded feed: a header (magic, version, tick size, symbol names,
+// record count) followed by BookUpdate records in time order. Records are
+// read in blocks into a reusable buffer, so memory use stays flat however
+// long the feed is.
+class MarketFeed {
+private:
+    std::ifstream in_;
+    double tickSize_ = 0.0;
+    std::vector<std::string> symbols_;
+    uint64_t count_ = 0;
+    uint64_t read_ = 0;
+    std::vector<BookUpdate> buffer_;
+
+public:
+    static constexpr size_t BLOCK_RECORDS = 1 << 16;
+
+    // Logs and returns false if the file is missing or not a compatible feed
+    bool open(const std::string& path);
+    // Next block of records, empty at the end of the feed. Valid until the next call.
+    Span<BookUpdate> nextBlock();
+
+    double tickSize() const { return tickSize_; }
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    uint64_t count() const { return count_; }
+};
+
+// Writes a feed file. Records are buffered and the record count in the header
+// is filled in by close().
+class FeedWriter {
+private:
+    std::ofstream out_;
+    std::streampos countPos_;
+    uint64_t count_ = 0;
+    std::vector<BookUpdate> buffer_;
+
+    void flush();
+
+public:
+    bool open(const std::string& path, double tickSize, const std::vector<std::string>& symbols);
+    void write(const BookUpdate& update);
+    bool close();
+    ~FeedWriter();
+};
+
+#endif // MARKETFEED_H
@@ -0,0 +1,100 @@
+// MatchingEngine.h
+#ifndef MATCHINGENGINE_H
+#define MATCHINGENGINE_H
+
+#include "Order.h"
+#include "CostModel.h"
+#include "OrderBook.h"
+#include "OrderPool.h"
+#include "MarketFeed.h"
+#include "SymbolRegistry.h"
+#include "TradeLedger.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MatchingEngine;
+
+// Receives replay events. Orders may be submitted and cancelled from inside
+// either callback; they reach the book once the order latency has passed.
+class ReplayListener {
+public:
+    virtual ~ReplayListener() = default;
+    // After every feed record has been applied to its symbol's book
+    virtual void onBook(MatchingEngine& /*engine*/, int /*symbolId*/, const BookUpdate& /*update*/) {}
+    // Every fill (partial fills keep status ACCEPTED), cancellation and rejection
+    virtual void onOrder(const Order& /*order*/) {}
+};
+
+// Tick-level alternative to Broker for quote-driven markets: replays a
+// recorded L1/L2 feed and matches our orders against the displayed
+// liquidity. MARKET orders and marketable LIMIT orders take liquidity level
+// by level (an unfilled MARKET remainder is cancelled); the rest of a LIMIT
+// order rests in the book in price-time priority behind the size displayed
+// at its price. Positions are netted per symbol and cash moves by each
+// fill's notional and commission; there are no margin checks.
+class MatchingEngine {
+private:
+    double startingCash_;
+    double cash_;
+    CommissionModel commission_; // PERCENT at the constructor's rate unless set
+    int64_t latency_ = 0;   // Nanoseconds from submission until an order reaches the book
+    int64_t now_ = 0;       // Time of the last feed record (ns since the epoch)
+    SymbolRegistry symbols_;
+    std::vector<OrderBook> books_;   // Per symbol id
+    std::vector<double> netSizes_;   // Signed position per symbol id
+    OrderPool orderPool_;
+    std::vector<OrderHandle> inFlight_; // Submitted, not yet at the book (arrival order)
+    size_t inFlightHead_ = 0;
+    std::unordered_map<int, OrderHandle> restingOrders_; // Order id -> handle of orders in a book
+    std::vector<BookFill> fills_; // Fills of the record being applied (reused)
+    TradeLedger orderHistory_;
+    int nextOrderId_ = 1;
+    ReplayListener* listener_ = nullptr;
+
+    int ensureSymbol(const std::string& symbol);
+    // Brings submitted orders whose latency has passed to their books
+    void activateArrived();
+    void activate(OrderHandle handle);
+    // Books one fill of an order and notifies; returns true once the order is done
+    bool settle(Order& order, double price, double size);
+    // Records a finished order and releases its slot
+    void finish(OrderHandle handle);
+    void notify(const Order& order);
+
+public:
+    MatchingEngine(double initialCash, double commissionRate);
+
+    void setListener(ReplayListener* listener) { listener_ = listener; }
+    void setLatency(int64_t nanoseconds) { latency_ = nanoseconds < 0 ? 0 : nanoseconds; }
+    void setCommissionModel(const CommissionModel& commission) { commission_ = commission; }
+
+    // Replays every record of the feed. Returns the number of records applied.
+    uint64_t replay(MarketFeed& feed);
+    // Applies one record to an open symbol's book (replay() calls this per record)
+    void apply(int symbolId, const BookUpdate& update);
+    // Uses the tick size for a symbol's book (replay() sets it from the feed)
+    void setTickSize(int symbolId, double tickSize) { books_[symbolId].setTickSize(tickSize); }
+
+    // --- Orders ---
+    // Queues a MARKET or LIMIT order (requestedPrice = limit). Returns its id.
+    int submitOrder(Order order);
+    // Cancels an order in flight or resting; false if unknown or already done
+    bool cancelOrder(int orderId);
+    bool hasLiveOrders() const { return orderPool_.size() > 0; }
+
+    // --- State ---
+    int getSymbolId(const std::string& symbol) { return ensureSymbol(symbol); }
+    const SymbolRegistry& getSymbols() const { return symbols_; }
+    const OrderBook& getBook(int symbolId) const { return books_[symbolId]; }
+    double getNetSize(int symbolId) const { return netSizes_[symbolId]; }
+    double getStartingCash() const { return startingCash_; }
+    double getCash() const { return cash_; }
+    // Cash plus every position marked at its book's mid price
+    double getValue() const;
+    int64_t now() const { return now_; }
+    const TradeLedger& getOrderHistory() const { return orderHistory_; }
+};
+
+#endif // MATCHINGENGINE_H
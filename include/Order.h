@@ -11,6 +11,13 @@ enum class OrderType {
     SELL
 };
 
+enum class OrderKind {
+    MARKET,     // Fills at the bar price once it reaches the broker
+    LIMIT,      // Rests until the price reaches requestedPrice (or better)
+    STOP,       // Rests until the price reaches stopPrice, then fills there
+    STOP_LIMIT  // Becomes a LIMIT at requestedPrice once the price reaches stopPrice
+};
+
 enum class OrderStatus {
     CREATED,    // Initial state before broker processing
     SUBMITTED,  // Handed to broker simulation
@@ -35,19 +42,26 @@ enum class OrderReason {
 struct Order {
     int id = -1; // Unique ID assigned by Broker
     OrderType type = OrderType::BUY;
+    OrderKind kind = OrderKind::MARKET;
     OrderStatus status = OrderStatus::CREATED;
     OrderReason reason = OrderReason::ENTRY_SIGNAL; // Default reason
     std::string symbol = "";          // e.g., "USDJPY", "BTCUSDT"
+    int symbolId = -1;                // Broker's interned id for symbol (assigned on submit if unset)
     double requestedSize = 0.0;       // Absolute value of units/shares requested
     double filledSize = 0.0;          // Actual size filled (can differ in reality)
-    double requestedPrice = 0.0;      // For Limit/Stop orders (0.0 for Market)
+    double requestedPrice = 0.0;      // Limit price of LIMIT/STOP_LIMIT orders (forces the fill price of a MARKET order if > 0)
+    double stopPrice = 0.0;           // Trigger price of STOP/STOP_LIMIT orders
+    bool stopTriggered = false;       // STOP_LIMIT: stop reached, now resting as a limit
     double filledPrice = 0.0;         // Average price at which the order was filled
     double commission = 0.0;          // Commission charged for this order execution
+    double realizedPnL = 0.0;         // P/L realized by a closing fill, before commission
     double takeProfit = 0.0;          // Price at which to take profit (0.0 if not set)
     double stopLoss = 0.0;            // Price at which to stop loss (0.0 if not set)
     std::chrono::system_clock::time_point creationTime{};
     std::chrono::system_clock::time_point executionTime{};
-    // int strategyId = -1; // Optional: If multiple strategies run concurrently
+    int strategyId = -1;              // Owning strategy on a shared portfolio broker (-1 = primary strategy)
+
+    bool isResting() const { return kind != OrderKind::MARKET; }
 
     // Helper to check if order is in a final state
     bool isClosed() const {
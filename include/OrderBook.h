@@ -0,0 +1,90 @@
+// OrderBook.h
+#ifndef ORDERBOOK_H
+#define ORDERBOOK_H
+
+#include "MarketFeed.h"
+#include "OrderPool.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// A fill of one of our orders produced by the book
+struct BookFill {
+    OrderHandle handle;
+    int32_t price;   // Ticks
+    double size;
+    bool maker;      // Resting order filled by the market (false = we took liquidity)
+};
+
+// One symbol's replayed depth plus our own resting limit orders. Displayed
+// size is kept in two flat arrays indexed by price tick from a moving base,
+// so a level update is an array store and the best price moves by a short
+// scan. Our orders queue behind the size displayed at their price when they
+// joined and fill in price-time priority: trades at the level work off the
+// queue ahead first, trades through the level or a crossing quote fill them.
+class OrderBook {
+public:
+    static constexpr int32_t NO_PRICE = std::numeric_limits<int32_t>::min();
+
+private:
+    struct OwnOrder {
+        OrderHandle handle;
+        int id;            // Arrival order among orders at the same price
+        int32_t price;     // Ticks
+        double remaining;
+        double queueAhead; // Displayed size that trades before us
+    };
+
+    static constexpr size_t INITIAL_LEVELS = 4096;
+    static constexpr size_t MAX_LEVELS = size_t{1} << 22; // Per side; wider jumps are dropped
+
+    double tickSize_;
+    int32_t base_ = 0;          // Tick of array index 0
+    std::vector<double> bids_;  // Displayed size per tick (0 = no level)
+    std::vector<double> asks_;
+    int bestBid_ = -1;          // Array index, -1 when the side is empty
+    int bestAsk_ = -1;
+    size_t bidLevels_ = 0;      // Non-empty levels per side
+    size_t askLevels_ = 0;
+    std::vector<OwnOrder> ownBids_; // Best price first, then arrival
+    std::vector<OwnOrder> ownAsks_;
+
+    // Array index of a tick, growing the window to cover it (-1 if out of range)
+    int indexOf(int32_t tick);
+    void setLevel(BookSide side, int index, double size);
+    void clearSide(BookSide side);
+    // Fills our orders on `side` that the trade or the opposite quote reached
+    void matchOwn(BookSide side, int32_t tradePrice, double tradeSize, std::vector<BookFill>& fills);
+
+public:
+    explicit OrderBook(double tickSize = 0.0) : tickSize_(tickSize) {}
+
+    // Applies one feed record and appends the fills of our orders it caused
+    void apply(const BookUpdate& update, std::vector<BookFill>& fills);
+
+    // Takes displayed liquidity opposite `side` up to `size`, best price first
+    // and no worse than limit (ticks). Returns the size filled; `notional`
+    // receives the sum of price (ticks) * size.
+    double take(BookSide side, double size, int32_t limit, double& notional);
+    // Rests one of our limit orders behind the size currently displayed at its price
+    void rest(OrderHandle handle, int id, BookSide side, int32_t price, double size);
+    // Removes one of our resting orders; false if it is not in the book
+    bool cancel(OrderHandle handle);
+    bool hasOwnOrders() const { return !ownBids_.empty() || !ownAsks_.empty(); }
+
+    // --- Prices ---
+    double tickSize() const { return tickSize_; }
+    void setTickSize(double tickSize) { tickSize_ = tickSize; }
+    double toPrice(int32_t tick) const { return tick * tickSize_; }
+    int32_t toTick(double price) const;
+    int32_t bestBid() const { return bestBid_ < 0 ? NO_PRICE : base_ + bestBid_; }
+    int32_t bestAsk() const { return bestAsk_ < 0 ? NO_PRICE : base_ + bestAsk_; }
+    double bidSize() const { return bestBid_ < 0 ? 0.0 : bids_[bestBid_]; }
+    double askSize() const { return bestAsk_ < 0 ? 0.0 : asks_[bestAsk_]; }
+    // Displayed size at a tick (0 outside the window)
+    double sizeAt(BookSide side, int32_t tick) const;
+    // Mid of the best quotes, the one quoted side, or 0 for an empty book
+    double midPrice() const;
+};
+
+#endif // ORDERBOOK_H
@@ -0,0 +1,70 @@
+// OrderPool.h
+#ifndef ORDERPOOL_H
+#define ORDERPOOL_H
+
+#include "Order.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using OrderHandle = uint32_t;
+
+// Slab storage for live orders. Slots are allocated in fixed-size chunks that
+// never move, so both handles and references stay valid until the order is
+// released, even if the pool grows in between (e.g. a strategy submitting
+// from inside notifyOrder). Released slots are reused first, so a strategy
+// with a bounded number of orders in flight stops allocating after warm-up.
+class OrderPool {
+public:
+    static constexpr OrderHandle INVALID_HANDLE = 0xFFFFFFFFu;
+
+private:
+    static constexpr size_t CHUNK_BITS = 8;
+    static constexpr size_t CHUNK_SIZE = size_t{1} << CHUNK_BITS;
+
+    std::vector<std::unique_ptr<Order[]>> chunks_;
+    std::vector<OrderHandle> free_;
+    size_t capacity_ = 0;
+    size_t live_ = 0;
+
+    void grow() {
+        chunks_.emplace_back(new Order[CHUNK_SIZE]);
+        free_.reserve(capacity_ + CHUNK_SIZE);
+        // Pushed in reverse so the lowest handle is handed out first
+        for (size_t k = CHUNK_SIZE; k-- > 0;) {
+            free_.push_back(static_cast<OrderHandle>(capacity_ + k));
+        }
+        capacity_ += CHUNK_SIZE;
+    }
+
+public:
+    explicit OrderPool(size_t capacity = CHUNK_SIZE) {
+        while (capacity_ < capacity) grow();
+    }
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    // Moves the order into a free slot
+    OrderHandle acquire(Order order) {
+        if (free_.empty()) grow();
+        const OrderHandle handle = free_.back();
+        free_.pop_back();
+        (*this)[handle] = std::move(order);
+        live_++;
+        return handle;
+    }
+
+    // The slot keeps its contents (and string capacity) until it is reused
+    void release(OrderHandle handle) {
+        free_.push_back(handle);
+        live_--;
+    }
+
+    Order& operator[](OrderHandle handle) { return chunks_[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+    const Order& operator[](OrderHandle handle) const { return chunks_[handle >> CHUNK_BITS][handle & (CHUNK_SIZE - 1)]; }
+
+    size_t size() const { return live_; }
+    size_t capacity() const { return capacity_; }
+};
+
+#endif // ORDERPOOL_H
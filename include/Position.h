@@ -8,12 +8,14 @@
 
 struct Position {
     std::string symbol = "";
+    int symbolId = -1;          // Broker's interned id for symbol
     double size = 0.0;          // Positive for long, negative for short
     double entryPrice = 0.0;
     double lastValue = 0.0;
     double pointValue = 1;
     double stopLoss = 0.0;
     double takeProfit = 0.0;
+    int strategyId = -1;        // Strategy that opened the position (shared portfolio broker)
     std::chrono::system_clock::time_point entryTime{};
 
     // Calculates unrealized Profit/Loss for the position at the given current price
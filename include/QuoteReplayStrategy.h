@@ -0,0 +1,40 @@
+// QuoteReplayStrategy.h
+#ifndef QUOTEREPLAYSTRATEGY_H
+#define QUOTEREPLAYSTRATEGY_H
+
+#include "ReplayStrategy.h"
+#include <cstdint>
+#include <vector>
+
+// Passive quoting on a replayed book: keeps one bid and one ask limit order
+// of /Replay/QUOTE_SIZE at the touch of every symbol, each queued behind the
+// size displayed there. A quote is replaced once the touch has moved more
+// than /Replay/REQUOTE_TICKS away from it; a side is not quoted while a fill
+// there would take the position beyond /Replay/MAX_POSITION.
+class QuoteReplayStrategy : public ReplayStrategy {
+private:
+    struct Quote {
+        int orderId = -1; // -1 = not quoting this side
+        int32_t tick = OrderBook::NO_PRICE;
+    };
+    struct SymbolQuotes {
+        Quote bid;
+        Quote ask;
+    };
+
+    double size_ = 1.0;
+    double maxPosition_ = 5.0;
+    int32_t requoteTicks_ = 2;
+    std::vector<SymbolQuotes> quotes_; // Per symbol id
+
+    // Keeps one side's quote at the touch (or pulls it when not allowed)
+    void refresh(int symbolId, Quote& quote, OrderType type, int32_t touch, bool allowed);
+
+public:
+    std::string getName() const override { return "QuoteReplayStrategy"; }
+    void init(const Config& config, MatchingEngine& matching) override;
+    void onBook(MatchingEngine& matching, int symbolId, const BookUpdate& update) override;
+    void onOrder(const Order& order) override;
+};
+
+#endif // QUOTEREPLAYSTRATEGY_H
@@ -8,6 +8,7 @@
 #include "TradingMetrics.h"
 #include <random>
 #include <memory>
+#include <limits>
 
 class RandomStrategy : public Strategy {
 private:
@@ -23,18 +24,26 @@ private:
     bool inPosition = false;
     int currentOrderId = -1;
     double entryPrice_;  // store entry fill price for profit check
+    static constexpr size_t NO_BAR = std::numeric_limits<size_t>::max();
+    size_t nextEntryBar = NO_BAR;   // Bar of the next scheduled entry (NO_BAR = draw one)
+    size_t lastMetricsBar = NO_BAR; // Bar of the last portfolio value sample
     
     // --- Metrics Tracking ---
     std::unique_ptr<TradingMetrics> metrics;
     
     // --- Random Number Generation ---
     std::mt19937 rng;
-    std::uniform_real_distribution<double> probDist;   // For entry probability
+    std::geometric_distribution<long long> gapDist;    // Bars until the next entry
     std::uniform_int_distribution<int> directionDist;  // For long/short decision
 
+    // Draws the next entry bar at or after fromBar (NO_BAR if entries are disabled)
+    size_t drawEntryBar(size_t fromBar);
+
 public:
     RandomStrategy();
     virtual std::string getName() const override { return "RandomStrategy"; };
+    // Only with a fixed /Strategy/RANDOM_SEED
+    bool isDeterministic(const Config& config) const override { return config.getNested<int>("/Strategy/RANDOM_SEED", 0) != 0; }
     
     // --- Overridden Lifecycle Methods ---
     void init() override;
@@ -42,6 +51,8 @@ public:
     void next(const Bar& currentBar, size_t currentBarIndex, const double currentPrices) override;
     void stop() override;
     void notifyOrder(const Order& order) override;
+    void saveState(BinaryWriter& writer) const override;
+    void loadState(BinaryReader& reader) override;
 };
 
 #endif // RANDOMSTRATEGY_H
@@ -0,0 +1,39 @@
+// ReplayStrategy.h
+#ifndef REPLAYSTRATEGY_H
+#define REPLAYSTRATEGY_H
+
+#include "MatchingEngine.h"
+#include <string>
+
+class Config;
+
+// A strategy driven by a tick-level replay instead of bars: it receives the
+// MatchingEngine's book and order callbacks and trades through the helpers
+// below, the replay counterpart of Strategy's broker calls. Orders reach the
+// book after the engine's order latency.
+class ReplayStrategy : public ReplayListener {
+protected:
+    MatchingEngine* engine; // Non-owning, set by init()
+
+    // --- Orders ---
+    // Return the order id (-1 before init())
+    int buy(int symbolId, double size);
+    int sell(int symbolId, double size);
+    int buyLimit(int symbolId, double size, double price);
+    int sellLimit(int symbolId, double size, double price);
+    bool cancel(int orderId);
+
+public:
+    ReplayStrategy() : engine(nullptr) {}
+    virtual std::string getName() const = 0;
+    // Called once before the first record; the feed's symbols are already
+    // interned in the engine (ids 0..n-1 in the feed's order)
+    virtual void init(const Config& /*config*/, MatchingEngine& matching) { engine = &matching; }
+    // Called once after the last record
+    virtual void stop() {}
+
+private:
+    int submit(int symbolId, OrderType type, OrderKind kind, double size, double price);
+};
+
+#endif // REPLAYSTRATEGY_H
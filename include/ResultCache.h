@@ -0,0 +1,32 @@
+// ResultCache.h
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "RunResult.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Content-addressed store of finished runs on local disk: one file per key
+// under the cache directory. Keys hash everything a result depends on
+// (config subtree, data fingerprint, strategy build IDs), so an entry is
+// never invalidated, only superseded by a different key.
+class ResultCache {
+private:
+    std::string dir_;
+
+    std::string entryPath(uint64_t key) const;
+
+public:
+    explicit ResultCache(const std::string& dir);
+
+    static uint64_t makeKey(const std::string& configDump, uint64_t dataFingerprint,
+                            const std::vector<std::string>& buildIds);
+
+    // Returns false on a miss or an unreadable entry
+    bool load(uint64_t key, RunResult& result) const;
+    // Writes atomically (tmp file + rename); failures are logged, not thrown
+    bool store(uint64_t key, const RunResult& result) const;
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,23 @@
+// RunResult.h
+#ifndef RUNRESULT_H
+#define RUNRESULT_H
+
+#include "Order.h"
+#include <vector>
+#include <string>
+
+// Outcome of one finished backtest, as stored in the result cache
+struct RunResult {
+    double finalValue = 0.0;
+    int trades = 0;            // Closing fills
+    int profitableTrades = 0;  // Closing fills with positive realized P/L
+    double commission = 0.0;
+    double maxDrawdown = 0.0;  // Percent, same convention as TradingMetrics
+    std::vector<double> equityCurve;
+    std::vector<Order> tradeLog; // Filled and rejected orders of every account
+    std::vector<size_t> accountOrders; // Rows of tradeLog per account, in account order
+    bool fromCache = false;
+    std::string stopReason;    // Why the run stopped early (empty = ran to the last bar); never cached
+};
+
+#endif // RUNRESULT_H
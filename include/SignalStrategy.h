@@ -0,0 +1,34 @@
+// SignalStrategy.h
+#ifndef SIGNALSTRATEGY_H
+#define SIGNALSTRATEGY_H
+
+#include "Strategy.h"
+#include "TradingMetrics.h"
+#include <memory>
+
+// Event-driven twin of VectorizedBacktest: each bar, trades towards
+// SIZE * signal with market orders (close, then open on a reversal).
+// Parameters: /Vectorized/SIGNAL_COLUMN, /Vectorized/SIZE.
+class SignalStrategy : public Strategy {
+private:
+    std::string signalColumn_;
+    double size_ = 1.0;
+    int symbolId_ = -1; // dataName interned on the broker
+    std::unique_ptr<TradingMetrics> metrics_;
+
+    void submit(OrderType type, double requestedSize, OrderReason reason);
+
+public:
+    std::string getName() const override { return "SignalStrategy"; }
+    void init() override;
+    void next(const Bar& currentBar, size_t currentBarIndex, const double currentPrice) override;
+    void stop() override;
+    void notifyOrder(const Order& order) override;
+    void saveState(BinaryWriter& writer) const override;
+    void loadState(BinaryReader& reader) override;
+    // Flat wherever the signal was flat on the two previous bars
+    std::vector<size_t> getResetPoints() const override;
+    std::unique_ptr<Strategy> clone() const override { return std::make_unique<SignalStrategy>(); }
+};
+
+#endif // SIGNALSTRATEGY_H
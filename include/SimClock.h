@@ -0,0 +1,30 @@
+// SimClock.h
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+#include <chrono>
+
+// Simulated market time for one run, owned by the engine. It is moved to each
+// bar's timestamp before the broker and strategies see that bar, so nothing
+// inside the loop needs (or should use) the wall clock.
+class SimClock {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+    using duration = std::chrono::system_clock::duration;
+
+private:
+    time_point now_{};
+    duration orderLatency_{0};
+
+public:
+    time_point now() const { return now_; }
+    void advanceTo(time_point t) { now_ = t; }
+
+    // Fixed delay between submitting an order and it reaching the market. An
+    // order is only filled on a bar stamped at or after creation + latency.
+    duration getOrderLatency() const { return orderLatency_; }
+    void setOrderLatency(duration latency) { orderLatency_ = latency; }
+    bool hasArrived(time_point created, time_point barTime) const { return created + orderLatency_ <= barTime; }
+};
+
+#endif // SIMCLOCK_H
@@ -0,0 +1,31 @@
+// Span.h
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+
+// Non-owning, read-only view over contiguous elements (std::span is C++20).
+// Used to hand strategies windows into the engine's data without copying.
+template <typename T>
+class Span {
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    Span() = default;
+    Span(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const T& operator[](size_t i) const { return data_[i]; }
+    const T& front() const { return data_[0]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+};
+
+#endif // SPAN_H
@@ -4,30 +4,129 @@
 
 #include "Bar.h"
 #include "Order.h"
+#include "Indicator.h"
+#include "Span.h"
+#include "BarSeries.h"
+#include "TimerWheel.h"
 #include <vector>
 #include <string>
+#include <memory>
 #include <map> // Include map for passing current prices
+#include <limits>
+#include "BuildInfo.h"
 
 // Forward declarations
 class Broker;
 class Config;
+class BinaryWriter;
+class BinaryReader;
+class SimClock;
+
+// Conditions under which a sleeping strategy wants next() called again.
+// Set through Strategy::sleepUntil/wakeOnPriceCross/wakeOnFill; conditions
+// combine with OR. Only honoured when /Engine/FAST_FORWARD is enabled.
+struct WakeHint {
+    bool active = false; // false: call next() every bar
+    size_t untilBar = std::numeric_limits<size_t>::max();
+    double below = -std::numeric_limits<double>::infinity(); // Wake when price <= below
+    double above = std::numeric_limits<double>::infinity();  // Wake when price >= above
+    bool onFill = false; // Wake when one of the strategy's orders is filled or rejected
+};
 
 class Strategy {
 protected:
     Broker* broker; // Non-owning pointer to the broker instance
     const std::vector<Bar>* data; // Non-owning pointer to the historical data
+    const BarSeries* series; // Non-owning columnar view of the same data
     std::string dataName; // Name of the data series (e.g., "USDJPY")
     Config* config; // Non-owning pointer to configuration settings
+    const SimClock* clock; // Engine's simulated clock; use it instead of the wall clock
+    size_t barIndex; // Index of the bar being processed (set by engine)
+    std::vector<std::unique_ptr<Indicator>> indicators; // Updated by the engine every bar, including warm-up
+
+    // Registers an indicator; its getMinPeriod() counts towards the warm-up
+    Indicator* addIndicator(std::unique_ptr<Indicator> indicator);
+
+    // --- History Access ---
+    // Zero-copy windows over the last n bars up to and including the current
+    // bar. Throw std::out_of_range if n exceeds the bars seen so far, so a
+    // strategy can never read past the current bar.
+    Span<Bar> history(size_t n) const;
+    Span<double> column(const std::string& name, size_t n) const;
+    Span<double> column(size_t col, size_t n) const;
+    size_t barsAvailable() const { return barIndex + 1; }
+
+    // --- Wake-up Hints ---
+    // Tell the engine next() has nothing to do until one of these happens.
+    // Hints are cleared when the strategy is woken. Broker TP/SL levels and
+    // pending orders are still processed on the bars they need.
+    void sleepUntil(size_t bar);
+    void wakeOnPriceCross(double below, double above);
+    void wakeOnFill();
+
+    // --- Timers ---
+    // Callbacks in simulated time instead of timestamp checks in next().
+    // onTimer() runs on the first bar stamped at or after the due time, after
+    // the indicators and before next(), including warm-up and bars where the
+    // strategy sleeps. Periodic timers keep their phase; periods that fall
+    // inside a data gap fire once. Ids survive checkpoints.
+    TimerId scheduleAt(std::chrono::system_clock::time_point due,
+                       std::chrono::system_clock::duration period = std::chrono::system_clock::duration::zero());
+    // Due delay after the clock's current time (the first bar's time in init())
+    TimerId scheduleAfter(std::chrono::system_clock::duration delay,
+                          std::chrono::system_clock::duration period = std::chrono::system_clock::duration::zero());
+    bool cancelTimer(TimerId id);
 
 public:
     virtual std::string getName() const;
-    Strategy() : broker(nullptr), data(nullptr), config(nullptr) {} // Default init
+    // Identifies the strategy code for the result cache. Override and bump a
+    // version when behaviour changes without a new build ID (e.g. dirty trees).
+    virtual std::string getBuildId() const { return getName() + "@" + BuildInfo::buildId(); }
+    // Whether the config and data alone decide the run. Results of a strategy
+    // that draws from an unseeded source are never cached.
+    virtual bool isDeterministic(const Config& /*config*/) const { return true; }
+    Strategy() : broker(nullptr), data(nullptr), series(nullptr), config(nullptr), clock(nullptr), barIndex(0) {} // Default init
     virtual ~Strategy() = default; // Virtual destructor
 
     // --- Setup Methods (called by Engine) ---
     virtual void setBroker(Broker* b) { broker = b; }
     virtual void setData(const std::vector<Bar>* d, const std::string& name) { data = d; dataName = name; }
+    virtual void setSeries(const BarSeries* s) { series = s; }
     virtual void setConfig(Config* cfg) { config = cfg; }
+    virtual void setClock(const SimClock* c) { clock = c; }
+    void setTimers(TimerWheel* wheel, int owner) { timers = wheel; timerOwner = owner; }
+
+    // --- Engine Hooks ---
+    // Bars needed before next() is first called. The engine skips trading
+    // callbacks until max(getWarmupBars(), indicator min periods) bars have passed.
+    virtual size_t getWarmupBars() const { return 0; }
+    size_t getRequiredWarmup() const;
+    void setBarIndex(size_t index) { barIndex = index; }
+    void updateIndicators(const Bar& bar);
+    bool hasIndicators() const { return !indicators.empty(); }
+    const WakeHint& getWakeHint() const { return wakeHint; }
+    void clearWakeHint() { wakeHint = WakeHint(); }
+
+    // --- Checkpoint ---
+    // Engine entry points: base state (wake hint) followed by saveState/loadState.
+    // Indicators are not saved; the engine replays bars through them on resume.
+    void saveCheckpoint(BinaryWriter& writer) const;
+    void loadCheckpoint(BinaryReader& reader);
+    // Override to persist everything next()/notifyOrder() depend on, including
+    // metrics. loadState runs after init() on a freshly constructed strategy.
+    virtual void saveState(BinaryWriter& /*writer*/) const {}
+    virtual void loadState(BinaryReader& /*reader*/) {}
+
+    // --- Segment-parallel Runs ---
+    // Bars before which the strategy is always flat with no pending orders and
+    // no state carried over (session starts, resets), so the run can be cut
+    // there and the pieces simulated independently. Order sizes after the
+    // point must not depend on the account's cash or value: each piece starts
+    // with the starting cash, and the engine only checks that the broker's
+    // cash and margin checks would have gone the same way. Called after init().
+    virtual std::vector<size_t> getResetPoints() const { return {}; }
+    // New, uninitialised instance of the same strategy (nullptr: not supported)
+    virtual std::unique_ptr<Strategy> clone() const { return nullptr; }
 
     // --- Core Strategy Lifecycle Methods (to be overridden) ---
     // Called once before the backtest loop starts
@@ -39,6 +138,13 @@ public:
     virtual void stop() = 0;
     // Called by the Broker when an order status changes
     virtual void notifyOrder(const Order& order) = 0;
+    // Called for each of the strategy's timers that came due (see scheduleAt)
+    virtual void onTimer(TimerId /*id*/, std::chrono::system_clock::time_point /*due*/) {}
+
+private:
+    WakeHint wakeHint; // Written through the protected wake-up helpers, read by the engine
+    TimerWheel* timers = nullptr; // Engine's timer wheel (non-owning)
+    int timerOwner = -1;          // Tag the engine routes this strategy's timers by
 };
 
-#endif // STRATEGY_H
\ No newline at end of file
+#endif // STRATEGY_H
@@ -0,0 +1,108 @@
+// SweepRunner.h
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include "Config.h"
+#include "Bar.h"
+#include "BarSeries.h"
+#include "BatchStrategy.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <random>
+
+class BacktestEngine;
+
+// Adds the strategies a config asks for to a fresh engine (the engine-backed
+// evaluator calls it once per candidate, with the candidate's config)
+using StrategySetup = std::function<void(BacktestEngine& engine, const Config& config)>;
+
+// Outcome of one parameter set in a sweep
+struct SweepResult {
+    ParamSet params;
+    double finalValue = 0.0;
+    int trades = 0;            // Round trips closed
+    int profitableTrades = 0;
+    double commission = 0.0;
+    double maxDrawdown = 0.0;  // Percent, same convention as TradingMetrics
+    bool fromCache = false;
+    std::string stopReason;    // Why the set stopped early (empty = ran to the last bar); never cached
+};
+
+// Runs a strategy over many parameter sets on data that is already loaded.
+class SweepRunner {
+private:
+    const Config& config;
+    const BarSeries& series;
+    std::atomic<bool> cancelRequested{false};
+    const std::vector<Bar>* engineBars = nullptr; // Bars behind series, set by useEngine()
+    StrategySetup strategySetup;                  // Empty: candidates run on the batch strategy
+
+    // Uncached lock-step pass over the given parameter sets and bars [0, endBar)
+    std::vector<SweepResult> runLockstepPass(BatchStrategy& strategy, const std::vector<ParamSet>& params, size_t endBar);
+    // Splits the parameter sets into contiguous chunks, one lock-step pass per
+    // thread (/Sweep/THREADS) on its own strategy clone. Results keep the input order.
+    std::vector<SweepResult> runParallel(BatchStrategy& strategy, const std::vector<ParamSet>& params, size_t endBar);
+    // One BacktestEngine run per parameter set on bars [0, endBar), the sets
+    // applied to copies of the config and spread over /Sweep/THREADS threads.
+    // Every engine of a call shares one copy of the prefix. Results keep the input order.
+    std::vector<SweepResult> runEngines(const std::vector<ParamSet>& params, size_t endBar);
+    uint64_t cacheKey(const BatchStrategy& strategy, const ParamSet& params, uint64_t dataFingerprint) const;
+    // Surrogate step: new points inside the numeric bounds of the grid where a
+    // kernel-regression estimate of the score plus a distance-based
+    // exploration bonus is highest. evaluated is sorted best first; other
+    // parameters copy its first entry.
+    std::vector<ParamSet> proposeCandidates(const nlohmann::json& grid, const std::vector<SweepResult>& evaluated,
+                                            size_t count, std::mt19937_64& rng) const;
+
+public:
+    SweepRunner(const Config& cfg, const BarSeries& data);
+
+    // Cartesian product of {"<json pointer>": [values...], ...}
+    static std::vector<ParamSet> expandGrid(const nlohmann::json& grid);
+    // Whether the strategy reads every path of the grid (logs the ones it does not)
+    static bool checkGrid(const BatchStrategy& strategy, const nlohmann::json& grid);
+
+    // Evaluates halving candidates and genetic fitness with full BacktestEngine runs on bars
+    // (the bars series was built from) instead of the batch strategy, so any
+    // config path can be swept: strategy parameters, broker and portfolio
+    // settings alike. setup adds the strategies each candidate's config asks for.
+    void useEngine(const std::vector<Bar>& bars, StrategySetup setup);
+
+    // Lock-step mode: a single pass over the series advances every parameter
+    // set by one bar, so each bar is pulled into cache once for all of them.
+    // Accounts are kept as struct-of-arrays; fills happen at the next bar's
+    // price with the broker's commission and slippage models (RebalanceCost).
+    // Margin and fill capacity are not checked.
+    // With /Engine/RESULT_CACHE, sets already in the cache are not re-run.
+    // The engine's MAX_DRAWDOWN/MAX_ORDERS rules stop single sets (they are
+    // flattened and stop trading); MAX_SECONDS/MAX_BARS and cancel() end the
+    // whole pass. Both are checked every BUDGET_CHECK_INTERVAL bars.
+    std::vector<SweepResult> runLockstep(BatchStrategy& strategy, const std::vector<ParamSet>& params);
+
+    // Successive halving: every grid point is evaluated on the first
+    // /Sweep/MIN_FRACTION of the bars, the best 1/ETA are promoted to a prefix
+    // ETA times longer, and so on until the survivors run on all bars. With
+    // /Sweep/SURROGATE_POINTS > 0 each promotion also adds that many proposed
+    // points. Returns the full-length results, best final value first.
+    // With useEngine() the rungs are engine runs and strategy is not used.
+    std::vector<SweepResult> runHalving(BatchStrategy& strategy, const nlohmann::json& grid);
+
+    // Genetic search over the grid's value lists (one gene per grid path,
+    // holding an index into its list), configured under /Sweep/GENETIC.
+    // Each generation's new genomes are evaluated in parallel through
+    // runLockstep (or engine runs over all bars with useEngine()); genomes
+    // seen in earlier generations reuse their result.
+    // Returns every distinct genome of the last generation, best first.
+    std::vector<SweepResult> runGenetic(BatchStrategy& strategy, const nlohmann::json& grid);
+
+    // Thread-safe. A running pass stops at its next budget check.
+    void cancel() { cancelRequested.store(true); }
+
+    // Logs one line per result
+    static void logResults(const std::vector<SweepResult>& results);
+};
+
+#endif // SWEEPRUNNER_H
@@ -0,0 +1,44 @@
+// SymbolRegistry.h
+#ifndef SYMBOLREGISTRY_H
+#define SYMBOLREGISTRY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+
+// Maps symbol names to dense ids 0..size()-1 in first-seen order. Names are
+// hashed once when interned; per-bar code indexes flat tables by id instead.
+class SymbolRegistry {
+private:
+    std::unordered_map<std::string, int> ids_;
+    std::vector<std::string> names_;
+
+public:
+    // Id of the name, assigning the next free one if it is new
+    int intern(const std::string& name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+        const int id = static_cast<int>(names_.size());
+        ids_.emplace(name, id);
+        names_.push_back(name);
+        return id;
+    }
+
+    // Id of the name, or -1 if it was never interned
+    int find(const std::string& name) const {
+        auto it = ids_.find(name);
+        return it != ids_.end() ? it->second : -1;
+    }
+
+    bool contains(int id) const { return id >= 0 && id < static_cast<int>(names_.size()); }
+
+    const std::string& name(int id) const {
+        if (!contains(id)) throw std::out_of_range("SymbolRegistry: unknown symbol id " + std::to_string(id));
+        return names_[id];
+    }
+
+    size_t size() const { return names_.size(); }
+};
+
+#endif // SYMBOLREGISTRY_H
@@ -0,0 +1,104 @@
+// TimerWheel.h
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class BinaryWriter;
+class BinaryReader;
+
+using TimerId = uint64_t;
+
+// Hierarchical timing wheel over simulated time. Five levels of 256 slots
+// cover 2^40 ticks (about 34 years at the default 1 ms resolution); anything
+// further out waits in the top level and is re-placed when its slot comes
+// round. Insert and cancel are O(1); advancing jumps straight to the next
+// tick that has a slot to expire or cascade, so sparse timers cost nothing
+// on the bars in between.
+class TimerWheel {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+    using duration = std::chrono::system_clock::duration;
+
+    static constexpr TimerId INVALID_TIMER = 0;
+
+    struct Expired {
+        TimerId id;
+        int owner;      // Whatever the caller passed to schedule() (the engine uses the strategy slot)
+        time_point due; // Scheduled time, not the time of the bar it fired on
+    };
+
+private:
+    static constexpr int LEVEL_BITS = 8;
+    static constexpr uint64_t SLOTS = 1u << LEVEL_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr int LEVELS = 5;
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+    static constexpr uint32_t READY = LEVELS * SLOTS; // List of timers that were already due when scheduled
+
+    struct Node {
+        uint32_t generation = 1; // Bumped on free, so stale ids never match
+        bool live = false;
+        int owner = -1;
+        time_point due{};
+        duration period{0};
+        uint64_t tick = 0;
+        uint32_t slot = NIL;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+    };
+
+    duration resolution_;
+    time_point origin_{}; // Tick 0
+    uint64_t now_ = 0;    // Last tick advanced to
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::array<uint32_t, READY + 1> heads_;
+    std::array<uint32_t, READY + 1> tails_;
+    std::array<std::array<uint64_t, SLOTS / 64>, LEVELS> occupied_; // Non-empty slot bitmap per level
+    size_t live_ = 0;
+
+    uint64_t toTick(time_point t) const; // Rounded up, so a timer never fires before its time
+    void link(uint32_t index, uint32_t slot);
+    void unlink(uint32_t index);
+    void place(uint32_t index);
+    void release(uint32_t index);
+    // Ticks until the next non-empty slot of a level after its current one (0 = none)
+    uint64_t nextOccupied(int level) const;
+    void cascade(int level);
+    // Reports and frees (or re-arms past now) every timer in the slot
+    void expire(uint32_t slot, time_point now, std::vector<Expired>& expired);
+
+public:
+    explicit TimerWheel(duration resolution = std::chrono::milliseconds(1));
+
+    // Drops every timer. Tick 0 is origin; the wheel starts at now.
+    void reset(time_point origin, time_point now);
+
+    // One-shot when period is zero, otherwise re-armed every period after
+    // due. A due time at or before the wheel's time fires on the next advance.
+    TimerId schedule(int owner, time_point due, duration period = duration::zero());
+    // Returns false if the id is unknown or the one-shot timer already fired
+    bool cancel(TimerId id);
+
+    // Moves the wheel to now and appends the timers that came due, earliest
+    // first. Periodic timers are re-armed from their due time; periods that
+    // passed entirely inside one call (a data gap) fire once.
+    void advance(time_point now, std::vector<Expired>& expired);
+
+    bool empty() const { return live_ == 0; }
+    size_t size() const { return live_; }
+    // Earliest pending due time (time_point::max() when empty)
+    time_point nextDue() const;
+
+    // --- Checkpoint ---
+    // Live timers with their ids, in slot order so equal-tick timers keep
+    // their firing order after a resume
+    void saveState(BinaryWriter& writer) const;
+    void loadState(BinaryReader& reader);
+};
+
+#endif // TIMERWHEEL_H
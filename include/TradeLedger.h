@@ -0,0 +1,77 @@
+// TradeLedger.h
+#ifndef TRADELEDGER_H
+#define TRADELEDGER_H
+
+#include "Order.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Append-only order history stored column by column: one row per fill or
+// rejection. Appending copies plain numbers only (symbols are kept as ids
+// with one name per id), and a scan over one field touches only its column.
+class TradeLedger {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+private:
+    std::vector<int32_t> ids_;
+    std::vector<int32_t> strategyIds_;
+    std::vector<int32_t> symbolIds_;
+    std::vector<uint8_t> types_;    // OrderType
+    std::vector<uint8_t> kinds_;    // OrderKind
+    std::vector<uint8_t> statuses_; // OrderStatus
+    std::vector<uint8_t> reasons_;  // OrderReason
+    std::vector<double> requestedSizes_;
+    std::vector<double> filledSizes_;
+    std::vector<double> requestedPrices_;
+    std::vector<double> stopPrices_;
+    std::vector<double> filledPrices_;
+    std::vector<double> commissions_;
+    std::vector<double> realizedPnLs_;
+    std::vector<double> takeProfits_;
+    std::vector<double> stopLosses_;
+    std::vector<time_point> creationTimes_;
+    std::vector<time_point> executionTimes_;
+    std::vector<std::string> symbols_; // Name per symbol id seen in the ledger
+
+public:
+    void reserve(size_t rows);
+    void clear();
+    // The order must carry its broker's symbol id (-1 = no symbol)
+    void append(const Order& order);
+
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+    // Rebuilds the full order of one row
+    Order get(size_t row) const;
+
+    // --- Columns ---
+    const std::vector<int32_t>& ids() const { return ids_; }
+    const std::vector<int32_t>& strategyIds() const { return strategyIds_; }
+    const std::vector<int32_t>& symbolIds() const { return symbolIds_; }
+    const std::vector<uint8_t>& types() const { return types_; }
+    const std::vector<uint8_t>& kinds() const { return kinds_; }
+    const std::vector<uint8_t>& statuses() const { return statuses_; }
+    const std::vector<uint8_t>& reasons() const { return reasons_; }
+    const std::vector<double>& filledSizes() const { return filledSizes_; }
+    const std::vector<double>& filledPrices() const { return filledPrices_; }
+    const std::vector<double>& commissions() const { return commissions_; }
+    const std::vector<double>& realizedPnLs() const { return realizedPnLs_; }
+    const std::vector<time_point>& executionTimes() const { return executionTimes_; }
+    const std::string& symbolName(int32_t symbolId) const;
+
+    // --- Export ---
+    // One row per order with a header line
+    bool exportCsv(const std::string& path) const;
+    // 16-byte header (magic, version, row count), then every column as one
+    // contiguous array in declaration order and native byte order (times as
+    // int64 nanoseconds since the epoch), then the symbol names. Column
+    // offsets follow from the row count alone, so the file can be
+    // memory-mapped and scanned in place.
+    bool saveColumns(const std::string& path) const;
+    bool loadColumns(const std::string& path);
+};
+
+#endif // TRADELEDGER_H
@@ -6,6 +6,9 @@
 #include <chrono>
 #include "Order.h"
 
+class BinaryWriter;
+class BinaryReader;
+
 class TradingMetrics {
 private:
     double startingValue;
@@ -38,6 +41,10 @@ public:
     double getTotalCommission() const { return totalCommission; }
     double getTradingFrequency() const;
     
+    // Checkpoint support
+    void saveState(BinaryWriter& writer) const;
+    void loadState(BinaryReader& reader);
+
     // Generate summary as string
     std::string generateSummaryReport(double finalValue, const std::string& strategyName) const;
 };
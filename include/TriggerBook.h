@@ -0,0 +1,70 @@
+// TriggerBook.h
+#ifndef TRIGGERBOOK_H
+#define TRIGGERBOOK_H
+
+#include "OrderPool.h"
+#include <functional>
+#include <limits>
+#include <map>
+#include <vector>
+
+// Resting orders of one symbol keyed by the price that sets them off. Orders
+// reached by a rising price (sell limits, buy stops) are kept lowest level
+// first and those reached by a falling price (buy limits, sell stops)
+// highest first, so the orders a price range reaches are always a prefix of
+// one or both maps. Collecting them costs O(log n) plus one step per
+// triggered order; orders at the same level keep their arrival order.
+class TriggerBook {
+private:
+    std::multimap<double, OrderHandle> rising_;                        // Reached when price >= level
+    std::multimap<double, OrderHandle, std::greater<double>> falling_; // Reached when price <= level
+
+    template <typename Map>
+    static bool erase(Map& levels, double level, OrderHandle handle) {
+        auto range = levels.equal_range(level);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == handle) {
+                levels.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    double lastPrice = std::numeric_limits<double>::quiet_NaN(); // Price at the last sweep (start of the next bar's path)
+    bool listed = false; // Owner bookkeeping: the book is in the broker's sweep list
+
+    void add(double level, bool rising, OrderHandle handle) {
+        if (rising) rising_.emplace(level, handle);
+        else falling_.emplace(level, handle);
+    }
+
+    bool remove(double level, bool rising, OrderHandle handle) {
+        return rising ? erase(rising_, level, handle) : erase(falling_, level, handle);
+    }
+
+    // Moves every order whose level lies within [low, high] reach to out
+    void collect(double low, double high, std::vector<OrderHandle>& out) {
+        auto it = rising_.begin();
+        for (; it != rising_.end() && it->first <= high; ++it) out.push_back(it->second);
+        rising_.erase(rising_.begin(), it);
+        auto jt = falling_.begin();
+        for (; jt != falling_.end() && jt->first >= low; ++jt) out.push_back(jt->second);
+        falling_.erase(falling_.begin(), jt);
+    }
+
+    // Every resting order, in book order (rising side first)
+    void handles(std::vector<OrderHandle>& out) const {
+        for (const auto& entry : rising_) out.push_back(entry.second);
+        for (const auto& entry : falling_) out.push_back(entry.second);
+    }
+
+    bool empty() const { return rising_.empty() && falling_.empty(); }
+    size_t size() const { return rising_.size() + falling_.size(); }
+    // Nearest levels on either side (+/-infinity when a side is empty)
+    double lowestRising() const { return rising_.empty() ? std::numeric_limits<double>::infinity() : rising_.begin()->first; }
+    double highestFalling() const { return falling_.empty() ? -std::numeric_limits<double>::infinity() : falling_.begin()->first; }
+};
+
+#endif // TRIGGERBOOK_H
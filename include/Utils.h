@@ -4,6 +4,7 @@
 #include <string>
 #include <chrono>
 #include <vector>
+#include <cstdint>
 
 namespace Utils {
     // Parses "YYYYMMDD HHMMSSfff" format. Throws std::runtime_error on failure.
@@ -16,6 +17,10 @@ namespace Utils {
     void logMessage(const std::string& message);
 
     std::string timePointToString(const std::chrono::system_clock::time_point& tp);
+
+    // 64-bit FNV-1a. Pass the previous result as seed to hash data in pieces.
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    uint64_t fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
     
     std::string WideToUTF8(const std::wstring& wstr);
     std::wstring UTF8ToWide(const std::string& str);
@@ -0,0 +1,45 @@
+// VectorizedBacktest.h
+#ifndef VECTORIZEDBACKTEST_H
+#define VECTORIZEDBACKTEST_H
+
+#include "Config.h"
+#include "BarSeries.h"
+#include <vector>
+#include <string>
+
+struct VectorizedResult {
+    std::vector<double> positions; // Signed position held during each bar (after that bar's fill)
+    std::vector<double> equity;    // Marked to the bar's price, same sampling as BacktestEngine::getEquityCurve
+    double finalValue = 0.0;
+    double commission = 0.0;
+    double maxDrawdown = 0.0;      // Percent, same convention as TradingMetrics
+    int fills = 0;                 // Bars on which the position changed
+};
+
+// Backtest for strategies that are a pure function of a precomputed signal
+// column: target = SIZE * signal (signal in {-1, 0, 1}, NaN = flat). Runs as
+// whole-array passes with no per-bar virtual calls:
+//   pos[i]    = target[i-1]                      (market fill at the next bar's price)
+//   cost[i]   = commission + slippage of the fills from pos[i-1] to pos[i]
+//               (the broker's /Broker/COMMISSION_* and SLIPPAGE_* models, RebalanceCost)
+//   equity[i] = equity[i-1] + pos[i-1] * (p[i] - p[i-1]) - cost[i]
+// Margin, TP/SL and fill capacity are not modelled; SignalStrategy is the
+// event-driven equivalent used to verify results.
+class VectorizedBacktest {
+private:
+    const Config& config_;
+    const BarSeries& series_;
+
+public:
+    VectorizedBacktest(const Config& config, const BarSeries& series);
+
+    // Signal from /Vectorized/SIGNAL_COLUMN. Throws std::runtime_error if missing.
+    VectorizedResult run() const;
+    VectorizedResult run(const double* signal) const;
+
+    // Largest absolute difference between the two equity curves; logs the
+    // first diverging bar. Returns +inf if the lengths differ.
+    static double compare(const VectorizedResult& result, const std::vector<double>& eventEquity);
+};
+
+#endif // VECTORIZEDBACKTEST_H
@@ -2,15 +2,55 @@
 #include "BacktestEngine.h"
 #include "Utils.h"
 #include "Config.h"
+#include "BinaryIO.h"
+#include "ResultCache.h"
 #include <stdexcept>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <sstream>
+
+namespace {
+    const char CHECKPOINT_MAGIC[4] = {'B', 'T', 'C', 'P'};
+    const uint32_t CHECKPOINT_VERSION = 6;
+}
 
 // --- Constructor ---
 // Initialize members, especially DataLoader and Broker
 BacktestEngine::BacktestEngine(const Config& cfg) : // Take const ref
     config(cfg), // Copy config
+    bars(&historicalData),
+    barSeries(&series),
+    sharedPortfolio(false),
     currentBarIndex(0),
+    fastForward(false),
+    checkpointInterval(0),
+    resumeFromCheckpoint(false),
+    lastCheckpointBar(0),
+    equityWritten(0),
+    incremental(false),
+    configHash(0),
+    dataHash(Utils::FNV_OFFSET_BASIS),
+    dataHashBars(0),
+    useResultCache(false),
+    segmentParallel(false),
+    segmentThreads(0),
+    maxSeconds(0.0),
+    maxBars(0),
+    maxOrders(0),
+    maxDrawdown(0.0),
+    stopOnLiquidation(false),
+    budgetCheckInterval(256),
+    cancelFlag(std::make_shared<std::atomic<bool>>(false)),
+    budgetPeak(0.0),
+    budgetScanned(0),
+    budgetOrigin(0),
     dataLoader(cfg)
 {
     // Initialize Broker using config values
@@ -19,12 +59,55 @@ BacktestEngine::BacktestEngine(const Config& cfg) : // Take const ref
         double leverage = config.getNested<double>("/Broker/LEVERAGE", 100.0);
         double commRate = config.getNested<double>("/Broker/COMMISSION_RATE", 0.0);
         broker = std::make_unique<Broker>(startCash, leverage, commRate);
+        double latencyMs = config.getNested<double>("/Broker/ORDER_LATENCY_MS", 0.0);
+        clock.setOrderLatency(std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double, std::milli>(std::max(0.0, latencyMs))));
+        std::string pathName = config.getNested<std::string>("/Broker/INTRABAR_PATH", "CLOSE");
+        if (!IntrabarModel::parsePath(pathName, intrabarPath)) {
+            Utils::logMessage("BacktestEngine Warning: Unknown INTRABAR_PATH '" + pathName + "', using CLOSE.");
+            intrabarPath = IntrabarPath::CLOSE;
+        }
+
+        // --- Costs ---
+        commissionModel = CommissionModel::fromConfig(config);
+        slippageModel = SlippageModel::fromConfig(config);
+
+        // --- Fill Capacity ---
+        participationRate = config.getNested<double>("/Broker/PARTICIPATION_RATE", 0.0);
+
+        // --- Margin ---
+        marginCallLevel = config.getNested<double>("/Broker/MARGIN_CALL_LEVEL", 0.0);
+        maintenanceMargin = config.getNested<double>("/Broker/MAINTENANCE_MARGIN", 0.0);
+        if (marginCallLevel > 0.0 && maintenanceMargin > marginCallLevel) {
+            Utils::logMessage("BacktestEngine Warning: MAINTENANCE_MARGIN is above MARGIN_CALL_LEVEL, positions are liquidated before any margin call.");
+        }
     } catch (const std::exception& e) {
         // Catch potential type errors from getNested as well
         Utils::logMessage("BacktestEngine Error: Failed to parse broker parameters from config: " + std::string(e.what()));
         throw std::runtime_error("Failed to initialize Broker from config.");
     }
 
+    std::string mode = config.getNested<std::string>("/Portfolio/MODE", "SubAccount");
+    sharedPortfolio = (mode == "Shared");
+    fastForward = config.getNested<bool>("/Engine/FAST_FORWARD", false);
+    checkpointInterval = static_cast<size_t>(std::max(0, config.getNested<int>("/Engine/CHECKPOINT_INTERVAL", 0)));
+    checkpointDir = config.getNested<std::string>("/Engine/CHECKPOINT_DIR", "checkpoints");
+    resumeFromCheckpoint = config.getNested<bool>("/Engine/RESUME", false);
+    incremental = config.getNested<bool>("/Engine/INCREMENTAL", false);
+    useResultCache = config.getNested<bool>("/Engine/RESULT_CACHE", false);
+    resultCacheDir = config.getNested<std::string>("/Engine/RESULT_CACHE_DIR", "result_cache");
+    tradeLogPath = config.getNested<std::string>("/Engine/TRADE_LOG", "");
+    segmentParallel = config.getNested<bool>("/Engine/SEGMENT_PARALLEL", false);
+    segmentThreads = static_cast<size_t>(std::max(0, config.getNested<int>("/Engine/SEGMENT_THREADS", 0)));
+    maxSeconds = config.getNested<double>("/Engine/MAX_SECONDS", 0.0);
+    maxBars = static_cast<size_t>(std::max(0, config.getNested<int>("/Engine/MAX_BARS", 0)));
+    maxOrders = static_cast<size_t>(std::max(0, config.getNested<int>("/Engine/MAX_ORDERS", 0)));
+    maxDrawdown = config.getNested<double>("/Engine/MAX_DRAWDOWN", 0.0);
+    stopOnLiquidation = config.getNested<bool>("/Engine/STOP_ON_LIQUIDATION", false);
+    budgetCheckInterval = static_cast<size_t>(std::max(1, config.getNested<int>("/Engine/BUDGET_CHECK_INTERVAL", 256)));
+    // Engine/Sweep settings do not change a run's results
+    std::string fingerprint = config.dump({"Engine", "Sweep"});
+    configHash = Utils::fnv1a(fingerprint.data(), fingerprint.size());
+
     // Extract primary data name
     std::string path = config.getNested<std::string>("/Data/INPUT_CSV_PATH", "");
     size_t last_slash_idx = path.find_last_of("\\/");
@@ -36,6 +119,13 @@ BacktestEngine::BacktestEngine(const Config& cfg) : // Take const ref
     Utils::logMessage("BacktestEngine initialized for data: " + primaryDataName);
 }
 
+BacktestEngine::BacktestEngine(const Config& cfg, const std::vector<Bar>& data, const BarSeries& view) :
+    BacktestEngine(cfg)
+{
+    bars = &data;
+    barSeries = &view;
+}
+
 // --- Setup ---
 bool BacktestEngine::loadData() {
     Utils::logMessage("BacktestEngine: Loading data...");
@@ -54,6 +144,9 @@ bool BacktestEngine::loadData() {
             return false;
         }
         Utils::logMessage("BacktestEngine: Data loaded successfully (" + std::to_string(historicalData.size()) + " bars).");
+
+        std::string source = config.getNested<std::string>("/Data/INPUT_SOURCE", "csv");
+        series = BarSeries(historicalData, config.getColumnSpecs(source == "api" ? "/Data/API_Columns" : "/Data/CSV_Columns"));
         return true;
 
     } catch (const std::exception& e) {
@@ -69,20 +162,713 @@ void BacktestEngine::setStrategy(std::unique_ptr<Strategy> strat) {
         return;
     }
     Utils::logMessage("BacktestEngine: Setting strategy...");
-    strategy = std::move(strat);
+    strategies.clear();
+    addStrategy(std::move(strat), 1.0);
+}
+
+void BacktestEngine::addStrategy(std::unique_ptr<Strategy> strat, double allocation) {
+    if (!strat) {
+        Utils::logMessage("BacktestEngine Warning: Attempted to add a null strategy.");
+        return;
+    }
+    if (allocation <= 0.0) {
+        Utils::logMessage("BacktestEngine Warning: Non-positive allocation for " + strat->getName() + ". Using 1.0.");
+        allocation = 1.0;
+    }
+    Utils::logMessage("BacktestEngine: Adding strategy " + strat->getName() + " (allocation " + std::to_string(allocation) + ")");
+    StrategySlot slot;
+    slot.strategy = std::move(strat);
+    slot.allocation = allocation;
+    strategies.push_back(std::move(slot));
+}
+
+std::unique_ptr<Broker> BacktestEngine::createBroker(double startingCash) const {
+    double leverage = config.getNested<double>("/Broker/LEVERAGE", 100.0);
+    double commRate = config.getNested<double>("/Broker/COMMISSION_RATE", 0.0);
+    return std::make_unique<Broker>(startingCash, leverage, commRate);
+}
+
+// Sub-account mode: each strategy gets its own broker holding its share of the
+// starting cash. Shared mode: every strategy trades the portfolio broker, which
+// routes fills back by strategyId and caps margin by allocation.
+void BacktestEngine::setupAccounts() {
+    accounts.clear();
+    subAccounts.clear();
+    // Registrations from a previous run() would route fills to stale strategyIds
+    broker->clearStrategies();
+
+    if (sharedPortfolio) {
+        for (auto& slot : strategies) {
+            double cap = std::min(slot.allocation, 1.0);
+            slot.account = broker.get();
+            slot.brokerStrategyId = broker->addStrategy(slot.strategy.get(), cap);
+        }
+        accounts.push_back(broker.get());
+        return;
+    }
+
+    if (strategies.size() == 1) {
+        strategies[0].account = broker.get();
+        strategies[0].brokerStrategyId = -1;
+        broker->setStrategy(strategies[0].strategy.get());
+        accounts.push_back(broker.get());
+        return;
+    }
+
+    double totalAllocation = 0.0;
+    for (const auto& slot : strategies) totalAllocation += slot.allocation;
+    double startCash = broker->getStartingCash();
+    for (auto& slot : strategies) {
+        subAccounts.push_back(createBroker(startCash * slot.allocation / totalAllocation));
+        slot.account = subAccounts.back().get();
+        slot.brokerStrategyId = -1;
+        slot.account->setStrategy(slot.strategy.get());
+        accounts.push_back(slot.account);
+    }
+}
+
+double BacktestEngine::getPortfolioValue(double price) const {
+    double value = 0.0;
+    for (const Broker* account : accounts) {
+        value += account->getValue(price);
+    }
+    return value;
+}
+
+// --- Fast-forward ---
+void BacktestEngine::collectOrderEvents() {
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        const std::vector<int32_t>& owners = accounts[a]->getOrderHistory().strategyIds();
+        for (size_t h = historySeen[a]; h < owners.size(); ++h) {
+            for (auto& slot : strategies) {
+                if (slot.account != accounts[a]) continue;
+                if (slot.brokerStrategyId < 0 || owners[h] == slot.brokerStrategyId) {
+                    slot.orderEvent = true;
+                }
+            }
+        }
+        historySeen[a] = owners.size();
+    }
+}
+
+bool BacktestEngine::isAwake(StrategySlot& slot, size_t barIndex, double price) {
+    const WakeHint& hint = slot.strategy->getWakeHint();
+    if (!hint.active) return true;
+    if (barIndex >= hint.untilBar || price <= hint.below || price >= hint.above || (hint.onFill && slot.orderEvent)) {
+        slot.strategy->clearWakeHint();
+        return true;
+    }
+    return false;
+}
+
+// Bars strictly between barIndex and the returned bar have no pending orders,
+// no TP/SL inside reach, no timer due and every strategy asleep, so
+// processOrders and next() would be no-ops there. The price band is checked
+// with a vectorized scan.
+size_t BacktestEngine::findNextActiveBar(size_t barIndex, size_t endBar) const {
+    const size_t next = barIndex + 1;
+    if (next >= endBar) return next;
+    for (const Broker* account : accounts) {
+        if (account->hasPendingOrders()) return next;
+    }
+
+    size_t limit = endBar;
+    double below = -std::numeric_limits<double>::infinity();
+    double above = std::numeric_limits<double>::infinity();
+    for (const auto& slot : strategies) {
+        if (next < slot.warmup) {
+            limit = std::min(limit, slot.warmup); // Not trading yet, indicators are fed on skipped bars
+            continue;
+        }
+        const WakeHint& hint = slot.strategy->getWakeHint();
+        if (!hint.active || (hint.onFill && slot.orderEvent)) return next;
+        limit = std::min(limit, std::max(hint.untilBar, next));
+        below = std::max(below, hint.below);
+        above = std::min(above, hint.above);
+    }
+    if (!timers.empty()) {
+        const auto& timestamps = barSeries->timestamps();
+        auto due = std::lower_bound(timestamps.begin() + next, timestamps.begin() + limit, timers.nextDue());
+        limit = static_cast<size_t>(due - timestamps.begin());
+        if (limit == next) return next;
+    }
+    for (const Broker* account : accounts) {
+        account->getTriggerBand(below, above);
+    }
+    if (intrabar.active()) {
+        // Levels can be touched by a bar's extremes without its close crossing them
+        limit = barSeries->findCross(intrabar.low, next, limit, below, std::numeric_limits<double>::infinity());
+        return barSeries->findCross(intrabar.high, next, limit, -std::numeric_limits<double>::infinity(), above);
+    }
+    return barSeries->findCross(BarSeries::PRICE_COLUMN, next, limit, below, above);
+}
+
+// --- Checkpointing ---
+std::string BacktestEngine::checkpointPath(const std::string& file) const {
+    return (std::filesystem::path(checkpointDir) / file).string();
+}
+
+void BacktestEngine::resetLedgers() {
+    ledgerCount.assign(accounts.size(), 0);
+    ledgerBytes.assign(accounts.size(), 0);
+    equityWritten = 0;
+    std::error_code ec;
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        std::filesystem::remove(checkpointPath("orders_" + std::to_string(a) + ".bin"), ec);
+    }
+    std::filesystem::remove(checkpointPath("equity.bin"), ec);
+}
+
+void BacktestEngine::saveCheckpoint(size_t nextBar) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    try {
+        std::filesystem::create_directories(checkpointDir);
+
+        // 1. Ledgers: only what was added since the last snapshot
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            std::string path = checkpointPath("orders_" + std::to_string(a) + ".bin");
+            {
+                std::ofstream out(path, std::ios::binary | std::ios::app);
+                BinaryWriter writer(out);
+                const TradeLedger& history = accounts[a]->getOrderHistory();
+                for (size_t h = ledgerCount[a]; h < history.size(); ++h) {
+                    writeOrder(writer, history.get(h));
+                }
+                if (!writer.good()) throw std::runtime_error("Failed to write " + path);
+                ledgerCount[a] = history.size();
+            }
+            ledgerBytes[a] = static_cast<size_t>(std::filesystem::file_size(path));
+        }
+        {
+            std::ofstream out(checkpointPath("equity.bin"), std::ios::binary | std::ios::app);
+            BinaryWriter writer(out);
+            writer.writeBytes(equityCurve.data() + equityWritten, (equityCurve.size() - equityWritten) * sizeof(double));
+            if (!writer.good()) throw std::runtime_error("Failed to write equity ledger");
+            equityWritten = equityCurve.size();
+        }
+
+        // 2. Snapshot
+        dataHash = barSeries->hashRows(dataHashBars, nextBar, dataHash); // Extend, so each snapshot only hashes new bars
+        dataHashBars = nextBar;
+        std::string finalPath = checkpointPath("checkpoint.bin");
+        std::string tmpPath = finalPath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            BinaryWriter writer(out);
+            writer.writeBytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+            writer.write(CHECKPOINT_VERSION);
+            writer.writeSize(nextBar);
+            writer.write(configHash);
+            writer.write(dataHash);
+            writer.writeSize(strategies.size());
+            for (const auto& slot : strategies) {
+                writer.writeString(slot.strategy->getName());
+            }
+            writer.writeSize(accounts.size());
+            for (size_t a = 0; a < accounts.size(); ++a) {
+                accounts[a]->saveState(writer);
+                writer.writeSize(ledgerCount[a]);
+                writer.writeSize(ledgerBytes[a]);
+                writer.writeSize(historySeen[a]);
+            }
+            writer.writeSize(equityWritten);
+            for (const auto& slot : strategies) {
+                writer.write(slot.orderEvent);
+                slot.strategy->saveCheckpoint(writer);
+            }
+            timers.saveState(writer);
+            if (!writer.good()) throw std::runtime_error("Failed to write " + tmpPath);
+        }
+        std::filesystem::rename(tmpPath, finalPath);
+        lastCheckpointBar = nextBar;
+
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTime;
+        Utils::logMessage("BacktestEngine: Checkpoint at bar " + std::to_string(nextBar) + " written in " +
+                          std::to_string(duration.count()) + " seconds");
+    } catch (const std::exception& e) {
+        // A failed snapshot should not end a long run; the previous one stays valid
+        Utils::logMessage("BacktestEngine Error: Failed to write checkpoint: " + std::string(e.what()));
+    }
+}
+
+size_t BacktestEngine::restoreCheckpoint() {
+    std::string path = checkpointPath("checkpoint.bin");
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        Utils::logMessage("BacktestEngine: No checkpoint at " + path + ", starting from bar 0.");
+        return 0;
+    }
+    BinaryReader reader(in);
+
+    // --- Header: validate before touching any state ---
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    reader.readBytes(magic, sizeof(magic));
+    if (!std::equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC) || reader.read<uint32_t>() != CHECKPOINT_VERSION) {
+        Utils::logMessage("BacktestEngine Warning: " + path + " is not a compatible checkpoint, starting from bar 0.");
+        return 0;
+    }
+    size_t nextBar = reader.readSize();
+    uint64_t savedConfigHash = reader.read<uint64_t>();
+    uint64_t savedDataHash = reader.read<uint64_t>();
+    size_t numStrategies = reader.readSize();
+    bool matches = (numStrategies == strategies.size());
+    for (size_t i = 0; i < numStrategies; ++i) {
+        std::string name = reader.readString();
+        matches = matches && name == strategies[i].strategy->getName();
+    }
+    matches = matches && reader.readSize() == accounts.size();
+    if (!matches || nextBar > bars->size()) {
+        Utils::logMessage("BacktestEngine Warning: Checkpoint does not match the current strategies/data, starting from bar 0.");
+        return 0;
+    }
+    if (savedConfigHash != configHash) {
+        Utils::logMessage("BacktestEngine Warning: Config changed since the checkpoint, starting from bar 0.");
+        return 0;
+    }
+    // The loaded data must be a strict extension of the checkpointed prefix
+    uint64_t prefixHash = barSeries->hashRows(0, nextBar, Utils::FNV_OFFSET_BASIS);
+    if (prefixHash != savedDataHash) {
+        Utils::logMessage("BacktestEngine Warning: Data before bar " + std::to_string(nextBar) +
+                          " differs from the checkpointed run, starting from bar 0.");
+        return 0;
+    }
+    dataHash = prefixHash;
+    dataHashBars = nextBar;
+
+    // --- Accounts and ledgers ---
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        accounts[a]->loadState(reader);
+        ledgerCount[a] = reader.readSize();
+        ledgerBytes[a] = reader.readSize();
+        historySeen[a] = reader.readSize();
+
+        // Drop anything appended after the snapshot was taken
+        std::string ledgerPath = checkpointPath("orders_" + std::to_string(a) + ".bin");
+        std::filesystem::resize_file(ledgerPath, ledgerBytes[a]);
+        std::ifstream ledgerIn(ledgerPath, std::ios::binary);
+        BinaryReader ledgerReader(ledgerIn);
+        std::vector<Order> history;
+        history.reserve(ledgerCount[a]);
+        for (size_t h = 0; h < ledgerCount[a]; ++h) {
+            history.push_back(readOrder(ledgerReader));
+        }
+        accounts[a]->restoreOrderHistory(std::move(history));
+    }
+    equityWritten = reader.readSize();
+    std::filesystem::resize_file(checkpointPath("equity.bin"), equityWritten * sizeof(double));
+    {
+        std::ifstream equityIn(checkpointPath("equity.bin"), std::ios::binary);
+        BinaryReader equityReader(equityIn);
+        equityCurve.resize(equityWritten);
+        equityReader.readBytes(equityCurve.data(), equityWritten * sizeof(double));
+    }
+
+    // --- Strategies ---
+    for (auto& slot : strategies) {
+        slot.orderEvent = reader.read<bool>();
+        slot.strategy->loadCheckpoint(reader);
+    }
+    timers.loadState(reader);
+
+    lastCheckpointBar = nextBar;
+    Utils::logMessage("BacktestEngine: Resumed from checkpoint at bar " + std::to_string(nextBar) + " (" +
+                      std::to_string(bars->size() - nextBar) + " new bars to simulate)");
+    return nextBar;
+}
+
+// --- Result Cache ---
+uint64_t BacktestEngine::resultCacheKey() const {
+    std::vector<std::string> buildIds;
+    buildIds.reserve(strategies.size());
+    for (const auto& slot : strategies) {
+        buildIds.push_back(slot.strategy->getBuildId() + ":" + std::to_string(slot.allocation));
+    }
+    return ResultCache::makeKey(config.dump({"Engine", "Sweep"}), barSeries->fingerprint(), buildIds);
+}
+
+void BacktestEngine::buildResult(double finalValue) {
+    result = RunResult();
+    result.finalValue = finalValue;
+    result.equityCurve = equityCurve;
+    result.stopReason = stopReason;
+
+    double peak = 0.0;
+    for (double value : equityCurve) {
+        peak = std::max(peak, value);
+        if (peak > 0.0) result.maxDrawdown = std::max(result.maxDrawdown, (peak - value) / peak * 100.0);
+    }
+    for (const Broker* account : accounts) {
+        const TradeLedger& history = account->getOrderHistory();
+        result.accountOrders.push_back(history.size());
+        const std::vector<uint8_t>& statuses = history.statuses();
+        const std::vector<uint8_t>& reasons = history.reasons();
+        for (size_t h = 0; h < history.size(); ++h) {
+            result.tradeLog.push_back(history.get(h));
+            if (statuses[h] != static_cast<uint8_t>(OrderStatus::FILLED)) continue;
+            result.commission += history.commissions()[h];
+            if (reasons[h] != static_cast<uint8_t>(OrderReason::ENTRY_SIGNAL)) {
+                result.trades++;
+                if (history.realizedPnLs()[h] > 0.0) result.profitableTrades++;
+            }
+        }
+    }
+}
+
+void BacktestEngine::exportTradeLog(const std::vector<const TradeLedger*>& histories) const {
+    const std::filesystem::path base(tradeLogPath);
+    const bool csv = base.extension() == ".csv";
+    for (size_t a = 0; a < histories.size(); ++a) {
+        std::filesystem::path path = base;
+        if (histories.size() > 1) { // One file per sub-account: trades.csv -> trades_0.csv, ...
+            path.replace_filename(base.stem().string() + "_" + std::to_string(a) + base.extension().string());
+        }
+        const TradeLedger& history = *histories[a];
+        if (csv ? history.exportCsv(path.string()) : history.saveColumns(path.string())) {
+            Utils::logMessage("BacktestEngine: Wrote " + std::to_string(history.size()) + " orders to " + path.string());
+        }
+    }
+}
+
+// --- Budgets ---
+bool BacktestEngine::budgetExceeded(size_t barsRun) {
+    if (cancelFlag->load(std::memory_order_relaxed)) {
+        stopReason = "cancelled";
+    } else if (maxBars > 0 && barsRun >= maxBars) {
+        stopReason = "bar budget of " + std::to_string(maxBars) + " reached";
+    } else if (maxSeconds > 0.0 &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count() >= maxSeconds) {
+        stopReason = "time budget of " + std::to_string(maxSeconds) + " seconds reached";
+    }
+    if (stopReason.empty() && maxOrders > 0) {
+        size_t orders = 0;
+        for (const Broker* account : accounts) orders += account->getOrderHistory().size();
+        if (orders >= maxOrders) stopReason = "order budget of " + std::to_string(maxOrders) + " reached";
+    }
+    if (stopReason.empty() && stopOnLiquidation) {
+        for (const Broker* account : accounts) {
+            if (account->getLiquidations() > 0) {
+                stopReason = "account liquidated";
+                break;
+            }
+        }
+    }
+    if (stopReason.empty() && maxDrawdown > 0.0) {
+        // Only the samples added since the last check are scanned
+        for (; budgetScanned < equityCurve.size(); ++budgetScanned) {
+            const double value = equityCurve[budgetScanned];
+            budgetPeak = std::max(budgetPeak, value);
+            if (budgetPeak > 0.0 && (budgetPeak - value) / budgetPeak * 100.0 > maxDrawdown) {
+                stopReason = "drawdown above " + std::to_string(maxDrawdown) + "%";
+                break;
+            }
+        }
+    }
+    return !stopReason.empty();
+}
+
+// --- Segment-parallel Runs ---
+std::vector<size_t> BacktestEngine::findSegmentCuts() const {
+    const size_t totalBars = bars->size();
+    std::vector<size_t> points;
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        std::vector<size_t> own = strategies[i].strategy->getResetPoints();
+        std::sort(own.begin(), own.end());
+        if (i == 0) {
+            points = std::move(own);
+            continue;
+        }
+        std::vector<size_t> common;
+        std::set_intersection(points.begin(), points.end(), own.begin(), own.end(), std::back_inserter(common));
+        points = std::move(common);
+    }
+
+    size_t threads = segmentThreads > 0 ? segmentThreads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> cuts = {0};
+    for (size_t t = 1; t < threads; ++t) {
+        auto it = std::lower_bound(points.begin(), points.end(), totalBars * t / threads);
+        if (it != points.end() && *it > cuts.back() && *it < totalBars) cuts.push_back(*it);
+    }
+    cuts.push_back(totalBars);
+    return cuts;
+}
+
+bool BacktestEngine::runSegment(size_t startBar, size_t endBar, size_t& skippedBars) {
+    if (!initStrategies(startBar)) return false;
+    size_t warmup = 0;
+    for (const auto& slot : strategies) warmup = std::max(warmup, slot.warmup);
+    replayIndicators(startBar - std::min(startBar, warmup), startBar);
+    equityCurve.clear();
+    equityCurve.reserve(endBar - startBar);
+    stopReason.clear();
+    budgetOrigin = startBar;
+    skippedBars = simulate(startBar, endBar);
+    return true;
+}
+
+bool BacktestEngine::runSegments(size_t& skippedBars, size_t& resumeBar) {
+    std::vector<size_t> cuts = findSegmentCuts();
+    if (cuts.size() < 3) {
+        Utils::logMessage("BacktestEngine: No usable reset points for a segment-parallel run, running sequentially.");
+        return false;
+    }
+    // Segments the bar budget stops in or before are left to the sequential pass
+    size_t numSegments = cuts.size() - 1;
+    while (maxBars > 0 && numSegments > 0 && cuts[numSegments] - budgetOrigin >= maxBars) numSegments--;
+    if (numSegments == 0) {
+        Utils::logMessage("BacktestEngine: The bar budget ends the run in its first segment, running sequentially.");
+        return false;
+    }
+
+    // --- Child engines: same config and data, fresh strategy instances ---
+    std::vector<std::unique_ptr<BacktestEngine>> segments;
+    for (size_t s = 0; s < numSegments; ++s) {
+        auto segment = std::make_unique<BacktestEngine>(config);
+        segment->bars = bars;
+        segment->barSeries = barSeries;
+        segment->primaryDataName = primaryDataName;
+        segment->segmentParallel = false;
+        segment->cancelFlag = cancelFlag;
+        segment->runStart = runStart; // The time budget is for the whole run
+        // Budgets over the run so far are checked on the stitched run below
+        segment->maxBars = 0;
+        segment->maxOrders = 0;
+        segment->maxDrawdown = 0.0;
+        // Margin is then checked on every bar, so the cash headroom covers them all
+        if (maintenanceMargin > 0.0) segment->fastForward = false;
+        for (const auto& slot : strategies) {
+            std::unique_ptr<Strategy> clone = slot.strategy->clone();
+            if (!clone) {
+                Utils::logMessage("BacktestEngine: " + slot.strategy->getName() + " cannot be cloned, running sequentially.");
+                return false;
+            }
+            segment->addStrategy(std::move(clone), slot.allocation);
+        }
+        segments.push_back(std::move(segment));
+    }
+
+    Utils::logMessage("BacktestEngine: Simulating " + std::to_string(numSegments) + " segments in parallel");
+    std::vector<size_t> segmentSkipped(numSegments, 0);
+    std::vector<std::future<bool>> futures;
+    for (size_t s = 0; s < numSegments; ++s) {
+        futures.emplace_back(std::async(std::launch::async, [&segments, &cuts, &segmentSkipped, s] {
+            return segments[s]->runSegment(cuts[s], cuts[s + 1], segmentSkipped[s]);
+        }));
+    }
+    bool ok = true;
+    for (auto& future : futures) {
+        try {
+            ok = future.get() && ok;
+        } catch (const std::exception& e) {
+            Utils::logMessage("BacktestEngine Error: Exception in segment: " + std::string(e.what()));
+            ok = false;
+        }
+    }
+    if (!ok) {
+        Utils::logMessage("BacktestEngine Error: A segment failed, running sequentially.");
+        return false;
+    }
+
+    // --- Cash and budgets on the stitched run ---
+    // Each segment started with the full starting cash, where the sequential
+    // run has what the earlier segments left. A segment is used only if its
+    // cash and margin checks would have gone the same way with that cash
+    // (see Broker::getCashHeadroom), and if no bar, order or drawdown budget
+    // can stop the run inside it. One stopped by its own cancel, time or
+    // liquidation check ends the run there.
+    size_t usedSegments = 0;
+    bool segmentStopped = false;
+    size_t orders = 0;
+    double offset = 0.0; // Realized P/L of the segments before this one
+    double peak = budgetPeak;
+    std::vector<double> accountCash(accounts.size()); // Each account's cash before the segment
+    for (size_t a = 0; a < accounts.size(); ++a) accountCash[a] = accounts[a]->getCash();
+    while (usedSegments < numSegments && !segmentStopped) {
+        const BacktestEngine& segment = *segments[usedSegments];
+        size_t segmentOrders = 0;
+        double segmentPnL = 0.0;
+        bool sameFills = true;
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            const Broker& account = *segment.accounts[a];
+            const double extra = accountCash[a] - account.getStartingCash();
+            sameFills = sameFills && (extra == 0.0 || (extra > 0.0 && !account.isCashBound()) ||
+                                      (extra < 0.0 && account.getLiquidations() == 0 && account.getCashHeadroom() >= -extra));
+            segmentOrders += account.getOrderHistory().size();
+            segmentPnL += account.getCash() - account.getStartingCash();
+        }
+        if (!sameFills) {
+            Utils::logMessage("BacktestEngine: Segment from bar " + std::to_string(cuts[usedSegments]) + " depends on the cash carried into it.");
+            break;
+        }
+        if (maxOrders > 0 && orders + segmentOrders >= maxOrders) break;
+        double segmentPeak = peak;
+        bool breached = false;
+        for (size_t k = 0; maxDrawdown > 0.0 && k < segment.equityCurve.size() && !breached; ++k) {
+            const double value = segment.equityCurve[k] + offset;
+            segmentPeak = std::max(segmentPeak, value);
+            breached = segmentPeak > 0.0 && (segmentPeak - value) / segmentPeak * 100.0 > maxDrawdown;
+        }
+        if (breached) break;
+        orders += segmentOrders;
+        offset += segmentPnL;
+        peak = segmentPeak;
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            accountCash[a] += segment.accounts[a]->getCash() - segment.accounts[a]->getStartingCash();
+        }
+        segmentStopped = !segment.stopReason.empty();
+        usedSegments++;
+    }
+    if (usedSegments == 0) {
+        Utils::logMessage("BacktestEngine: A budget or the account's cash ends the run in its first segment, running sequentially.");
+        return false;
+    }
+    resumeBar = segmentStopped ? bars->size() : cuts[usedSegments];
+
+    // Every segment followed by another (or by the sequential pass) must end
+    // flat, or the next one did not start from the state it assumed
+    for (size_t s = 0; s < usedSegments && cuts[s + 1] < resumeBar; ++s) {
+        for (const Broker* account : segments[s]->accounts) {
+            if (account->hasPendingOrders() || account->hasRestingOrders() || account->hasOpenPositions()) {
+                Utils::logMessage("BacktestEngine Error: Segment ending at bar " + std::to_string(cuts[s + 1]) +
+                                  " is not flat, the declared reset point is wrong. Running sequentially.");
+                return false;
+            }
+        }
+    }
+
+    // --- Prefix pass: accounts and equity in bar order ---
+    equityCurve.clear();
+    offset = 0.0;
+    for (size_t s = 0; s < usedSegments; ++s) {
+        BacktestEngine& segment = *segments[s];
+        for (double value : segment.equityCurve) {
+            equityCurve.push_back(value + offset);
+        }
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            const Broker& account = *segment.accounts[a];
+            accounts[a]->appendSegment(account);
+            offset += account.getCash() - account.getStartingCash();
+        }
+        skippedBars += segmentSkipped[s];
+    }
+
+    // Strategies and timers continue from the last segment's state, so stop()
+    // (or the sequential pass) sees the account as it is there
+    BacktestEngine& last = *segments[usedSegments - 1];
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        std::stringstream state;
+        BinaryWriter writer(state);
+        last.strategies[i].strategy->saveCheckpoint(writer);
+        BinaryReader reader(state);
+        strategies[i].strategy->loadCheckpoint(reader);
+    }
+    std::stringstream timerState;
+    BinaryWriter timerWriter(timerState);
+    last.timers.saveState(timerWriter);
+    BinaryReader timerReader(timerState);
+    timers.loadState(timerReader);
+    currentPrice = last.currentPrice;
+    currentBarIndex = last.currentBarIndex;
+    clock.advanceTo(last.clock.now());
+    stopReason = last.stopReason;
+
+    if (resumeBar < bars->size()) {
+        Utils::logMessage("BacktestEngine: Continuing sequentially from bar " + std::to_string(resumeBar) + ".");
+        size_t warmup = 0;
+        for (const auto& slot : strategies) warmup = std::max(warmup, slot.warmup);
+        replayIndicators(resumeBar - std::min(resumeBar, warmup), resumeBar);
+        for (size_t a = 0; a < accounts.size(); ++a) {
+            historySeen[a] = accounts[a]->getOrderHistory().size(); // Already seen by the segments' strategies
+        }
+        budgetPeak = peak;
+        budgetScanned = equityCurve.size();
+    }
+    return true;
 }
 
 // --- Execution ---
+bool BacktestEngine::initStrategies(size_t startBar) {
+    // --- Setup Links ---
+    Utils::logMessage("BacktestEngine: Linking components (" + std::to_string(strategies.size()) + " strategies, " +
+                      (sharedPortfolio ? "shared portfolio" : "sub-accounts") + ")...");
+    setupAccounts();
+    historySeen.assign(accounts.size(), 0);
+    intrabar = IntrabarModel::fromSeries(*barSeries, intrabarPath);
+    if (intrabarPath != IntrabarPath::CLOSE && !intrabar.active()) {
+        if (barSeries->columnIndex(ColumnType::Close) >= 0 && !IntrabarModel::closeMarked(*barSeries)) {
+            Utils::logMessage("BacktestEngine Warning: INTRABAR_PATH needs the Close column at bar column " +
+                              std::to_string(BarSeries::PRICE_COLUMN) + " (the first after the timestamp), where prices are marked; using " +
+                              barSeries->columnName(BarSeries::PRICE_COLUMN) + " prices only.");
+        } else {
+            Utils::logMessage("BacktestEngine Warning: INTRABAR_PATH needs Open, High, Low and Close columns; using close prices only.");
+        }
+    }
+    slippageModel.resolveColumns(*barSeries);
+    const int volumeColumn = barSeries->columnIndex(ColumnType::Volume);
+    if (participationRate > 0.0 && volumeColumn < 0) {
+        Utils::logMessage("BacktestEngine Warning: PARTICIPATION_RATE needs a Volume column; fills are not capped.");
+    }
+    for (size_t a = 0; a < accounts.size(); ++a) {
+        accounts[a]->setClock(&clock);
+        accounts[a]->setIntrabarModel(intrabar);
+        // Each account draws its own noise stream
+        SlippageModel accountSlippage = slippageModel;
+        accountSlippage.seed += a;
+        accounts[a]->setCostModels(commissionModel, accountSlippage);
+        accounts[a]->setMarginLevels(marginCallLevel, maintenanceMargin);
+        accounts[a]->setParticipation(participationRate, volumeColumn);
+    }
+    // Timer ticks count from the first bar, so segments and resumed runs share them
+    clock.advanceTo((*bars)[startBar].timestamp);
+    timers.reset(bars->front().timestamp, clock.now());
+    for (size_t s = 0; s < strategies.size(); ++s) {
+        StrategySlot& slot = strategies[s];
+        slot.orderEvent = false;
+        slot.strategy->setBroker(slot.account); // Pass raw pointer
+        slot.strategy->setData(bars, primaryDataName); // Pass pointer to data and name
+        slot.strategy->setSeries(barSeries); // Columnar view for history/column spans
+        slot.strategy->setConfig(&config); // Pass pointer to config
+        slot.strategy->setClock(&clock);
+        slot.strategy->setTimers(&timers, static_cast<int>(s));
+    }
+
+    // --- Initialize Strategies ---
+    Utils::logMessage("BacktestEngine: Initializing strategies...");
+    for (auto& slot : strategies) {
+        try {
+            if (sharedPortfolio) broker->setActiveStrategy(slot.brokerStrategyId);
+            slot.strategy->init();
+        } catch (const std::exception& e) {
+            Utils::logMessage("BacktestEngine Error: Exception during " + slot.strategy->getName() + " init: " + std::string(e.what()));
+            return false; // Stop run if init fails
+        }
+        slot.warmup = slot.strategy->getRequiredWarmup();
+        if (slot.warmup > 0) {
+            Utils::logMessage("BacktestEngine: " + slot.strategy->getName() + " warm-up of " + std::to_string(slot.warmup) + " bars");
+        }
+    }
+    return true;
+}
+
+void BacktestEngine::replayIndicators(size_t fromBar, size_t toBar) {
+    for (size_t k = fromBar; k < toBar; ++k) {
+        for (auto& slot : strategies) {
+            if (!slot.strategy->hasIndicators()) continue;
+            slot.strategy->setBarIndex(k);
+            slot.strategy->updateIndicators((*bars)[k]);
+        }
+    }
+}
+
 void BacktestEngine::run() {
     Utils::logMessage("--- Starting Backtest Run ---");
     auto startTime = std::chrono::high_resolution_clock::now();
 
     // --- Pre-run Checks ---
-    if (historicalData.empty()) {
+    if (bars->empty()) {
         Utils::logMessage("BacktestEngine Error: Cannot run without historical data.");
         return;
     }
-    if (!strategy) {
+    if (strategies.empty()) {
         Utils::logMessage("BacktestEngine Error: Cannot run without a strategy set.");
         return;
     }
@@ -91,29 +877,156 @@ void BacktestEngine::run() {
         return;
     }
 
-    // --- Setup Links ---
-    Utils::logMessage("BacktestEngine: Linking components...");
-    strategy->setBroker(broker.get()); // Pass raw pointer
-    strategy->setData(&historicalData, primaryDataName); // Pass pointer to data and name
-    strategy->setConfig(&config); // Pass pointer to config
-    broker->setStrategy(strategy.get()); // Pass raw pointer
-
-    // --- Initialize Strategy ---
-    Utils::logMessage("BacktestEngine: Initializing strategy...");
-    try {
-        strategy->init();
-    } catch (const std::exception& e) {
-        Utils::logMessage("BacktestEngine Error: Exception during strategy init: " + std::string(e.what()));
-        return; // Stop run if init fails
+    stopReason.clear();
+    runStart = std::chrono::steady_clock::now();
+    budgetPeak = broker->getStartingCash();
+    budgetScanned = 0;
+    budgetOrigin = 0;
+
+    // --- Result Cache ---
+    uint64_t cacheKey = 0;
+    bool cacheResult = useResultCache;
+    for (const auto& slot : strategies) {
+        if (cacheResult && !slot.strategy->isDeterministic(config)) {
+            Utils::logMessage("BacktestEngine: " + slot.strategy->getName() + " is not deterministic, result cache not used.");
+            cacheResult = false;
+        }
+    }
+    if (cacheResult) {
+        cacheKey = resultCacheKey();
+        ResultCache cache(resultCacheDir);
+        if (cache.load(cacheKey, result)) {
+            equityCurve = result.equityCurve;
+            Utils::logMessage("BacktestEngine: Result cache hit, skipping simulation.");
+            if (!tradeLogPath.empty()) {
+                // Same files as the run that filled the entry: its rows, split by account
+                std::vector<TradeLedger> ledgers(result.accountOrders.size());
+                std::vector<const TradeLedger*> histories;
+                size_t row = 0;
+                for (size_t a = 0; a < ledgers.size(); ++a) {
+                    ledgers[a].reserve(result.accountOrders[a]);
+                    for (size_t n = 0; n < result.accountOrders[a]; ++n) ledgers[a].append(result.tradeLog[row++]);
+                    histories.push_back(&ledgers[a]);
+                }
+                exportTradeLog(histories);
+            }
+            Utils::logMessage("Portfolio Final Equity: " + std::to_string(result.finalValue));
+            return;
+        }
+    }
+
+    if (!initStrategies(0)) {
+        return;
     }
 
     // --- Main Backtest Loop ---
-    size_t totalBars = historicalData.size();
-    Utils::logMessage("Beginning backtest with " + std::to_string(totalBars) + " total bars");
-    
-    for (currentBarIndex = 0; currentBarIndex < totalBars; ++currentBarIndex) {
-        const Bar& currentBar = historicalData[currentBarIndex];
+    size_t totalBars = bars->size();
+    equityCurve.clear();
+    equityCurve.reserve(totalBars);
+
+    // --- Resume ---
+    size_t startBar = 0;
+    lastCheckpointBar = 0;
+    ledgerCount.assign(accounts.size(), 0);
+    ledgerBytes.assign(accounts.size(), 0);
+    equityWritten = 0;
+    dataHash = Utils::FNV_OFFSET_BASIS;
+    dataHashBars = 0;
+    if (resumeFromCheckpoint || incremental) {
+        try {
+            startBar = restoreCheckpoint();
+        } catch (const std::exception& e) {
+            Utils::logMessage("BacktestEngine Error: Failed to restore checkpoint: " + std::string(e.what()));
+            return;
+        }
+    }
+    if (startBar == 0 && (checkpointInterval > 0 || incremental)) {
+        resetLedgers(); // Fresh run: ledgers from an older run would be appended to
+    }
+    // Indicators are not part of the snapshot; rebuild them from the bars
+    replayIndicators(0, startBar);
+
+    Utils::logMessage("Beginning backtest with " + std::to_string(totalBars) + " total bars" +
+                      (fastForward ? " (fast-forward enabled)" : ""));
+    size_t skippedBars = 0;
+    bool segmented = false;
+    budgetOrigin = startBar;
+    if (segmentParallel) {
+        if (checkpointInterval > 0 || resumeFromCheckpoint || incremental) {
+            Utils::logMessage("BacktestEngine: Segment-parallel runs do not combine with checkpoints, running sequentially.");
+        } else {
+            size_t resumeBar = totalBars;
+            segmented = runSegments(skippedBars, resumeBar);
+            if (segmented && resumeBar < totalBars) {
+                skippedBars += simulate(resumeBar, totalBars);
+            }
+        }
+    }
+    if (!segmented) {
+        skippedBars = simulate(startBar, totalBars);
+    }
+
+    // --- Post-Loop ---
+    Utils::logMessage("BacktestEngine: Event loop finished.");
+    if (fastForward) {
+        Utils::logMessage("BacktestEngine: Fast-forwarded over " + std::to_string(skippedBars) + " of " + std::to_string(totalBars) + " bars");
+    }
+    const bool stopped = !stopReason.empty();
+    if (stopped) {
+        Utils::logMessage("BacktestEngine: Run stopped early at bar " + std::to_string(currentBarIndex) + ": " + stopReason);
+    }
+
+    // Snapshot before stop(): stop() flattens positions for reporting, and the
+    // next incremental run has to continue from the live state
+    if (incremental) {
+        saveCheckpoint(stopped ? currentBarIndex + 1 : totalBars);
+    }
+
+    // --- Final Strategy Calls ---
+    Utils::logMessage("BacktestEngine: Calling strategy stop()...");
+    for (auto& slot : strategies) {
+        try {
+            if (sharedPortfolio) broker->setActiveStrategy(slot.brokerStrategyId);
+            slot.strategy->stop();
+        } catch (const std::exception& e) {
+            Utils::logMessage("BacktestEngine Error: Exception during " + slot.strategy->getName() + " stop(): " + std::string(e.what()));
+        }
+    }
+
+    // --- Portfolio Summary ---
+    double lastPrice = (!stopped && bars->back().columns.size() > 1) ? bars->back().columns[1] : currentPrice;
+    if (!sharedPortfolio && accounts.size() > 1) {
+        for (const auto& slot : strategies) {
+            Utils::logMessage("Sub-account " + slot.strategy->getName() + ": Start " + std::to_string(slot.account->getStartingCash()) +
+                              ", Final " + std::to_string(slot.account->getValue(lastPrice)));
+        }
+    }
+    double finalValue = getPortfolioValue(lastPrice);
+    Utils::logMessage("Portfolio Final Equity: " + std::to_string(finalValue));
+    buildResult(finalValue);
+    if (!tradeLogPath.empty()) {
+        std::vector<const TradeLedger*> histories;
+        for (const Broker* account : accounts) histories.push_back(&account->getOrderHistory());
+        exportTradeLog(histories);
+    }
+    if (cacheResult && !stopped) { // A truncated run is not the result of this config
+        ResultCache(resultCacheDir).store(cacheKey, result);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = endTime - startTime;
+    Utils::logMessage("--- Backtest Run Finished ---");
+    Utils::logMessage("Total Execution Time: " + std::to_string(duration.count()) + " seconds");
+}
 
+size_t BacktestEngine::simulate(size_t startBar, size_t endBar) {
+    const size_t totalBars = bars->size();
+    size_t skippedBars = 0;
+    // Checks fall on the same bars when a run continues from a later bar
+    size_t nextBudgetCheck = budgetOrigin + ((startBar - budgetOrigin) / budgetCheckInterval + 1) * budgetCheckInterval;
+
+    for (currentBarIndex = startBar; currentBarIndex < endBar; ++currentBarIndex) {
+        const Bar& currentBar = (*bars)[currentBarIndex];
         if (currentBarIndex % 500 == 0) {
             Utils::logMessage("Processing bar " + std::to_string(currentBarIndex) + "/" + 
                               std::to_string(totalBars) + " - Date: " + Utils::timePointToString(currentBar.timestamp));
@@ -127,70 +1040,111 @@ void BacktestEngine::run() {
                 continue;
             }
             currentPrice= currentBar.columns[1];
+            clock.advanceTo(currentBar.timestamp);
             // Utils::logMessage("Updated price for " + primaryDataName + ": " + std::to_string(currentPrice));
         } catch (const std::exception& e) {
             Utils::logMessage("BacktestEngine Error: Exception updating prices: " + std::string(e.what()));
             continue; // Skip to next bar if we can't update prices
         }
 
-        // 2. Process broker orders based on current bar's data
-        bool brokerError = false;
-        try {
-            // Utils::logMessage("Processing broker orders...");
-            broker->processOrders(currentBar);
-        } catch (const std::exception& e) {
-            brokerError = true;
-            Utils::logMessage("BacktestEngine Error: Exception during broker processing: " + std::string(e.what()));
-            std::cerr << "Exception in broker processing: " << e.what() << std::endl;
-        } catch (...) {
-            brokerError = true;
-            Utils::logMessage("BacktestEngine Error: Unknown exception during broker processing");
-            std::cerr << "Unknown exception in broker processing" << std::endl;
+        // 2. Process broker orders based on current bar's data (once per account)
+        std::vector<Broker*> failedAccounts;
+        for (Broker* account : accounts) {
+            try {
+                // Utils::logMessage("Processing broker orders...");
+                account->processOrders(currentBar);
+            } catch (const std::exception& e) {
+                failedAccounts.push_back(account);
+                Utils::logMessage("BacktestEngine Error: Exception during broker processing: " + std::string(e.what()));
+                std::cerr << "Exception in broker processing: " << e.what() << std::endl;
+            } catch (...) {
+                failedAccounts.push_back(account);
+                Utils::logMessage("BacktestEngine Error: Unknown exception during broker processing");
+                std::cerr << "Unknown exception in broker processing" << std::endl;
+            }
         }
+        if (fastForward) collectOrderEvents();
 
-        // Skip strategy execution if broker processing had errors
-        if (brokerError) {
-            continue;
+        // 3. Timers that came due by this bar's time, earliest first
+        expiredTimers.clear();
+        timers.advance(clock.now(), expiredTimers);
+
+        // 4. Call each strategy's timers and next logic on the same bar
+        for (size_t s = 0; s < strategies.size(); ++s) {
+            StrategySlot& slot = strategies[s];
+            // Skip strategy execution if its broker processing had errors
+            if (std::find(failedAccounts.begin(), failedAccounts.end(), slot.account) != failedAccounts.end()) {
+                continue;
+            }
+            try {
+                slot.strategy->setBarIndex(currentBarIndex);
+                slot.strategy->updateIndicators(currentBar);
+                for (const TimerWheel::Expired& timer : expiredTimers) {
+                    if (timer.owner != static_cast<int>(s)) continue;
+                    if (sharedPortfolio) broker->setActiveStrategy(slot.brokerStrategyId);
+                    slot.strategy->onTimer(timer.id, timer.due);
+                }
+                // Indicators see warm-up bars, trading callbacks do not
+                if (currentBarIndex < slot.warmup) {
+                    continue;
+                }
+                if (fastForward && !isAwake(slot, currentBarIndex, currentPrice)) {
+                    continue;
+                }
+                slot.orderEvent = false;
+                if (sharedPortfolio) broker->setActiveStrategy(slot.brokerStrategyId);
+                slot.strategy->next(currentBar, currentBarIndex, currentPrice);
+            } catch (const std::exception& e) {
+                Utils::logMessage("BacktestEngine Error: Exception during " + slot.strategy->getName() + " next(): " + std::string(e.what()));
+                std::cerr << "Exception in strategy next(): " << e.what() << std::endl;
+            } catch (...) {
+                Utils::logMessage("BacktestEngine Error: Unknown exception during " + slot.strategy->getName() + " next()");
+                std::cerr << "Unknown exception in strategy next()" << std::endl;
+            }
         }
 
-        // 3. Call strategy's next logic
-        try {
-            // Reduce verbose logging for better performance
-            // if (currentBarIndex % 500 == 0) {
-            //     Utils::logMessage("Calling strategy->next for bar " + std::to_string(currentBarIndex));
-            // }
-            strategy->next(currentBar, currentBarIndex, currentPrice);
-            // if (currentBarIndex % 500 == 0) {
-            //     Utils::logMessage("Completed strategy->next call successfully");
-            // }
-        } catch (const std::exception& e) {
-            Utils::logMessage("BacktestEngine Error: Exception during strategy next(): " + std::string(e.what()));
-            std::cerr << "Exception in strategy next(): " << e.what() << std::endl;
-        } catch (...) {
-            Utils::logMessage("BacktestEngine Error: Unknown exception during strategy next()");
-            std::cerr << "Unknown exception in strategy next()" << std::endl;
-        }
-
-        // Add progress reporting - important for debugging but reduce frequency
-        // if (currentBarIndex % 500 == 0 || currentBarIndex == totalBars - 1) {
-        //     Utils::logMessage("Progress: Bar " + std::to_string(currentBarIndex + 1) + "/" + 
-        //                       std::to_string(totalBars) + " processed");
-        // }
-    } // End of main loop
+        // 5. Sample portfolio equity
+        equityCurve.push_back(getPortfolioValue(currentPrice));
 
-    // --- Post-Loop ---
-    Utils::logMessage("BacktestEngine: Event loop finished.");
+        // 6. Jump to the next bar that needs attention. Equity on skipped bars
+        // is linear in price because positions cannot change there.
+        if (fastForward) {
+            collectOrderEvents();
+            size_t nextBar = findNextActiveBar(currentBarIndex, endBar);
+            if (nextBar > currentBarIndex + 1) {
+                // Value at price 0 rather than equity minus the exposure, which is NaN after a NaN bar
+                double netSize = 0.0;
+                double base = 0.0;
+                for (const Broker* account : accounts) {
+                    netSize += account->getNetSize();
+                    base += account->getValue(0.0);
+                }
+                const double* prices = barSeries->prices();
+                for (size_t k = currentBarIndex + 1; k < nextBar; ++k) {
+                    // A NaN price gives a NaN sample, as the bar-by-bar loop records
+                    equityCurve.push_back(base + netSize * prices[k]);
+                    for (auto& slot : strategies) {
+                        if (!slot.strategy->hasIndicators()) continue;
+                        slot.strategy->setBarIndex(k);
+                        slot.strategy->updateIndicators((*bars)[k]);
+                    }
+                }
+                skippedBars += nextBar - currentBarIndex - 1;
+                currentBarIndex = nextBar - 1; // Loop increment lands on nextBar
+            }
+        }
 
-    // --- Final Strategy Call ---
-    Utils::logMessage("BacktestEngine: Calling strategy stop()...");
-    try {
-        strategy->stop();
-    } catch (const std::exception& e) {
-        Utils::logMessage("BacktestEngine Error: Exception during strategy stop(): " + std::string(e.what()));
-    }
+        // 7. Periodic snapshot of the state at the end of this bar
+        if (checkpointInterval > 0 && currentBarIndex + 1 < totalBars &&
+            currentBarIndex + 1 >= lastCheckpointBar + checkpointInterval) {
+            saveCheckpoint(currentBarIndex + 1);
+        }
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration = endTime - startTime;
-    Utils::logMessage("--- Backtest Run Finished ---");
-    Utils::logMessage("Total Execution Time: " + std::to_string(duration.count()) + " seconds");
-}
\ No newline at end of file
+        // 8. Budgets and early-stop rules, checked every few bars
+        if (currentBarIndex + 1 >= nextBudgetCheck) {
+            nextBudgetCheck = currentBarIndex + 1 + budgetCheckInterval;
+            if (budgetExceeded(currentBarIndex + 1 - budgetOrigin)) break;
+        }
+    } // End of main loop
+    return skippedBars;
+}
@@ -0,0 +1,111 @@
+// BarSeries.cpp
+#include "BarSeries.h"
+#include "Utils.h"
+#include <limits>
+#include <algorithm>
+
+BarSeries::BarSeries(const std::vector<Bar>& bars, const std::vector<ColumnSpec>& specs) {
+    size_t numCols = 0;
+    for (const auto& bar : bars) {
+        numCols = std::max(numCols, bar.columns.size());
+    }
+
+    // Parsers drop the timestamp field, so spec indices after it shift down by one
+    int timestampIndex = -1;
+    for (const auto& spec : specs) {
+        if (spec.type == ColumnType::Timestamp) {
+            timestampIndex = spec.index;
+            break;
+        }
+    }
+    names_.resize(numCols);
+    types_.assign(numCols, ColumnType::Extra);
+    for (const auto& spec : specs) {
+        if (spec.type == ColumnType::Timestamp || spec.index < 0) continue;
+        int col = spec.index - ((timestampIndex >= 0 && timestampIndex < spec.index) ? 1 : 0);
+        if (col < 0 || col >= static_cast<int>(numCols)) continue;
+        names_[col] = spec.name;
+        types_[col] = spec.type;
+    }
+    for (size_t c = 0; c < numCols; ++c) {
+        if (names_[c].empty()) names_[c] = "col" + std::to_string(c);
+    }
+
+    // Transpose
+    timestamps_.reserve(bars.size());
+    columns_.assign(numCols, std::vector<double>(bars.size(), std::numeric_limits<double>::quiet_NaN()));
+    for (size_t i = 0; i < bars.size(); ++i) {
+        timestamps_.push_back(bars[i].timestamp);
+        const auto& cols = bars[i].columns;
+        for (size_t c = 0; c < cols.size(); ++c) {
+            columns_[c][i] = cols[c];
+        }
+    }
+}
+
+int BarSeries::columnIndex(const std::string& name) const {
+    for (size_t c = 0; c < names_.size(); ++c) {
+        if (names_[c] == name) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+int BarSeries::columnIndex(ColumnType type) const {
+    for (size_t c = 0; c < types_.size(); ++c) {
+        if (types_[c] == type) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+size_t BarSeries::findCross(size_t col, size_t first, size_t last, double below, double above) const {
+    last = std::min(last, size());
+    if (first >= last || col >= columns_.size()) return last;
+    if (below == -std::numeric_limits<double>::infinity() && above == std::numeric_limits<double>::infinity()) {
+        return last; // Open band: nothing can cross
+    }
+
+    const double* values = columns_[col].data();
+    constexpr size_t BLOCK = 8;
+    size_t i = first;
+    for (; i + BLOCK <= last; i += BLOCK) {
+        int hit = 0;
+        for (size_t k = 0; k < BLOCK; ++k) {
+            hit |= (values[i + k] <= below) | (values[i + k] >= above);
+        }
+        if (hit) break;
+    }
+    for (; i < last; ++i) {
+        if (values[i] <= below || values[i] >= above) return i;
+    }
+    return last;
+}
+
+uint64_t BarSeries::hashRows(size_t first, size_t last, uint64_t seed) const {
+    uint64_t hash = seed;
+    last = std::min(last, size());
+    for (size_t i = first; i < last; ++i) {
+        int64_t timestamp = static_cast<int64_t>(timestamps_[i].time_since_epoch().count());
+        hash = Utils::fnv1a(&timestamp, sizeof(timestamp), hash);
+        for (const auto& column : columns_) {
+            hash = Utils::fnv1a(&column[i], sizeof(double), hash);
+        }
+    }
+    return hash;
+}
+
+uint64_t BarSeries::fingerprint() const {
+    return hashRows(0, size(), Utils::FNV_OFFSET_BASIS);
+}
+
+BarSeries BarSeries::head(size_t count) const {
+    count = std::min(count, size());
+    BarSeries prefix;
+    prefix.timestamps_.assign(timestamps_.begin(), timestamps_.begin() + count);
+    prefix.columns_.reserve(columns_.size());
+    for (const auto& column : columns_) {
+        prefix.columns_.emplace_back(column.begin(), column.begin() + count);
+    }
+    prefix.names_ = names_;
+    prefix.types_ = types_;
+    return prefix;
+}
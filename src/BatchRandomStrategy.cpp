@@ -0,0 +1,75 @@
+// BatchRandomStrategy.cpp
+#include "BatchRandomStrategy.h"
+#include "Config.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    // splitmix64 finalizer: cheap, stateless and branch-free
+    inline uint64_t mix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+}
+
+void BatchRandomStrategy::init(const std::vector<ParamSet>& params, const Config& config, const BarSeries& series) {
+    prices_ = series.prices();
+    if (!prices_) {
+        throw std::runtime_error("BatchRandomStrategy::init Error: Series has no price column");
+    }
+
+    const size_t n = params.size();
+    entryProbability_.resize(n);
+    size_.resize(n);
+    takeProfit_.resize(n);
+    stopLoss_.resize(n);
+    seed_.resize(n);
+    entryRef_.assign(n, 0.0);
+
+    for (size_t k = 0; k < n; ++k) {
+        double prob = param(params[k], "/Strategy/ENTRY_PROBABILITY", config, 0.01);
+        if (prob > 1.0) prob /= 100.0; // Same percentage convention as RandomStrategy
+        entryProbability_[k] = std::clamp(prob, 0.0, 1.0);
+        size_[k] = param(params[k], "/Strategy/BENCHMARK_FIXED_SIZE", config, 1.0);
+        if (size_[k] <= 0) size_[k] = 1.0;
+        takeProfit_[k] = std::abs(param(params[k], "/Strategy/TAKE_PROFIT_PIPS", config, 30.0));
+        stopLoss_[k] = std::abs(param(params[k], "/Strategy/STOP_LOSS_PIPS", config, 30.0));
+        // Distinct default stream per parameter set unless a seed is swept explicitly
+        double seed = param(params[k], "/Strategy/SEED", config, std::numeric_limits<double>::quiet_NaN());
+        if (std::isnan(seed)) {
+            std::string key = nlohmann::json(params[k]).dump();
+            seed_[k] = mix64(Utils::fnv1a(key.data(), key.size()));
+        } else {
+            seed_[k] = mix64(static_cast<uint64_t>(seed));
+        }
+    }
+    Utils::logMessage("BatchRandomStrategy: Initialized " + std::to_string(n) + " instances.");
+}
+
+void BatchRandomStrategy::next(size_t barIndex, const double* positions, double* targets) {
+    const double price = prices_[barIndex];
+    const uint64_t barKey = static_cast<uint64_t>(barIndex) * 0xD1B54A32D192ED03ULL;
+    const size_t n = entryRef_.size();
+
+    for (size_t k = 0; k < n; ++k) {
+        const uint64_t r = mix64(seed_[k] ^ barKey);
+        const double u = static_cast<double>(r >> 11) * 0x1.0p-53; // [0, 1)
+        const double dir = (r & 1) ? -1.0 : 1.0;
+        const double pos = positions[k];
+
+        // Flat: roll for a random-direction entry
+        const bool enter = (pos == 0.0) & (u < entryProbability_[k]);
+
+        // In position: exit once price moves TP/SL away from the entry reference
+        const double move = (pos > 0.0 ? 1.0 : -1.0) * (price - entryRef_[k]);
+        const bool exit = (pos != 0.0) & ((move >= takeProfit_[k]) | (-move >= stopLoss_[k]));
+
+        targets[k] = enter ? dir * size_[k] : (exit ? 0.0 : pos);
+        entryRef_[k] = enter ? price : entryRef_[k];
+    }
+}
@@ -0,0 +1,10 @@
+#include "BatchStrategy.h"
+#include "Config.h"
+
+double BatchStrategy::param(const ParamSet& params, const std::string& path, const Config& config, double defaultValue) {
+    auto it = params.find(path);
+    if (it != params.end() && it->second.is_number()) {
+        return it->second.get<double>();
+    }
+    return config.getNested<double>(path, defaultValue);
+}
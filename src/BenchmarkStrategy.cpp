@@ -3,7 +3,10 @@
 #include "Config.h"
 #include "Utils.h"
 #include "Order.h"
+#include "BinaryIO.h"
 #include <stdexcept>
+#include <limits>
+#include <algorithm>
 
  // // Trade 1: Buy 10 @100, Sell 10 @150 → profit 500
 // Trade 2: Buy 10 @120, Sell 10 @160 → profit 400
@@ -44,7 +47,25 @@ void BenchmarkStrategy::init() {
     entered3_ = exited3_ = false;
 }
 
+size_t BenchmarkStrategy::nextEventBar(size_t afterBar) const {
+    size_t next = std::numeric_limits<size_t>::max();
+    auto consider = [&](bool pending, size_t bar) {
+        if (pending && bar > afterBar) next = std::min(next, bar);
+    };
+    consider(!entered_, entryBar_);
+    consider(!exited_, exitBar_);
+    consider(!entered2_, entryBar2_);
+    consider(!exited2_, exitBar2_);
+    consider(!entered3_, entryBar3_);
+    consider(!exited3_, exitBar3_);
+    return next;
+}
+
 void BenchmarkStrategy::next(const Bar& currentBar, size_t currentBarIndex, const double currentPrices) {
+    // Nothing happens between the fixed trade bars (per-bar metrics are then
+    // only sampled on those bars when fast-forward is enabled)
+    sleepUntil(nextEventBar(currentBarIndex));
+
     // Open position at entry bar
     if (!entered_ && currentBarIndex == entryBar_) {
         double price = currentBar.columns[1];
@@ -64,6 +85,7 @@ void BenchmarkStrategy::next(const Bar& currentBar, size_t currentBarIndex, cons
     // Close position at exit bar
     else if (entered_ && !exited_ && currentBarIndex == exitBar_) {
         double price = currentBar.columns[1];
+        broker->cancelOrder(entryOrderId_); // An entry still filling would reopen the position
         Order exitOrder;
         exitOrder.type = OrderType::SELL;
         exitOrder.symbol = dataName;
@@ -97,6 +119,7 @@ void BenchmarkStrategy::next(const Bar& currentBar, size_t currentBarIndex, cons
         return;
     } else if (entered2_ && !exited2_ && currentBarIndex == exitBar2_) {
         double price = currentBar.columns[1];
+        broker->cancelOrder(entryOrderId2_);
         Order exitOrder2;
         exitOrder2.type = OrderType::SELL;
         exitOrder2.symbol = dataName;
@@ -125,6 +148,7 @@ void BenchmarkStrategy::next(const Bar& currentBar, size_t currentBarIndex, cons
         return;
     } else if (entered3_ && !exited3_ && currentBarIndex == exitBar3_) {
         double price = currentBar.columns[1];
+        broker->cancelOrder(entryOrderId3_);
         Order exitOrder3;
         exitOrder3.type = OrderType::SELL;
         exitOrder3.symbol = dataName;
@@ -178,6 +202,13 @@ void BenchmarkStrategy::stop() {
 }
 
 void BenchmarkStrategy::notifyOrder(const Order& order) {
+    // A partly filled entry (ACCEPTED with a fill) is open and still working
+    const bool partFilled = order.status == OrderStatus::ACCEPTED && order.filledSize != 0.0;
+    if (partFilled && order.reason == OrderReason::ENTRY_SIGNAL) {
+        entryPrice_ = order.filledPrice; // Average so far
+        Utils::logMessage("BenchmarkStrategy: Entry partly filled, " + std::to_string(order.filledSize) + " @ " + std::to_string(entryPrice_));
+        return;
+    }
     if (order.status == OrderStatus::FILLED) {
         if (order.reason == OrderReason::ENTRY_SIGNAL) {
             // Capture entry price for profit calc
@@ -193,4 +224,42 @@ void BenchmarkStrategy::notifyOrder(const Order& order) {
                 + (profitable ? " (PROFIT)" : " (LOSS)"));
         }
     }
-}
\ No newline at end of file
+}
+// Fixed trade bars come from config/constructor; only progress is saved
+void BenchmarkStrategy::saveState(BinaryWriter& writer) const {
+    writer.write(entered_);
+    writer.write(exited_);
+    writer.write(shares_);
+    writer.write(entryPrice_);
+    writer.write(static_cast<int32_t>(entryOrderId_));
+    writer.write(entered2_);
+    writer.write(exited2_);
+    writer.write(shares2_);
+    writer.write(entryPrice2_);
+    writer.write(static_cast<int32_t>(entryOrderId2_));
+    writer.write(entered3_);
+    writer.write(exited3_);
+    writer.write(shares3_);
+    writer.write(entryPrice3_);
+    writer.write(static_cast<int32_t>(entryOrderId3_));
+    metrics_->saveState(writer);
+}
+
+void BenchmarkStrategy::loadState(BinaryReader& reader) {
+    entered_ = reader.read<bool>();
+    exited_ = reader.read<bool>();
+    shares_ = reader.read<double>();
+    entryPrice_ = reader.read<double>();
+    entryOrderId_ = reader.read<int32_t>();
+    entered2_ = reader.read<bool>();
+    exited2_ = reader.read<bool>();
+    shares2_ = reader.read<double>();
+    entryPrice2_ = reader.read<double>();
+    entryOrderId2_ = reader.read<int32_t>();
+    entered3_ = reader.read<bool>();
+    exited3_ = reader.read<bool>();
+    shares3_ = reader.read<double>();
+    entryPrice3_ = reader.read<double>();
+    entryOrderId3_ = reader.read<int32_t>();
+    metrics_->loadState(reader);
+}
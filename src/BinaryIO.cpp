@@ -0,0 +1,123 @@
+// BinaryIO.cpp
+#include "BinaryIO.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+void BinaryWriter::writeBytes(const void* data, size_t size) {
+    out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+void BinaryWriter::writeString(const std::string& value) {
+    writeSize(value.size());
+    writeBytes(value.data(), value.size());
+}
+
+void BinaryWriter::writeTime(const std::chrono::system_clock::time_point& value) {
+    write(static_cast<int64_t>(value.time_since_epoch().count()));
+}
+
+void BinaryWriter::writeDoubles(const std::vector<double>& values) {
+    writeSize(values.size());
+    writeBytes(values.data(), values.size() * sizeof(double));
+}
+
+bool BinaryWriter::good() const {
+    return out_.good();
+}
+
+void BinaryReader::readBytes(void* data, size_t size) {
+    in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    if (static_cast<size_t>(in_.gcount()) != size) {
+        throw std::runtime_error("BinaryReader: Unexpected end of data");
+    }
+}
+
+std::string BinaryReader::readString() {
+    std::string value(readSize(), '\0');
+    readBytes(&value[0], value.size());
+    return value;
+}
+
+std::chrono::system_clock::time_point BinaryReader::readTime() {
+    return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(read<int64_t>()));
+}
+
+std::vector<double> BinaryReader::readDoubles() {
+    std::vector<double> values(readSize());
+    readBytes(values.data(), values.size() * sizeof(double));
+    return values;
+}
+
+// --- Record Helpers ---
+void writeOrder(BinaryWriter& writer, const Order& order) {
+    writer.write(static_cast<int32_t>(order.id));
+    writer.write(static_cast<int32_t>(order.type));
+    writer.write(static_cast<int32_t>(order.status));
+    writer.write(static_cast<int32_t>(order.reason));
+    writer.writeString(order.symbol);
+    writer.write(order.requestedSize);
+    writer.write(order.filledSize);
+    writer.write(order.requestedPrice);
+    writer.write(order.filledPrice);
+    writer.write(order.commission);
+    writer.write(order.realizedPnL);
+    writer.write(order.takeProfit);
+    writer.write(order.stopLoss);
+    writer.writeTime(order.creationTime);
+    writer.writeTime(order.executionTime);
+    writer.write(static_cast<int32_t>(order.strategyId));
+    writer.write(static_cast<int32_t>(order.kind));
+    writer.write(order.stopPrice);
+    writer.write(order.stopTriggered);
+}
+
+Order readOrder(BinaryReader& reader) {
+    Order order;
+    order.id = reader.read<int32_t>();
+    order.type = static_cast<OrderType>(reader.read<int32_t>());
+    order.status = static_cast<OrderStatus>(reader.read<int32_t>());
+    order.reason = static_cast<OrderReason>(reader.read<int32_t>());
+    order.symbol = reader.readString();
+    order.requestedSize = reader.read<double>();
+    order.filledSize = reader.read<double>();
+    order.requestedPrice = reader.read<double>();
+    order.filledPrice = reader.read<double>();
+    order.commission = reader.read<double>();
+    order.realizedPnL = reader.read<double>();
+    order.takeProfit = reader.read<double>();
+    order.stopLoss = reader.read<double>();
+    order.creationTime = reader.readTime();
+    order.executionTime = reader.readTime();
+    order.strategyId = reader.read<int32_t>();
+    order.kind = static_cast<OrderKind>(reader.read<int32_t>());
+    order.stopPrice = reader.read<double>();
+    order.stopTriggered = reader.read<bool>();
+    return order;
+}
+
+void writePosition(BinaryWriter& writer, const Position& position) {
+    writer.writeString(position.symbol);
+    writer.write(position.size);
+    writer.write(position.entryPrice);
+    writer.write(position.lastValue);
+    writer.write(position.pointValue);
+    writer.write(position.stopLoss);
+    writer.write(position.takeProfit);
+    writer.write(static_cast<int32_t>(position.strategyId));
+    writer.writeTime(position.entryTime);
+}
+
+Position readPosition(BinaryReader& reader) {
+    Position position;
+    position.symbol = reader.readString();
+    position.size = reader.read<double>();
+    position.entryPrice = reader.read<double>();
+    position.lastValue = reader.read<double>();
+    position.pointValue = reader.read<double>();
+    position.stopLoss = reader.read<double>();
+    position.takeProfit = reader.read<double>();
+    position.strategyId = reader.read<int32_t>();
+    position.entryTime = reader.readTime();
+    return position;
+}
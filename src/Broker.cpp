@@ -2,7 +2,10 @@
 #include "Broker.h"
 #include "Strategy.h"
 #include "Utils.h"    // For logging and pip point calculation
+#include "BinaryIO.h"
+#include "SimClock.h"
 #include <cmath>      // For std::abs, std::round etc.
+#include <algorithm>  // For std::min/max
 #include <stdexcept>  // For potential errors (though mostly handled via logging/rejection)
 #include <numeric>    // For std::accumulate
 #include <chrono>     // For random seed
@@ -14,13 +17,26 @@ Broker::Broker(double initialCash, double lev, double commRate) :
     cash(initialCash),
     leverage(lev > 0 ? lev : 1.0),
     commissionRate(commRate),
+    netSize(0.0),
+    grossSize(0.0),
+    costBasis(0.0),
+    markedValue(0.0),
+    markedExposure(0.0),
+    pricedSymbol(-1),
+    marginCallLevel(0.0),
+    maintenanceLevel(0.0),
+    liquidations(0),
+    cashHeadroom(std::numeric_limits<double>::infinity()),
+    cashBound(false),
+    participationRate(0.0),
+    volumeColumn(-1),
+    volumeLeft(0.0),
     nextOrderId(1),
-    strategy(nullptr)
-    // rng(static_cast<unsigned int>(
-    //     std::chrono::system_clock::now().time_since_epoch().count())
-    // )
-    // slippageDist(0.000, 0.000) // DISABLE slippage
+    strategy(nullptr),
+    activeStrategyId(-1),
+    clock(nullptr)
 {
+    commissionModel.rate = commRate;
     if (initialCash <= 0) {
         Utils::logMessage("Broker Warning: Initial cash is zero or negative."); // PROBABLY throw error
         initialCash = 1.0;
@@ -36,12 +52,24 @@ Broker::Broker() :
     cash(10000.0),
     leverage(1.0),
     commissionRate(0.0),
+    netSize(0.0),
+    grossSize(0.0),
+    costBasis(0.0),
+    markedValue(0.0),
+    markedExposure(0.0),
+    pricedSymbol(-1),
+    marginCallLevel(0.0),
+    maintenanceLevel(0.0),
+    liquidations(0),
+    cashHeadroom(std::numeric_limits<double>::infinity()),
+    cashBound(false),
+    participationRate(0.0),
+    volumeColumn(-1),
+    volumeLeft(0.0),
     nextOrderId(1),
-    strategy(nullptr)
-    // rng(static_cast<unsigned int>(
-    //     std::chrono::system_clock::now().time_since_epoch().count())
-    // )
-    // slippageDist(-0.002, 0.002) // ±0.2% slippage
+    strategy(nullptr),
+    activeStrategyId(-1),
+    clock(nullptr)
 {
     Utils::logMessage("Broker initialized with default values. Start Cash: 10000, Leverage: 1.0, Commission: 0.0");
 }
@@ -51,6 +79,48 @@ void Broker::setStrategy(Strategy* strat) {
     strategy = strat;
 }
 
+// --- Shared Portfolio ---
+int Broker::addStrategy(Strategy* strat, double allocation) {
+    if (allocation <= 0.0 || allocation > 1.0) {
+        Utils::logMessage("Broker Warning: Allocation " + std::to_string(allocation) + " out of range (0, 1]. Using 1.0.");
+        allocation = 1.0;
+    }
+    strategies.push_back(strat);
+    allocations.push_back(allocation);
+    return static_cast<int>(strategies.size()) - 1;
+}
+
+void Broker::clearStrategies() {
+    strategy = nullptr;
+    strategies.clear();
+    allocations.clear();
+    activeStrategyId = -1;
+}
+
+void Broker::setActiveStrategy(int strategyId) {
+    activeStrategyId = strategyId;
+}
+
+void Broker::notifyStrategy(const Order& order) {
+    if (order.strategyId >= 0 && order.strategyId < static_cast<int>(strategies.size())) {
+        // Orders it submits and positions it looks up while handling this are its own
+        const int active = activeStrategyId;
+        activeStrategyId = order.strategyId;
+        strategies[order.strategyId]->notifyOrder(order);
+        activeStrategyId = active;
+    } else if (strategy) {
+        strategy->notifyOrder(order);
+    }
+}
+
+double Broker::getAvailableCash(int strategyId, double price) const {
+    if (strategyId >= 0 && strategyId < static_cast<int>(allocations.size())) {
+        const double used = strategyId < static_cast<int>(usedMargins.size()) ? usedMargins[strategyId] : 0.0;
+        return std::min(cash, allocations[strategyId] * valueAt(price) - used);
+    }
+    return cash;
+}
+
 // --- Helpers ---
 double Broker::getFillPrice(const Bar& bar, OrderType /*orderType*/, double requestedPrice) const {
     // If a specific price is requested, use that price
@@ -58,7 +128,8 @@ double Broker::getFillPrice(const Bar& bar, OrderType /*orderType*/, double requ
         return requestedPrice;
     }
 
-    return bar.columns[1];
+    // Market orders fill at the open of the bar that processes them when bars carry a path
+    return bar.columns[intrabar.active() ? intrabar.open : intrabar.close];
 }
 
 double Broker::calculateMarginNeeded(double size, double price) const {
@@ -66,24 +137,132 @@ double Broker::calculateMarginNeeded(double size, double price) const {
     return std::abs(size * price) / leverage;
 }
 
-double Broker::calculateCommission(double size, double price) const {
-    // Calculate commission as a percentage of the trade value
-    // commissionRate is in percentage (e.g., 0.06 means 0.06%)
-    double tradeValue = std::abs(size) * price;
-    double commission = tradeValue * (commissionRate / 100.0);
+double Broker::getPointValue(const std::string&) const {
+    // TODO: actually calculate point value based on symbol
+    return 1.0;
+}
 
-    // Debug log to verify calculation
-    Utils::logMessage("Commission calculation: Size=" + std::to_string(std::abs(size)) +
-                     ", Price=" + std::to_string(price) +
-                     ", Rate=" + std::to_string(commissionRate) +
-                     "%, Result=" + std::to_string(commission));
+// --- Symbol Tables ---
+int Broker::ensureSymbol(const std::string& symbol) {
+    const int id = symbols.intern(symbol);
+    if (id >= static_cast<int>(slotIds.size())) {
+        slotIds.resize(id + 1);
+        prices.resize(id + 1, std::numeric_limits<double>::quiet_NaN());
+        holdings.resize(id + 1);
+        exits.resize(id + 1);
+        books.resize(id + 1);
+    }
+    return id;
+}
 
-    return commission;
+int Broker::positionSlot(int symbolId, int strategyId) {
+    std::vector<int>& ids = slotIds[symbolId];
+    const size_t k = static_cast<size_t>(strategyId + 1);
+    if (k >= ids.size()) ids.resize(k + 1, -1);
+    if (ids[k] < 0) {
+        ids[k] = static_cast<int>(positions.size());
+        positions.emplace_back();
+        openIndex.push_back(-1);
+    }
+    return ids[k];
 }
 
-double Broker::getPointValue(const std::string&) const {
-    // TODO: actually calculate point value based on symbol
-    return 1.0;
+int Broker::findSlot(int symbolId, int strategyId) const {
+    if (symbolId < 0 || symbolId >= static_cast<int>(slotIds.size())) return -1;
+    const std::vector<int>& ids = slotIds[symbolId];
+    const size_t k = static_cast<size_t>(strategyId + 1);
+    return k < ids.size() ? ids[k] : -1;
+}
+
+void Broker::markOpen(int slot) {
+    if (openIndex[slot] >= 0) return;
+    openIndex[slot] = static_cast<int>(openPositions.size());
+    openPositions.push_back(slot);
+    trackPosition(positions[slot], 1.0);
+    indexExits(slot);
+}
+
+void Broker::markFlat(int slot) {
+    const int index = openIndex[slot];
+    if (index < 0) return;
+    unindexExits(slot);
+    trackPosition(positions[slot], -1.0);
+    const int last = openPositions.back();
+    openPositions[index] = last;
+    openIndex[last] = index;
+    openPositions.pop_back();
+    openIndex[slot] = -1;
+    positions[slot] = Position();
+    if (openPositions.empty()) {
+        // Flat: drop the rounding the running totals picked up
+        netSize = 0.0;
+        grossSize = 0.0;
+        costBasis = 0.0;
+        markedValue = 0.0;
+        markedExposure = 0.0;
+        std::fill(usedMargins.begin(), usedMargins.end(), 0.0);
+    }
+}
+
+void Broker::trackPosition(const Position& position, double sign) {
+    double& price = prices[position.symbolId];
+    if (std::isnan(price)) price = position.entryPrice; // Filled before the symbol's first bar
+    netSize += sign * position.size;
+    grossSize += sign * std::abs(position.size);
+    costBasis += sign * position.entryPrice * position.size;
+    markedValue += sign * position.size * price;
+    markedExposure += sign * std::abs(position.size) * price;
+    Holding& holding = holdings[position.symbolId];
+    holding.open += sign > 0 ? 1 : -1;
+    if (holding.open == 0) {
+        holding = Holding();
+    } else {
+        holding.netSize += sign * position.size;
+        holding.grossSize += sign * std::abs(position.size);
+        holding.costBasis += sign * position.entryPrice * position.size;
+    }
+    if (position.strategyId >= 0) {
+        if (position.strategyId >= static_cast<int>(usedMargins.size())) usedMargins.resize(position.strategyId + 1, 0.0);
+        usedMargins[position.strategyId] += sign * calculateMarginNeeded(position.size, position.entryPrice);
+    }
+}
+
+void Broker::markPrice(int symbolId, double price) {
+    const Holding& holding = holdings[symbolId];
+    if (holding.open > 0) {
+        markedValue += holding.netSize * (price - prices[symbolId]);
+        markedExposure += holding.grossSize * (price - prices[symbolId]);
+    }
+    prices[symbolId] = price;
+}
+
+double Broker::valueAt(double price) const {
+    if (pricedSymbol < 0) return getValue(price);
+    const Holding& holding = holdings[pricedSymbol];
+    if (holding.open == 0) return getValue();
+    return getValue() + holding.netSize * (price - prices[pricedSymbol]);
+}
+
+double Broker::usedMarginAt(double price) const {
+    if (pricedSymbol < 0) return getUsedMargin(price);
+    const Holding& holding = holdings[pricedSymbol];
+    if (holding.open == 0) return getUsedMargin();
+    return (markedExposure + holding.grossSize * (price - prices[pricedSymbol])) / leverage;
+}
+
+void Broker::clearOrders() {
+    for (OrderHandle handle : pendingOrders) {
+        orderPool.release(handle);
+    }
+    pendingOrders.clear();
+    for (const auto& entry : restingOrders) {
+        orderPool.release(entry.second);
+    }
+    restingOrders.clear();
+    for (int symbolId : bookSymbols) {
+        books[symbolId] = TriggerBook();
+    }
+    bookSymbols.clear();
 }
 
 // --- Account Info ---
@@ -95,97 +274,58 @@ double Broker::getCash() const {
     return cash;
 }
 
-// calculate acc value including floating PnL
-double Broker::getValue(const double currentPrices) {
-    double totalValue = cash;
-    double positionsValue = 0.0;
-
-    for (const auto& pair : positions) {
-        const std::string& symbol = pair.first;
-        const Position& pos = pair.second;
-
-        // auto priceIt = currentPrices.find(symbol);
-        // if (priceIt != currentPrices.end()) {
-            // For short positions (negative size), PnL should be negative when current price > entry price
-            // positionsValue += pos.calculateUnrealizedPnL(priceIt->second);
-            positionsValue += pos.calculateUnrealizedPnL(currentPrices);
-
-            // Debug logging for significant positions to help troubleshoot
-            if (std::abs(pos.size) > 0.01) {
-                Utils::logMessage("Position PnL calculation: Symbol=" + symbol +
-                                 ", Size=" + std::to_string(pos.size) +
-                                 ", Entry=" + std::to_string(pos.entryPrice) +
-                                 ", Current=" + std::to_string(currentPrices) +
-                                 ", PnL=" + std::to_string(pos.calculateUnrealizedPnL(currentPrices)));
-            }
-        // } else {
-        //     // If price for an open position isn't available, we can't calculate its current value.
-        //     // Option 1: Log warning and exclude it (underestimates value).
-        //     // Option 2: Use last known price (might be stale).
-        //     // Option 3: Use entry price (assumes no change).
-        //     Utils::logMessage("Broker::getValue Warning: Current price for open position '" + symbol + "' not provided. Using entry value for PnL calculation (PnL = 0 for this asset).");
-        //     // Effectively adds 0 PnL for this asset in this case
-        //      // positionsValue += 0.0;
-        //       // Or try adding the original cost back? No, stick to PnL calculation method.
-        //       // Add the nominal entry value maybe? Needs careful thought. Let's stick to PnL calculation.
-        //       // Unrealized PnL calculation inherently handles this - if price isn't found, it cant calculate.
-        //       // Recalculate how getValue should work: Value = Cash + Sum(CurrentValue of Assets)
-        //       // CurrentValue = EntryCost + UnrealizedPnL
-        //       // Let's recalculate simpler: Value = Cash + Sum(Size * CurrentPrice)
-
-        //      // Alternative getValue: Sum of liquidation value
-        //      // positionsValue += pos.size * priceIt->second; // This calculates the current nominal value of the position asset
-        // }
-    }
-    // Correct approach: Account Value = Cash + Unrealized PnL
-    totalValue += positionsValue;
-    return totalValue;
-
-    /* --- Alternative getValue Calculation (Liquidation Value) ---
-    double liquidationValue = cash;
-    for (const auto& pair : positions) {
-        const std::string& symbol = pair.first;
-        const Position& pos = pair.second;
-        auto priceIt = currentPrices.find(symbol);
-        if (priceIt != currentPrices.end()) {
-            liquidationValue += pos.size * priceIt->second; // Add market value of holding
-        } else {
-             Utils::logMessage("Broker::getValue Warning: Current price for open position '" + symbol + "' not provided. Cannot include its market value in total.");
-        }
-    }
-    return liquidationValue;
-    */
-}
-
 // --- Helper: Reject Order ---
 void Broker::rejectOrder(Order& order, OrderStatus rejectionStatus, const Bar& executionBar) {
+    if (order.filledSize != 0.0) {
+        // Partly filled on earlier bars: the fills stand and the order ends at its filled size
+        order.status = OrderStatus::FILLED;
+        order.executionTime = executionBar.timestamp;
+        orderHistory.append(order);
+        notifyStrategy(order);
+        Utils::logMessage("Broker: Order " + std::to_string(order.id) + " remainder REJECTED (" + std::to_string(static_cast<int>(rejectionStatus)) +
+                          "), FILLED at " + std::to_string(order.filledSize) + " of " + std::to_string(order.requestedSize));
+        return;
+    }
     order.status = rejectionStatus;
     order.executionTime = executionBar.timestamp;
-    orderHistory.push_back(order); // Move to history
-    if (strategy) {
-        strategy->notifyOrder(order);
-    }
+    orderHistory.append(order); // Move to history
+    notifyStrategy(order);
     Utils::logMessage("Broker: Order " + std::to_string(order.id) + " REJECTED (" + std::to_string(static_cast<int>(rejectionStatus)) + ")"); // Log rejection reason
 }
 
 // --- Helper: Execute Open Order ---
 // Handles opening a new position or increasing an existing one
-void Broker::executeOpenOrder(Order& order, const Bar& executionBar) {
-    double fillPrice = getFillPrice(executionBar, order.type, order.requestedPrice);
+void Broker::executeOpenOrder(Order& order, const Bar& executionBar, double fillPrice, bool slip) {
+    // Size of this fill: what is left of the order, within the bar's volume
+    double fillSize = order.requestedSize - order.filledSize;
+    if (participationRate > 0) {
+        const double capacity = std::max(0.0, volumeLeft);
+        if (std::abs(fillSize) > capacity) fillSize = std::copysign(capacity, fillSize);
+        if (std::abs(fillSize) < 1e-9) return; // Bar volume used up; the order stays pending
+    }
+    if (slip) fillPrice = applySlippage(order, executionBar, fillPrice, std::abs(fillSize));
+
     if (fillPrice <= 0) {
         Utils::logMessage("Broker Warning: Invalid fill price for open order " + std::to_string(order.id));
         rejectOrder(order, OrderStatus::REJECTED, executionBar);
         return;
     }
 
-    double marginNeeded = calculateMarginNeeded(order.requestedSize, fillPrice);
-    double commission = calculateCommission(order.requestedSize, fillPrice);
+    double marginNeeded = calculateMarginNeeded(fillSize, fillPrice);
+    double commission = calculateCommission(fillSize, fillPrice);
+    double availableCash = getAvailableCash(order.strategyId, fillPrice);
 
     // --- Perform Checks ---
     bool checksPassed = true;
     OrderStatus rejectionStatus = OrderStatus::REJECTED;
-    if (marginNeeded > cash) {
-        Utils::logMessage("Broker: Open Order " + std::to_string(order.id) + " REJECTED (Margin). Needed: " + std::to_string(marginNeeded) + ", Cash: " + std::to_string(cash));
+    if (marginNeeded > availableCash) {
+        Utils::logMessage("Broker: Open Order " + std::to_string(order.id) + " REJECTED (Margin). Needed: " + std::to_string(marginNeeded) + ", Cash: " + std::to_string(availableCash));
+        rejectionStatus = OrderStatus::MARGIN;
+        checksPassed = false;
+    } else if (marginCallLevel > 0 &&
+               valueAt(fillPrice) - commission < marginCallLevel / 100.0 * (usedMarginAt(fillPrice) + marginNeeded)) {
+        Utils::logMessage("Broker: Open Order " + std::to_string(order.id) + " REJECTED (Margin call). Equity: " + std::to_string(valueAt(fillPrice)) +
+                          ", Used margin: " + std::to_string(usedMarginAt(fillPrice) + marginNeeded));
         rejectionStatus = OrderStatus::MARGIN;
         checksPassed = false;
     } else if (commission > cash - marginNeeded) {
@@ -195,46 +335,58 @@ void Broker::executeOpenOrder(Order& order, const Bar& executionBar) {
     }
 
     if (!checksPassed) {
+        cashBound = true; // More cash could have let it through
         rejectOrder(order, rejectionStatus, executionBar);
         return;
     }
+    cashHeadroom = std::min({cashHeadroom, availableCash - marginNeeded, cash - marginNeeded - commission});
+    if (marginCallLevel > 0) {
+        cashHeadroom = std::min(cashHeadroom, valueAt(fillPrice) - commission - marginCallLevel / 100.0 * (usedMarginAt(fillPrice) + marginNeeded));
+    }
 
     // --- Checks Passed - Apply Execution ---
-    order.status = OrderStatus::FILLED;
-    order.filledPrice = fillPrice;
-    order.filledSize = order.requestedSize; // Assume full fill for open orders
-    order.commission = commission;
+    const double filledBefore = std::abs(order.filledSize);
+    order.filledPrice = filledBefore > 0 ? (order.filledPrice * filledBefore + fillPrice * std::abs(fillSize)) / (filledBefore + std::abs(fillSize))
+                                         : fillPrice;
+    order.filledSize += fillSize;
+    order.commission += commission;
     order.executionTime = executionBar.timestamp;
+    const bool done = std::abs(order.filledSize) >= std::abs(order.requestedSize) * (1.0 - 1e-12);
+    order.status = done ? OrderStatus::FILLED : OrderStatus::ACCEPTED;
+    if (participationRate > 0) volumeLeft -= std::abs(fillSize);
 
-    cash -= order.commission; // Deduct commission
+    cash -= commission; // Deduct commission
 
     // Find if position exists to increase it
-    Position* existingPosition = nullptr;
-    auto posIt = positions.find(order.symbol);
-    if (posIt != positions.end()) {
-        existingPosition = &(posIt->second);
-    }
+    const int slot = positionSlot(order.symbolId, order.strategyId);
+    Position* existingPosition = isOpen(slot) ? &positions[slot] : nullptr;
 
     if (existingPosition) { // Increase existing position
-        Utils::logMessage("Broker: Increasing position " + order.symbol + ". Added Size: " + std::to_string(order.filledSize));
+        Utils::logMessage("Broker: Increasing position " + order.symbol + ". Added Size: " + std::to_string(fillSize));
         double currentSize = existingPosition->size;
         double currentEntry = existingPosition->entryPrice;
-        double newSize = currentSize + order.filledSize;
+        double newSize = currentSize + fillSize;
+        unindexExits(slot); // Stop loss validity depends on the entry price
+        trackPosition(*existingPosition, -1.0);
         // Calculate new average entry price
-        existingPosition->entryPrice = ((currentSize * currentEntry) + (order.filledSize * fillPrice)) / newSize;
+        existingPosition->entryPrice = ((currentSize * currentEntry) + (fillSize * fillPrice)) / newSize;
         existingPosition->size = newSize;
+        trackPosition(*existingPosition, 1.0);
         existingPosition->lastValue = std::abs(newSize * existingPosition->entryPrice);
         // SL/TP might need recalculation/management by strategy after notification
          Utils::logMessage("Broker: New position size " + std::to_string(newSize) + ", Avg Entry: " + std::to_string(existingPosition->entryPrice));
+        indexExits(slot);
 
     } else { // Create new position
         Position newPos;
         newPos.symbol = order.symbol;
-        newPos.size = order.filledSize;
+        newPos.symbolId = order.symbolId;
+        newPos.size = fillSize;
         newPos.entryPrice = fillPrice;
         newPos.entryTime = order.executionTime;
         newPos.pointValue = getPointValue(order.symbol);
         newPos.lastValue = std::abs(newPos.size * newPos.entryPrice);
+        newPos.strategyId = order.strategyId;
         // Set SL/TP based *on the order* if provided, otherwise strategy manages
         // Validate SL/TP values before setting them
         if (newPos.size > 0) { // Long position
@@ -272,7 +424,8 @@ void Broker::executeOpenOrder(Order& order, const Bar& executionBar) {
                 newPos.takeProfit = newPos.entryPrice * 0.99; // 1% below entry price as a fallback
             }
         }
-        positions[order.symbol] = newPos;
+        positions[slot] = newPos;
+        markOpen(slot);
 
         std::string direction = (newPos.size > 0) ? "LONG" : "SHORT";
         Utils::logMessage("Broker: Opening " + direction + " position " + order.symbol +
@@ -280,27 +433,19 @@ void Broker::executeOpenOrder(Order& order, const Bar& executionBar) {
                          ", Entry: " + std::to_string(newPos.entryPrice) +
                          ", SL: " + std::to_string(newPos.stopLoss) +
                          ", TP: " + std::to_string(newPos.takeProfit) +
-                         ", Commission: " + std::to_string(order.commission) +
+                         ", Commission: " + std::to_string(commission) +
                          ", - Date: " + Utils::timePointToString(executionBar.timestamp));
     }
 
     // --- Finalize ---
-    orderHistory.push_back(order);
-    if (strategy) {
-        strategy->notifyOrder(order);
-    }
+    // A partly filled order is notified per fill and recorded once it is done
+    if (done) orderHistory.append(order);
+    notifyStrategy(order);
 }
 
 // --- Helper: Execute Close Order ---
 // Handles closing, reducing, or reversing a position
-void Broker::executeCloseOrder(Order& order, Position& existingPosition, const Bar& executionBar) {
-     double fillPrice = getFillPrice(executionBar, order.type, order.requestedPrice);
-    if (fillPrice <= 0) {
-        Utils::logMessage("Broker Warning: Invalid fill price for close order " + std::to_string(order.id));
-        rejectOrder(order, OrderStatus::REJECTED, executionBar);
-        return;
-    }
-
+void Broker::executeCloseOrder(Order& order, Position& existingPosition, const Bar& executionBar, double fillPrice, bool slip) {
     // Determine actual size to close (cannot close more than exists)
     double sizeToClose;
     // If order closes the existing position (SELL on long, BUY on short), always close entire
@@ -315,21 +460,30 @@ void Broker::executeCloseOrder(Order& order, Position& existingPosition, const B
          rejectOrder(order, OrderStatus::REJECTED, executionBar);
          return;
     }
+    if (slip) fillPrice = applySlippage(order, executionBar, fillPrice, sizeToClose);
+    if (fillPrice <= 0) {
+        Utils::logMessage("Broker Warning: Invalid fill price for close order " + std::to_string(order.id));
+        rejectOrder(order, OrderStatus::REJECTED, executionBar);
+        return;
+    }
 
     double commission = calculateCommission(sizeToClose, fillPrice);
 
     // --- Perform Checks ---
     bool checksPassed = true;
     OrderStatus rejectionStatus = OrderStatus::REJECTED;
-    if (commission > cash) { // Simple check for closing orders
+    // Simple check for closing orders; a liquidation goes through regardless
+    if (commission > cash && order.reason != OrderReason::BANKRUPTCY_PROTECTION) {
         Utils::logMessage("Broker: Close Order " + std::to_string(order.id) + " REJECTED (Cash for Commission). Comm: " + std::to_string(commission) + ", Cash: " + std::to_string(cash));
         checksPassed = false;
     }
 
     if (!checksPassed) {
+        cashBound = true;
         rejectOrder(order, rejectionStatus, executionBar);
         return;
     }
+    if (order.reason != OrderReason::BANKRUPTCY_PROTECTION) cashHeadroom = std::min(cashHeadroom, cash - commission);
 
     // --- Checks Passed - Apply Execution ---
     order.status = OrderStatus::FILLED;
@@ -339,6 +493,7 @@ void Broker::executeCloseOrder(Order& order, Position& existingPosition, const B
     order.executionTime = executionBar.timestamp;
 
     cash -= order.commission; // Deduct commission
+    if (participationRate > 0) volumeLeft -= sizeToClose;
 
     // --- Calculate PnL on the closed portion ---
     double closedQty = sizeToClose;
@@ -346,6 +501,7 @@ void Broker::executeCloseOrder(Order& order, Position& existingPosition, const B
         ? (fillPrice - existingPosition.entryPrice) * closedQty
         : (existingPosition.entryPrice - fillPrice) * closedQty;
     cash += pnl; // Add realized P/L to cash
+    order.realizedPnL = pnl;
 
     // --- Update Position Size ---
     double newPositionSize;
@@ -367,7 +523,7 @@ void Broker::executeCloseOrder(Order& order, Position& existingPosition, const B
                             + ", Exit: " + std::to_string(fillPrice)
                             + ", PnL: " + std::to_string(pnl) + " [" + pnlCalcStr + "]"
                             + ", Commission: " + std::to_string(order.commission));
-        positions.erase(order.symbol); // Remove from map
+        markFlat(positionSlot(existingPosition.symbolId, existingPosition.strategyId)); // Clears the table entry
     } else { // Position reduced (partial close)
         std::string direction = (existingPosition.size > 0) ? "LONG" : "SHORT";
         std::string pnlCalcStr = (existingPosition.size > 0) ?
@@ -378,166 +534,102 @@ void Broker::executeCloseOrder(Order& order, Position& existingPosition, const B
                             + ", Entry: " + std::to_string(existingPosition.entryPrice)
                             + ", Exit: " + std::to_string(fillPrice)
                             + ", PnL: " + std::to_string(pnl) + " [" + pnlCalcStr + "]");
+        trackPosition(existingPosition, -1.0);
         existingPosition.size = newPositionSize; // Update remaining size
+        trackPosition(existingPosition, 1.0);
         // Entry price, SL/TP remain the same for the remaining portion
         Utils::logMessage("Broker: Remaining position " + order.symbol + ". Size: " + std::to_string(newPositionSize));
     }
 
     // --- Finalize ---
-    orderHistory.push_back(order);
-    if (strategy) {
-        strategy->notifyOrder(order);
-    }
+    orderHistory.append(order);
+    notifyStrategy(order);
 }
 
-// Apply random slippage to price
-// double Broker::applySlippage(double basePrice, bool isFavorable) {
-//     // Generate random slippage factor
-//     double slippageFactor = slippageDist(rng);
-
-//     // If not favorable, ensure slippage is only negative (worse for trader)
-//     if (!isFavorable && slippageFactor > 0) {
-//         slippageFactor = -slippageFactor;
-//     }
-//     // If favorable, ensure slippage is only positive (better for trader)
-//     else if (isFavorable && slippageFactor < 0) {
-//         slippageFactor = -slippageFactor;
-//     }
-
-//     // Apply slippage to base price
-//     double slippagePrice = basePrice * (1.0 + slippageFactor);
-
-//     // Log the slippage calculation for debugging
-//     Utils::logMessage("Broker: Slippage calculation - Base price: " + std::to_string(basePrice) +
-//                      ", Factor: " + std::to_string(slippageFactor) +
-//                      ", Result: " + std::to_string(slippagePrice) +
-//                      ", Favorable: " + (isFavorable ? "true" : "false"));
-
-//     return slippagePrice;
-// }
 
 // Check if positions hit take profit or stop loss levels
-void Broker::checkTakeProfitStopLoss(const Bar& currentBar, const std::map<std::string, double>& currentPrices) {
+void Broker::checkTakeProfitStopLoss(const Bar& currentBar, double low, double high, double from) {
     try {
-        // Iterate through all open positions
-        for (auto posIt = positions.begin(); posIt != positions.end(); /* no increment */) {
-            const std::string& symbol = posIt->first;
-            Position& position = posIt->second;
-
-            // Skip positions with no TP/SL set
-            if (position.takeProfit <= 0.0 && position.stopLoss <= 0.0) {
-                ++posIt;
-                continue;
-            }
-
-            // Get current price
-            auto priceIt = currentPrices.find(symbol);
-            if (priceIt == currentPrices.end()) {
-                Utils::logMessage("Broker::checkTakeProfitStopLoss Warning: No price found for symbol '" + symbol + "'");
-                ++posIt;
-                continue;
+        // Only the levels inside the bar's range are visited
+        exitsHit.clear();
+        auto collect = [this, low, high](const ExitIndex& index) {
+            for (auto it = index.rising.begin(); it != index.rising.end() && it->first <= high; ++it) {
+                exitsHit.push_back(it->second);
             }
-
-            double currentPrice = priceIt->second;
-            bool tpHit = false, slHit = false;
-            OrderReason closeReason = OrderReason::EXIT_SIGNAL; // Default
-
-        // Check if TP/SL hit
-        if (position.size > 0) { // Long position
-            if (position.takeProfit > 0 && currentPrice >= position.takeProfit) {
-                tpHit = true;
-                closeReason = OrderReason::TAKE_PROFIT;
-                Utils::logMessage("Broker: Take Profit hit for LONG position in " + symbol +
-                                 ". Current price: " + std::to_string(currentPrice) +
-                                 ", TP level: " + std::to_string(position.takeProfit));
-            } else if (position.stopLoss > 0 && position.stopLoss < position.entryPrice && currentPrice <= position.stopLoss) {
-                slHit = true;
-                closeReason = OrderReason::STOP_LOSS;
-            } else if (position.stopLoss > 0 && position.stopLoss >= position.entryPrice) {
-                // Log warning for incorrectly set stop loss
-                Utils::logMessage("Broker Warning: Stop loss (" + std::to_string(position.stopLoss) +
-                                 ") for long position in " + symbol +
-                                 " is above entry price (" + std::to_string(position.entryPrice) +
-                                 "). Stop loss should be below entry price for long positions.");
-                // Invalidate the stop loss
-                position.stopLoss = 0.0;
+            for (auto it = index.falling.begin(); it != index.falling.end() && it->first >= low; ++it) {
+                exitsHit.push_back(it->second);
             }
-        } else if (position.size < 0) { // Short position
-            if (position.takeProfit > 0 && currentPrice <= position.takeProfit) {
-                tpHit = true;
-                closeReason = OrderReason::TAKE_PROFIT;
-                Utils::logMessage("Broker: Take Profit hit for SHORT position in " + symbol +
-                                 ". Current price: " + std::to_string(currentPrice) +
-                                 ", TP level: " + std::to_string(position.takeProfit));
-            } else if (position.stopLoss > 0 && position.stopLoss > position.entryPrice && currentPrice >= position.stopLoss) {
-                slHit = true;
-                closeReason = OrderReason::STOP_LOSS;
-            } else if (position.stopLoss > 0 && position.stopLoss <= position.entryPrice) {
-                // Log warning for incorrectly set stop loss
-                Utils::logMessage("Broker Warning: Stop loss (" + std::to_string(position.stopLoss) +
-                                 ") for short position in " + symbol +
-                                 " is below entry price (" + std::to_string(position.entryPrice) +
-                                 "). Stop loss should be above entry price for short positions.");
-                // Invalidate the stop loss
-                position.stopLoss = 0.0;
+        };
+        if (pricedSymbol >= 0) {
+            collect(exits[pricedSymbol]);
+        } else {
+            for (size_t k = 0; k < exitSymbols.size(); /* no increment */) {
+                ExitIndex& index = exits[exitSymbols[k]];
+                if (index.empty()) { // Its positions have closed since
+                    index.listed = false;
+                    exitSymbols[k] = exitSymbols.back();
+                    exitSymbols.pop_back();
+                    continue;
+                }
+                collect(index);
+                ++k;
             }
         }
+        if (exitsHit.empty()) return;
+        if (std::isnan(from)) {
+            // Symbol order, take profit first when a wide bar reached both levels
+            std::sort(exitsHit.begin(), exitsHit.end(), [](const ExitRef& a, const ExitRef& b) {
+                return a.slot != b.slot ? a.slot < b.slot : a.takeProfit > b.takeProfit;
+            });
+        } else {
+            // Along a leg, levels are reached in order of distance from its start;
+            // levels it starts beyond (gapped through) come first
+            auto reach = [this, from](const ExitRef& ref) {
+                const Position& position = positions[ref.slot];
+                const double level = ref.takeProfit ? position.takeProfit : position.stopLoss;
+                const bool rising = (position.size > 0) == ref.takeProfit;
+                return std::max(0.0, rising ? level - from : from - level);
+            };
+            std::stable_sort(exitsHit.begin(), exitsHit.end(), [&reach](const ExitRef& a, const ExitRef& b) {
+                const double ra = reach(a);
+                const double rb = reach(b);
+                return ra != rb ? ra < rb : a.slot < b.slot;
+            });
+        }
 
-        // If TP/SL hit, create and execute close order
-        if (tpHit || slHit) {
-            OrderType closeType = (position.size > 0) ? OrderType::SELL : OrderType::BUY;
+        // All of them close on this bar; closing only unindexes the position's own levels
+        for (size_t k = 0; k < exitsHit.size(); ++k) {
+            const ExitRef hit = exitsHit[k];
+            if (!isOpen(hit.slot)) continue; // Other level of a position already handled
+            Position& position = positions[hit.slot];
+            const bool rising = (position.size > 0) == hit.takeProfit;
 
-            // Create a market order to close the position
+            // Create a market order to close the position at the level
+            const OrderType closeType = (position.size > 0) ? OrderType::SELL : OrderType::BUY;
             Order closeOrder;
             closeOrder.id = nextOrderId++;
             closeOrder.type = closeType;
-            closeOrder.symbol = symbol;
+            closeOrder.symbol = position.symbol;
+            closeOrder.symbolId = position.symbolId;
             closeOrder.requestedSize = std::abs(position.size);
             closeOrder.status = OrderStatus::SUBMITTED;
-            closeOrder.reason = closeReason;
-            closeOrder.creationTime = std::chrono::system_clock::now();
-
-            // Apply slippage to the price (favorable for TP, unfavorable for SL)
-            double targetPrice = tpHit ? position.takeProfit : position.stopLoss;
-
-            // For long positions with TP, slippage should be favorable (higher price)
-            // For short positions with TP, slippage should be favorable (lower price)
-            // For SL, slippage is always unfavorable
-            // bool isFavorable = tpHit;
-
-            // DONT ENABLE SLIPPAGE
-            // double slippagePrice = applySlippage(targetPrice, isFavorable);
-            // closeOrder.requestedPrice = slippagePrice;
-            closeOrder.requestedPrice = targetPrice;
-
-            // Log the slippage calculation for debugging
-            // std::string orderTypeStr = tpHit ? "TAKE PROFIT" : "STOP LOSS";
-            // Utils::logMessage("Broker: Applied slippage to " + orderTypeStr +
-                            //  " price. Original: " + std::to_string(targetPrice) +
-                            //  ", After slippage: " + std::to_string(closeOrder.requestedPrice));
-
-            std::ostringstream oss;
-            oss << "Broker: Auto-executing "
-                << (tpHit ? "TAKE PROFIT" : "STOP LOSS")
-                << " order for " << symbol
-                << " at price " << closeOrder.requestedPrice
-                << " (original target: " << targetPrice << ")";
-            Utils::logMessage(oss.str());
-
-            // Execute the order
-            executeCloseOrder(closeOrder, position, currentBar);
-            // Note: executeCloseOrder already adds the order to orderHistory and notifies the strategy
-            // So we don't need to do it again here
-
-            // If position was fully closed, the iterator is invalid
-            // Note: executeCloseOrder already removes the position from the map if it's fully closed
-            // So we don't need to check position.size here, just break out of the loop
-            // since we've modified the positions map and the iterator might be invalid
-            break; // Exit the loop after closing a position
-        } else {
-            ++posIt;
+            closeOrder.reason = hit.takeProfit ? OrderReason::TAKE_PROFIT : OrderReason::STOP_LOSS;
+            closeOrder.strategyId = position.strategyId;
+            closeOrder.creationTime = currentBar.timestamp; // Triggered by this bar
+            // No slippage: TP and SL fill exactly at their level, or where a leg
+            // that starts beyond it (a gap at the open) begins
+            closeOrder.requestedPrice = hit.takeProfit ? position.takeProfit : position.stopLoss;
+            if (!std::isnan(from)) {
+                closeOrder.requestedPrice = rising ? std::max(closeOrder.requestedPrice, from)
+                                                   : std::min(closeOrder.requestedPrice, from);
+            }
+
+            Utils::logMessage("Broker: Auto-executing " + std::string(hit.takeProfit ? "TAKE PROFIT" : "STOP LOSS") +
+                              " order for " + position.symbol + " at price " + std::to_string(closeOrder.requestedPrice));
+
+            // Adds the order to orderHistory, notifies the strategy and unindexes the position once flat
+            executeCloseOrder(closeOrder, position, currentBar, getFillPrice(currentBar, closeType, closeOrder.requestedPrice));
         }
-    }
     } catch (const std::exception& e) {
         Utils::logMessage("Broker::checkTakeProfitStopLoss Error: Exception caught: " + std::string(e.what()));
     } catch (...) {
@@ -545,10 +637,132 @@ void Broker::checkTakeProfitStopLoss(const Bar& currentBar, const std::map<std::
     }
 }
 
+void Broker::checkMargin(const Bar& currentBar, double low, double high, double from) {
+    try {
+        while (!openPositions.empty()) {
+            // The cushion is linear in price, so the leg's worst price is one of its ends
+            const double worst = marginSlope() >= 0 ? low : high;
+            const double cushion = marginCushion(worst);
+            if (cushion >= 0) {
+                cashHeadroom = std::min(cashHeadroom, cushion);
+                return;
+            }
+
+            double price = worst;
+            if (!std::isnan(from)) {
+                const double level = liquidationPrice();
+                if (marginCushion(from) < 0) price = from; // Already short where the leg starts (a gap)
+                else if (!std::isnan(level)) price = std::min(std::max(level, low), high);
+            }
+
+            // Largest notional first: it frees the most margin. One in a
+            // symbol this bar does not price fills at that symbol's latest price.
+            auto notional = [this, price](int id) {
+                const Position& open = positions[id];
+                return std::abs(open.size) * (isPriced(open.symbolId) ? price : prices[open.symbolId]);
+            };
+            int slot = openPositions.front();
+            for (int id : openPositions) {
+                const double size = notional(id);
+                const double largest = notional(slot);
+                if (size > largest || (size == largest && id < slot)) slot = id;
+            }
+            Position& position = positions[slot];
+
+            Order closeOrder;
+            closeOrder.id = nextOrderId++;
+            closeOrder.type = position.size > 0 ? OrderType::SELL : OrderType::BUY;
+            closeOrder.symbol = position.symbol;
+            closeOrder.symbolId = position.symbolId;
+            closeOrder.requestedSize = std::abs(position.size);
+            closeOrder.status = OrderStatus::SUBMITTED;
+            closeOrder.reason = OrderReason::BANKRUPTCY_PROTECTION;
+            closeOrder.strategyId = position.strategyId;
+            closeOrder.creationTime = currentBar.timestamp;
+
+            Utils::logMessage("Broker: LIQUIDATING " + position.symbol + " at price " + std::to_string(price) +
+                              ". Equity: " + std::to_string(valueAt(price)) + ", Used margin: " + std::to_string(usedMarginAt(price)) +
+                              ", Maintenance: " + std::to_string(maintenanceLevel) + "%");
+            liquidations++;
+            cashBound = true; // The liquidation price moves with the cash
+            if (!isPriced(position.symbolId)) price = prices[position.symbolId];
+            // Filled as a market order; adds it to the history and notifies the strategy
+            executeCloseOrder(closeOrder, position, currentBar, price, true);
+            if (isOpen(slot)) return; // Close was rejected; retrying would not change anything
+        }
+    } catch (const std::exception& e) {
+        Utils::logMessage("Broker::checkMargin Error: Exception caught: " + std::string(e.what()));
+    } catch (...) {
+        Utils::logMessage("Broker::checkMargin Error: Unknown exception caught");
+    }
+}
+
+double Broker::marginSlope() const {
+    if (pricedSymbol < 0) return netSize - maintenanceLevel / 100.0 * grossSize / leverage;
+    const Holding& holding = holdings[pricedSymbol];
+    return holding.netSize - maintenanceLevel / 100.0 * holding.grossSize / leverage;
+}
+
+double Broker::liquidationPrice() const {
+    // cushion(0) + slope * price = 0
+    const double slope = marginSlope();
+    if (slope == 0.0) return std::numeric_limits<double>::quiet_NaN();
+    return -marginCushion(0.0) / slope;
+}
+
+void Broker::indexExits(int slot) {
+    Position& position = positions[slot];
+    const bool isLong = position.size > 0;
+    // A stop on the wrong side of the entry (e.g. after averaging in) would
+    // fire immediately; it is dropped instead
+    if (position.stopLoss > 0 && (isLong ? position.stopLoss >= position.entryPrice : position.stopLoss <= position.entryPrice)) {
+        Utils::logMessage("Broker Warning: Stop loss (" + std::to_string(position.stopLoss) + ") for " +
+                          (isLong ? "long" : "short") + " position in " + position.symbol + " is on the wrong side of entry price (" +
+                          std::to_string(position.entryPrice) + "). Stop loss removed.");
+        position.stopLoss = 0.0;
+    }
+    ExitIndex& index = exits[position.symbolId];
+    if (position.takeProfit > 0) {
+        if (isLong) index.rising.emplace(position.takeProfit, ExitRef{slot, true});
+        else index.falling.emplace(position.takeProfit, ExitRef{slot, true});
+    }
+    if (position.stopLoss > 0) {
+        if (isLong) index.falling.emplace(position.stopLoss, ExitRef{slot, false});
+        else index.rising.emplace(position.stopLoss, ExitRef{slot, false});
+    }
+    if (!index.listed && !index.empty()) {
+        index.listed = true;
+        exitSymbols.push_back(position.symbolId);
+    }
+}
+
+void Broker::unindexExits(int slot) {
+    const Position& position = positions[slot];
+    auto eraseFrom = [slot](auto& index, double level) {
+        auto range = index.equal_range(level);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.slot == slot) {
+                index.erase(it);
+                return;
+            }
+        }
+    };
+    const bool isLong = position.size > 0;
+    ExitIndex& index = exits[position.symbolId];
+    if (position.takeProfit > 0) {
+        if (isLong) eraseFrom(index.rising, position.takeProfit);
+        else eraseFrom(index.falling, position.takeProfit);
+    }
+    if (position.stopLoss > 0) {
+        if (isLong) eraseFrom(index.falling, position.stopLoss);
+        else eraseFrom(index.rising, position.stopLoss);
+    }
+}
+
 // --- Order Management ---
 // returns order ID
 int Broker::submitOrder(Order order) { // Pass Order struct by value (makes a copy)
-    if (strategy == nullptr) {
+    if (strategy == nullptr && strategies.empty()) {
         Utils::logMessage("Broker Error: Strategy not set. Cannot submit order.");
         return -1;
     }
@@ -559,105 +773,496 @@ int Broker::submitOrder(Order order) { // Pass Order struct by value (makes a co
         order.id = nextOrderId++;
     }
     retId = order.id;
+    if (order.strategyId < 0) {
+        order.strategyId = activeStrategyId;
+    }
+    if (!symbols.contains(order.symbolId)) {
+        order.symbolId = ensureSymbol(order.symbol); // One hash lookup; everything after indexes by id
+    } else if (order.symbol.empty()) {
+        order.symbol = symbols.name(order.symbolId);
+    }
     order.status = OrderStatus::SUBMITTED; // Mark as ready for processing
-    order.creationTime = std::chrono::system_clock::now();
+    order.creationTime = clock ? clock->now() : std::chrono::system_clock::time_point{};
 
-    pendingOrders.push_back(order); // Add the modified copy to pending queue
     Utils::logMessage("Broker: Order " + std::to_string(order.id) + " submitted. Type: " + (order.type == OrderType::BUY ? "BUY" : "SELL") + ", Size: " + std::to_string(order.requestedSize) + ", Symbol: " + order.symbol);
+    pendingOrders.push_back(orderPool.acquire(std::move(order))); // Move the modified copy into the pool
 
     return retId; // Return the assigned or existing ID
 }
 
 // --- Process Orders Loop (Refactored) ---
 void Broker::processOrders(const Bar& currentBar) {
-    if (strategy == nullptr) return;
+    processOrders(currentBar, -1);
+}
+
+void Broker::processOrders(const Bar& currentBar, int symbolId) {
+    if (strategy == nullptr && strategies.empty()) return;
+    if (symbolId >= static_cast<int>(prices.size())) return; // Nothing was ever traded in it
 
+    pricedSymbol = symbolId;
+    // Exits of the priced symbol, or of every symbol
+    auto hasExits = [this]() { return pricedSymbol >= 0 ? !exits[pricedSymbol].empty() : !exitSymbols.empty(); };
     try {
-        // First check if any positions hit take profit or stop loss
-        std::map<std::string, double> currentPrices;
-        // Create a map with close prices for all symbols with open positions
-        for (const auto& pair : positions) {
-            currentPrices[pair.first] = currentBar.columns[1];
+        if (participationRate > 0) {
+            // A bar without a volume reading is not capped
+            const bool hasVolume = volumeColumn < static_cast<int>(currentBar.columns.size()) &&
+                                   !std::isnan(currentBar.columns[volumeColumn]);
+            volumeLeft = hasVolume ? participationRate * currentBar.columns[volumeColumn]
+                                   : std::numeric_limits<double>::infinity();
         }
-        checkTakeProfitStopLoss(currentBar, currentPrices);
-
-        // Process pending orders using indices for safe removal
-        for (size_t i = 0; i < pendingOrders.size(); /* no increment */) {
-            try {
-                Order& order = pendingOrders[i]; // Get reference
-
-                // --- Order Type Handling (Market Orders Only for now) ---
-                // TODO: Add check for Limit/Stop orders - if order.requestedPrice > 0 etc.
-
-                // --- Check if Opening or Closing ---
-                Position* existingPosition = nullptr;
-                auto posIt = positions.find(order.symbol);
-                bool positionExists = (posIt != positions.end());
-                if (positionExists) {
-                    existingPosition = &(posIt->second);
+        if (!intrabar.active()) {
+            // First check if any positions hit take profit or stop loss,
+            // then resting limit/stop orders reached since the last bar,
+            // then the maintenance margin, then new orders at the bar's price
+            const double price = currentBar.columns[intrabar.close];
+            if (symbolId >= 0) markPrice(symbolId, price);
+            if (hasExits()) {
+                checkTakeProfitStopLoss(currentBar, price, price);
+            }
+            if (!bookSymbols.empty()) {
+                sweepBooks(currentBar, std::numeric_limits<double>::quiet_NaN(), price);
+            }
+            if (maintenanceLevel > 0) {
+                checkMargin(currentBar, price, price);
+            }
+            processPending(currentBar, price);
+        } else {
+            // New orders arrive at the open; the bar's path is then walked leg
+            // by leg, so exits and resting orders fire in the order it reaches them
+            if (symbolId >= 0) markPrice(symbolId, intrabar.openPrice(currentBar));
+            processPending(currentBar, intrabar.openPrice(currentBar));
+            PathLeg legs[3];
+            intrabar.legs(currentBar, legs);
+            for (const PathLeg& leg : legs) {
+                if (symbolId >= 0) markPrice(symbolId, leg.from);
+                if (hasExits()) {
+                    checkTakeProfitStopLoss(currentBar, leg.low(), leg.high(), leg.from);
                 }
-
-                bool isClosingOrder = false;
-                if (positionExists &&
-                    ((order.type == OrderType::SELL && existingPosition->size > 0) || // Selling with Long position
-                     (order.type == OrderType::BUY && existingPosition->size < 0)))   // Buying with Short position
-                {
-                    isClosingOrder = true;
+                if (!bookSymbols.empty()) {
+                    sweepBooks(currentBar, leg.from, leg.to);
                 }
-                // Note: An order in the same direction as an existing position is treated as 'Open' (increasing size)
-
-                // --- Delegate to Appropriate Handler ---
-                if (isClosingOrder) {
-                    if (existingPosition) { // Should always be true if isClosingOrder is true
-                        executeCloseOrder(order, *existingPosition, currentBar);
-                    } else {
-                        // Should not happen based on logic, but handle defensively
-                        Utils::logMessage("Broker Error: Inconsistent state - Closing order without existing position? ID: " + std::to_string(order.id));
-                        rejectOrder(order, OrderStatus::REJECTED, currentBar);
-                    }
-                } else { // Order is to Open or Increase position
-                    executeOpenOrder(order, currentBar);
+                if (maintenanceLevel > 0) {
+                    checkMargin(currentBar, leg.low(), leg.high(), leg.from);
                 }
-
-                // --- Remove Processed Order from Pending ---
-                // Both executeOpenOrder and executeCloseOrder handle the final state transition
-                // (FILLED or REJECTED) and notification. We just need to remove it here.
-                pendingOrders[i] = std::move(pendingOrders.back());
-                pendingOrders.pop_back();
-                // Do NOT increment 'i', process the swapped element next iteration
-            } catch (const std::exception& e) {
-                Utils::logMessage("Broker::processOrders Error: Exception processing order: " + std::string(e.what()));
-                // Skip this order and move to the next one
-                pendingOrders[i] = std::move(pendingOrders.back());
-                pendingOrders.pop_back();
-            } catch (...) {
-                Utils::logMessage("Broker::processOrders Error: Unknown exception processing order");
-                // Skip this order and move to the next one
-                pendingOrders[i] = std::move(pendingOrders.back());
-                pendingOrders.pop_back();
             }
-        } // End for loop
+        }
+        const double close = currentBar.columns[intrabar.close];
+        if (symbolId >= 0) {
+            markPrice(symbolId, close);
+        } else {
+            // Every open symbol is at the bar's close
+            for (int slot : openPositions) {
+                prices[positions[slot].symbolId] = close;
+            }
+            markedValue = netSize * close;
+            markedExposure = grossSize * close;
+        }
     } catch (const std::exception& e) {
         Utils::logMessage("Broker::processOrders Error: Exception caught: " + std::string(e.what()));
     } catch (...) {
         Utils::logMessage("Broker::processOrders Error: Unknown exception caught");
     }
+    pricedSymbol = -1;
+}
+
+void Broker::processPending(const Bar& currentBar, double price) {
+    // Process pending orders using indices for safe removal
+    for (size_t i = 0; i < pendingOrders.size(); /* no increment */) {
+        bool resting = false; // Handle moved to a book instead of being released
+        try {
+            Order& order = orderPool[pendingOrders[i]]; // Slot stays put while notifications submit new orders
+
+            // Cancelled while in flight: already recorded by cancelOrder
+            if (order.status == OrderStatus::CANCELLED) {
+                orderPool.release(pendingOrders[i]);
+                pendingOrders[i] = pendingOrders.back();
+                pendingOrders.pop_back();
+                continue;
+            }
+
+            // Still in flight: stays pending until the order latency has passed
+            if (clock && !clock->hasArrived(order.creationTime, currentBar.timestamp)) {
+                ++i;
+                continue;
+            }
+
+            if (!symbols.contains(order.symbolId)) {
+                order.symbolId = ensureSymbol(order.symbol); // Orders restored from elsewhere
+            }
+            if (!isPriced(order.symbolId)) { // Waits for a bar of its own symbol
+                ++i;
+                continue;
+            }
+
+            if (order.isResting()) {
+                // --- Limit/Stop Orders: fill now if marketable, otherwise rest ---
+                const bool needsLimit = order.kind != OrderKind::STOP;
+                const bool needsStop = order.kind != OrderKind::LIMIT;
+                if ((needsLimit && order.requestedPrice <= 0) || (needsStop && order.stopPrice <= 0)) {
+                    Utils::logMessage("Broker Warning: Missing limit/stop price for order " + std::to_string(order.id));
+                    rejectOrder(order, OrderStatus::REJECTED, currentBar);
+                } else {
+                    const double fillPrice = triggerFillPrice(order, price, price, price, price);
+                    if (fillPrice > 0) {
+                        // Stops fill as market orders once reached, limits at their price or better
+                        executeOrder(order, currentBar, fillPrice, order.kind == OrderKind::STOP);
+                    } else {
+                        order.status = OrderStatus::ACCEPTED;
+                        books[order.symbolId].lastPrice = price;
+                        restOrder(pendingOrders[i]);
+                        resting = true;
+                    }
+                }
+            } else {
+                const bool forced = order.requestedPrice > 0; // A requested price is filled as given
+                executeOrder(order, currentBar, forced ? order.requestedPrice : price, !forced);
+            }
+
+            // Partly filled (or not reached by the bar's volume): the rest waits for the next bar
+            if (!resting && !order.isClosed()) {
+                if (order.kind == OrderKind::STOP) order.stopTriggered = true; // Trades on as a market order
+                if (order.kind == OrderKind::MARKET) order.requestedPrice = 0.0; // Priced by the bar that fills it
+                ++i;
+                continue;
+            }
+
+            // --- Remove Processed Order from Pending ---
+            // executeOrder handles the final state transition (FILLED or
+            // REJECTED) and notification. We just need to remove it here.
+            if (!resting) orderPool.release(pendingOrders[i]);
+            pendingOrders[i] = pendingOrders.back();
+            pendingOrders.pop_back();
+            // Do NOT increment 'i', process the swapped element next iteration
+        } catch (const std::exception& e) {
+            Utils::logMessage("Broker::processOrders Error: Exception processing order: " + std::string(e.what()));
+            // Skip this order and move to the next one
+            if (!resting) orderPool.release(pendingOrders[i]);
+            pendingOrders[i] = pendingOrders.back();
+            pendingOrders.pop_back();
+        } catch (...) {
+            Utils::logMessage("Broker::processOrders Error: Unknown exception processing order");
+            // Skip this order and move to the next one
+            if (!resting) orderPool.release(pendingOrders[i]);
+            pendingOrders[i] = pendingOrders.back();
+            pendingOrders.pop_back();
+        }
+    } // End for loop
+}
+
+void Broker::executeOrder(Order& order, const Bar& executionBar, double fillPrice, bool slip) {
+    // --- Check if Opening or Closing ---
+    const int slot = positionSlot(order.symbolId, order.strategyId);
+    Position* existingPosition = isOpen(slot) ? &positions[slot] : nullptr;
+    bool isClosingOrder = existingPosition != nullptr &&
+        ((order.type == OrderType::SELL && existingPosition->size > 0) || // Selling with Long position
+         (order.type == OrderType::BUY && existingPosition->size < 0));   // Buying with Short position
+    // Note: An order in the same direction as an existing position is treated as 'Open' (increasing size)
+
+    // --- Delegate to Appropriate Handler ---
+    if (isClosingOrder) {
+        executeCloseOrder(order, *existingPosition, executionBar, fillPrice, slip);
+    } else { // Order is to Open or Increase position
+        executeOpenOrder(order, executionBar, fillPrice, slip);
+    }
+}
+
+bool Broker::cancelOrder(int orderId) {
+    OrderHandle handle = OrderPool::INVALID_HANDLE;
+    bool fromBook = false;
+    auto it = restingOrders.find(orderId);
+    if (it != restingOrders.end()) {
+        handle = it->second;
+        restingOrders.erase(it);
+        const Order& order = orderPool[handle];
+        bool rising = false;
+        const double level = triggerLevel(order, rising);
+        books[order.symbolId].remove(level, rising, handle);
+        fromBook = true;
+    } else {
+        // Pending orders stay in the queue marked CANCELLED; processOrders drops them
+        for (OrderHandle pending : pendingOrders) {
+            if (orderPool[pending].id == orderId && !orderPool[pending].isClosed()) { // Submitted or partly filled
+                handle = pending;
+                break;
+            }
+        }
+        if (handle == OrderPool::INVALID_HANDLE) return false;
+    }
+
+    Order& order = orderPool[handle];
+    order.status = OrderStatus::CANCELLED;
+    order.executionTime = clock ? clock->now() : std::chrono::system_clock::time_point{};
+    orderHistory.append(order);
+    Utils::logMessage("Broker: Order " + std::to_string(orderId) + " CANCELLED");
+    notifyStrategy(order);
+    if (fromBook) orderPool.release(handle); // Only after the notification is done with the order
+    return true;
+}
+
+// --- Resting Orders ---
+double Broker::triggerLevel(const Order& order, bool& rising) {
+    const bool buy = order.type == OrderType::BUY;
+    if (order.kind == OrderKind::STOP || (order.kind == OrderKind::STOP_LIMIT && !order.stopTriggered)) {
+        rising = buy; // Buy stops sit above the market, sell stops below
+        return order.stopPrice;
+    }
+    rising = !buy; // Buy limits sit below the market, sell limits above
+    return order.requestedPrice;
+}
+
+double Broker::triggerFillPrice(Order& order, double from, double to, double low, double high) {
+    const bool buy = order.type == OrderType::BUY;
+    if (order.kind == OrderKind::STOP && order.stopTriggered) return from; // Rest of a partly filled stop
+    if (order.kind == OrderKind::STOP || (order.kind == OrderKind::STOP_LIMIT && !order.stopTriggered)) {
+        if (buy ? high < order.stopPrice : low > order.stopPrice) return 0.0;
+        // A path that starts beyond the stop (a gap) fills where it starts
+        const double stopFill = buy ? std::max(order.stopPrice, from) : std::min(order.stopPrice, from);
+        if (order.kind == OrderKind::STOP) return stopFill;
+        order.stopTriggered = true;
+        from = stopFill;
+        low = std::min(stopFill, to);
+        high = std::max(stopFill, to);
+    }
+    if (buy ? low > order.requestedPrice : high < order.requestedPrice) return 0.0;
+    return buy ? std::min(order.requestedPrice, from) : std::max(order.requestedPrice, from);
+}
+
+void Broker::restOrder(OrderHandle handle) {
+    const Order& order = orderPool[handle];
+    bool rising = false;
+    const double level = triggerLevel(order, rising);
+    TriggerBook& book = books[order.symbolId];
+    book.add(level, rising, handle);
+    if (!book.listed) {
+        book.listed = true;
+        bookSymbols.push_back(order.symbolId);
+    }
+    restingOrders[order.id] = handle;
+}
+
+void Broker::sweepBooks(const Bar& currentBar, double pathFrom, double price) {
+    for (size_t k = 0; k < bookSymbols.size(); /* no increment */) {
+        const int symbolId = bookSymbols[k];
+        if (!isPriced(symbolId)) {
+            ++k;
+            continue;
+        }
+        // With close prices only, the bar's path is the move from the last price to this one
+        double from = pathFrom;
+        if (std::isnan(from)) from = std::isnan(books[symbolId].lastPrice) ? price : books[symbolId].lastPrice;
+        const double low = std::min(from, price);
+        const double high = std::max(from, price);
+        books[symbolId].lastPrice = price;
+
+        triggered.clear();
+        books[symbolId].collect(low, high, triggered);
+        if (triggered.size() > 1) {
+            // Time priority across levels: earlier orders fill first
+            std::sort(triggered.begin(), triggered.end(), [this](OrderHandle a, OrderHandle b) {
+                return orderPool[a].id < orderPool[b].id;
+            });
+        }
+        for (OrderHandle handle : triggered) {
+            restingOrders.erase(orderPool[handle].id);
+        }
+        for (OrderHandle handle : triggered) {
+            Order& order = orderPool[handle];
+            const double fillPrice = triggerFillPrice(order, from, price, low, high);
+            if (fillPrice > 0) {
+                executeOrder(order, currentBar, fillPrice, order.kind == OrderKind::STOP);
+                if (order.isClosed()) {
+                    orderPool.release(handle);
+                } else {
+                    // Capped by the bar's volume: the rest is pending, a stop's as a market order
+                    if (order.kind == OrderKind::STOP) order.stopTriggered = true;
+                    pendingOrders.push_back(handle);
+                }
+            } else {
+                restOrder(handle); // STOP_LIMIT whose limit the rest of the path did not reach
+            }
+        }
+
+        // Notifications may have added symbols (books can reallocate) or emptied this book
+        if (books[symbolId].empty()) {
+            books[symbolId].listed = false;
+            bookSymbols[k] = bookSymbols.back();
+            bookSymbols.pop_back();
+        } else {
+            ++k;
+        }
+    }
 }
 
 // --- Position Info ---
 const Position* Broker::getPosition(const std::string& symbol) const {
-    auto it = positions.find(symbol);
-    if (it != positions.end()) {
-        return &(it->second); // Return pointer to the Position object
+    return getPosition(symbols.find(symbol));
+}
+
+const Position* Broker::getPosition(int symbolId) const {
+    const int slot = findSlot(symbolId, activeStrategyId);
+    return isOpen(slot) ? &positions[slot] : nullptr; // Null if no position exists for the symbol
+}
+
+std::vector<Position> Broker::getAllPositions() const {
+    std::vector<Position> open;
+    open.reserve(openPositions.size());
+    for (int slot : openPositions) {
+        open.push_back(positions[slot]);
     }
-    return nullptr; // Return null if no position exists for the symbol
+    return open;
 }
 
-const std::map<std::string, Position>& Broker::getAllPositions() const {
-    return positions;
+// --- Fast-forward Support ---
+// The nearest indexed TP/SL level, resting order level and liquidation price on each side.
+void Broker::getTriggerBand(double& below, double& above) const {
+    if (maintenanceLevel > 0 && !openPositions.empty()) {
+        const double level = liquidationPrice();
+        if (!std::isnan(level)) {
+            if (marginSlope() > 0) below = std::max(below, level);
+            else above = std::min(above, level);
+        }
+    }
+    for (int symbolId : exitSymbols) {
+        const ExitIndex& index = exits[symbolId];
+        if (!index.rising.empty()) above = std::min(above, index.rising.begin()->first);
+        if (!index.falling.empty()) below = std::max(below, index.falling.begin()->first);
+    }
+    for (int symbolId : bookSymbols) {
+        above = std::min(above, books[symbolId].lowestRising());
+        below = std::max(below, books[symbolId].highestFalling());
+    }
 }
 
 // --- History ---
-const std::vector<Order>& Broker::getOrderHistory() const {
+const TradeLedger& Broker::getOrderHistory() const {
     return orderHistory;
-}
\ No newline at end of file
+}
+// --- Checkpoint ---
+void Broker::saveState(BinaryWriter& writer) const {
+    writer.write(startingCash);
+    writer.write(cash);
+    writer.write(static_cast<int32_t>(nextOrderId));
+    writer.writeSize(liquidations);
+    writer.writeSize(openPositions.size());
+    for (int slot : openPositions) {
+        writePosition(writer, positions[slot]);
+    }
+    std::vector<OrderHandle> handles;
+    for (OrderHandle handle : pendingOrders) {
+        if (orderPool[handle].status != OrderStatus::CANCELLED) handles.push_back(handle);
+    }
+    writer.writeSize(handles.size());
+    for (OrderHandle handle : handles) {
+        writeOrder(writer, orderPool[handle]);
+    }
+    // Resting orders book by book, in book order so equal levels keep their priority
+    size_t numBooks = 0;
+    for (int symbolId : bookSymbols) {
+        if (!books[symbolId].empty()) numBooks++;
+    }
+    writer.writeSize(numBooks);
+    for (int symbolId : bookSymbols) {
+        const TriggerBook& book = books[symbolId];
+        if (book.empty()) continue;
+        writer.writeString(symbols.name(symbolId));
+        writer.write(book.lastPrice);
+        handles.clear();
+        book.handles(handles);
+        writer.writeSize(handles.size());
+        for (OrderHandle handle : handles) {
+            writeOrder(writer, orderPool[handle]);
+        }
+    }
+}
+
+void Broker::loadState(BinaryReader& reader) {
+    startingCash = reader.read<double>();
+    cash = reader.read<double>();
+    nextOrderId = reader.read<int32_t>();
+    liquidations = reader.readSize();
+    while (!openPositions.empty()) {
+        markFlat(openPositions.back());
+    }
+    size_t numPositions = reader.readSize();
+    for (size_t i = 0; i < numPositions; ++i) {
+        Position position = readPosition(reader);
+        position.symbolId = ensureSymbol(position.symbol);
+        const int slot = positionSlot(position.symbolId, position.strategyId);
+        positions[slot] = position;
+        markOpen(slot);
+    }
+    clearOrders();
+    size_t numPending = reader.readSize();
+    pendingOrders.reserve(numPending);
+    for (size_t i = 0; i < numPending; ++i) {
+        Order order = readOrder(reader);
+        order.symbolId = ensureSymbol(order.symbol);
+        pendingOrders.push_back(orderPool.acquire(std::move(order)));
+    }
+    size_t numBooks = reader.readSize();
+    for (size_t b = 0; b < numBooks; ++b) {
+        const int symbolId = ensureSymbol(reader.readString());
+        books[symbolId].lastPrice = reader.read<double>();
+        size_t numResting = reader.readSize();
+        for (size_t i = 0; i < numResting; ++i) {
+            Order order = readOrder(reader);
+            order.symbolId = symbolId;
+            restOrder(orderPool.acquire(std::move(order)));
+        }
+    }
+}
+
+void Broker::restoreOrderHistory(std::vector<Order> history) {
+    orderHistory.clear();
+    orderHistory.reserve(history.size());
+    for (Order& order : history) {
+        order.symbolId = ensureSymbol(order.symbol);
+        orderHistory.append(order);
+    }
+}
+
+void Broker::appendSegment(const Broker& segment) {
+    const int idOffset = nextOrderId - 1;
+    orderHistory.reserve(orderHistory.size() + segment.orderHistory.size());
+    // Symbol ids are per broker, so everything taken over is re-interned here
+    for (size_t row = 0; row < segment.orderHistory.size(); ++row) {
+        Order order = segment.orderHistory.get(row);
+        order.id += idOffset;
+        order.symbolId = ensureSymbol(order.symbol);
+        orderHistory.append(order);
+    }
+    clearOrders();
+    for (OrderHandle handle : segment.pendingOrders) {
+        Order order = segment.orderPool[handle];
+        order.id += idOffset;
+        order.symbolId = ensureSymbol(order.symbol);
+        pendingOrders.push_back(orderPool.acquire(std::move(order)));
+    }
+    std::vector<OrderHandle> handles;
+    for (int segmentId : segment.bookSymbols) {
+        const TriggerBook& book = segment.books[segmentId];
+        const int symbolId = ensureSymbol(segment.symbols.name(segmentId));
+        books[symbolId].lastPrice = book.lastPrice;
+        handles.clear();
+        book.handles(handles);
+        for (OrderHandle handle : handles) {
+            Order order = segment.orderPool[handle];
+            order.id += idOffset;
+            order.symbolId = symbolId;
+            restOrder(orderPool.acquire(std::move(order)));
+        }
+    }
+    while (!openPositions.empty()) {
+        markFlat(openPositions.back());
+    }
+    for (int segmentSlot : segment.openPositions) {
+        Position position = segment.positions[segmentSlot];
+        position.symbolId = ensureSymbol(position.symbol);
+        const int slot = positionSlot(position.symbolId, position.strategyId);
+        positions[slot] = position;
+        markOpen(slot);
+    }
+    cash += segment.cash - segment.startingCash;
+    liquidations += segment.liquidations;
+    nextOrderId += segment.nextOrderId - 1;
+}
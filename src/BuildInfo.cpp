@@ -0,0 +1,17 @@
+// BuildInfo.cpp
+#include "BuildInfo.h"
+
+// Written into the build tree by cmake/BuildId.cmake. Only this file includes
+// it, so a new ID recompiles one translation unit.
+#if defined(__has_include)
+#if __has_include("BuildId.h")
+#include "BuildId.h"
+#endif
+#endif
+#ifndef BACKTESTER_BUILD_ID
+#define BACKTESTER_BUILD_ID "dev"
+#endif
+
+const char* BuildInfo::buildId() {
+    return BACKTESTER_BUILD_ID;
+}
@@ -44,7 +44,21 @@ void Config::setDefaultValues() {
         {"Broker", {
             {"STARTING_CASH", 100000.0},
             {"LEVERAGE", 100.0},
-            {"COMMISSION_RATE", 0.06}
+            {"COMMISSION_RATE", 0.06},
+            {"ORDER_LATENCY_MS", 0.0}, // Orders fill on the first bar at or after submission + latency
+            {"INTRABAR_PATH", "CLOSE"}, // CLOSE, OHLC, OLHC: price path assumed inside each bar
+            {"COMMISSION_MODEL", "PERCENT"}, // PERCENT, PER_UNIT, TIERED, MIN_TICKET (all use COMMISSION_RATE)
+            {"COMMISSION_MIN", 0.0},   // MIN_TICKET: smallest fee per fill
+            {"COMMISSION_TIERS", json::array()}, // TIERED: e.g. [{"NOTIONAL": 100000, "RATE": 0.04}]
+            {"SLIPPAGE_MODEL", "NONE"}, // NONE, FIXED_BPS, SPREAD, VOLATILITY, SQRT_IMPACT
+            {"SLIPPAGE_BPS", 0.0},     // FIXED_BPS
+            {"SLIPPAGE_FACTOR", 0.0},  // SPREAD, VOLATILITY, SQRT_IMPACT
+            {"SLIPPAGE_VOLATILITY", 0.0}, // SQRT_IMPACT: sigma per bar without High/Low columns
+            {"SLIPPAGE_NOISE", 0.0},   // Each cost scaled by a draw in [1 - noise, 1 + noise]
+            {"SLIPPAGE_SEED", 0},
+            {"MARGIN_CALL_LEVEL", 0.0}, // Equity as percent of used margin below which new positions are refused, 0 disables
+            {"MAINTENANCE_MARGIN", 0.0}, // ...below which positions are liquidated, largest first, 0 disables
+            {"PARTICIPATION_RATE", 0.0} // Opening fills per bar capped at this fraction of its volume, 0 disables
         }},
         {"Strategy", {
             {"STRATEGY_NAME", "ML"},
@@ -53,12 +67,73 @@ void Config::setDefaultValues() {
             {"StopLossPips", 50.0},       
             {"TakeProfitPips", 50.0},  
             {"ONE_TRADE", false},
+            {"RANDOM_SEED", 0},       // Random: fixed seed, 0 = random_device (runs are then never cached)
             {"HMMOnnxPath", "hmm_saved/hmm_model.onnx"},
             {"RegimeModelOnnxPaths", {
                 {"0", "xgb_saved/model_0.onnx"},
                 {"1", "xgb_saved/model_1.onnx"}
             }}
         }},
+        {"Portfolio", {
+            {"MODE", "SubAccount"},   // SubAccount: one broker per strategy, Shared: one portfolio broker
+            {"STRATEGIES", json::array()} // e.g. [{"Type": "Random", "ALLOCATION": 0.5}]; empty runs /Strategy/Type alone
+        }},
+        {"Engine", {
+            {"FAST_FORWARD", false},  // Honour strategy wake-up hints and skip quiet bars
+            {"CHECKPOINT_INTERVAL", 0}, // Bars between state snapshots, 0 disables
+            {"CHECKPOINT_DIR", "checkpoints"},
+            {"RESUME", false},        // Resume from CHECKPOINT_DIR/checkpoint.bin if it matches
+            {"INCREMENTAL", false},   // RESUME, plus a snapshot at the last bar for the next run to extend
+            {"RESULT_CACHE", false},  // Reuse results of identical runs (config, data and strategy build)
+            {"RESULT_CACHE_DIR", "result_cache"},
+            {"TRADE_LOG", ""},        // Order history written after the run: .csv, else the columnar format; empty disables
+            {"SEGMENT_PARALLEL", false}, // Simulate between strategy reset points in parallel
+            {"SEGMENT_THREADS", 0},   // 0 = hardware concurrency
+            {"MAX_SECONDS", 0.0},     // Per-run budgets and early-stop rules, 0 disables each
+            {"MAX_BARS", 0},
+            {"MAX_ORDERS", 0},        // Orders processed (filled or rejected)
+            {"MAX_DRAWDOWN", 0.0},    // Percent
+            {"STOP_ON_LIQUIDATION", false}, // End the run once any position has been liquidated
+            {"BUDGET_CHECK_INTERVAL", 256} // Bars between budget checks
+        }},
+        {"Sweep", {
+            {"MODE", "None"},         // None, Lockstep, Halving, Genetic
+            {"EVALUATOR", "Batch"},   // Batch (BatchRandomStrategy), Engine (a full backtest per candidate; Halving, Genetic)
+            {"GRID", json::object()}, // e.g. {"/Strategy/ENTRY_PROBABILITY": [0.01, 0.02]}
+            {"THREADS", 0},           // Parallel lock-step passes, 0 = hardware concurrency
+            {"ETA", 3.0},             // Halving: keep the best 1/ETA, run them on ETA times more bars
+            {"MIN_FRACTION", 0.1},    // Halving: share of the bars in the first rung
+            {"SURROGATE_POINTS", 0},  // Halving: points proposed by the surrogate model per rung
+            {"SEED", 42},
+            {"GENETIC", {
+                {"POPULATION", 32},
+                {"GENERATIONS", 20},
+                {"ELITE", 2},         // Best genomes copied unchanged into the next generation
+                {"SELECTION", "Tournament"}, // Tournament, Rank
+                {"TOURNAMENT_SIZE", 3},
+                {"CROSSOVER", "Uniform"}, // Uniform, OnePoint
+                {"CROSSOVER_RATE", 0.9},
+                {"MUTATION_RATE", 0.1} // Per gene: redraw from the grid's value list
+            }}
+        }},
+        {"Replay", {
+            {"MODE", "None"},         // None, Generate, Run, Benchmark (tick-level replay instead of bars)
+            {"FEED_PATH", "replay_feed.bin"},
+            {"STRATEGY", "Quote"},    // Quote, None (book only)
+            {"QUOTE_SIZE", 1.0},      // Quote: size of each resting quote
+            {"MAX_POSITION", 5.0},    // Quote: absolute position a fill may not exceed
+            {"REQUOTE_TICKS", 2},     // Quote: touch distance that moves a quote
+            {"SYNTHETIC_RECORDS", 10000000}, // Generate: feed records written
+            {"SYNTHETIC_SYMBOLS", 2},
+            {"SYNTHETIC_DEPTH", 10},  // Levels per side
+            {"SYNTHETIC_SEED", 42}
+        }},
+        {"Vectorized", {
+            {"MODE", "None"},         // None, Run (array passes only), Verify (also run SignalStrategy and compare)
+            {"SIGNAL_COLUMN", "signal"}, // Data column holding -1/0/1 targets
+            {"SIZE", 1.0},
+            {"TOLERANCE", 1e-6}       // Max equity difference accepted by Verify
+        }},
         {"RegimeDetection", {
             {"type", "HMM"},
             {"params", {
@@ -241,8 +316,26 @@ void Config::set(const std::string& key, const T& value) {
     // } catch(...) { ... }
 }
 
+bool Config::setNested(const std::string& keyPath, const nlohmann::json& value) {
+    try {
+        configData[json::json_pointer(keyPath)] = value;
+        return true;
+    } catch (const json::exception& e) {
+        Utils::logMessage("Config Error: Failed to set nested key '" + keyPath + "'. Error: " + e.what());
+        return false;
+    }
+}
+
 
 // --- Has ---
+std::string Config::dump(const std::vector<std::string>& excludeSections) const {
+    json copy = configData;
+    for (const auto& section : excludeSections) {
+        copy.erase(section);
+    }
+    return copy.dump();
+}
+
 bool Config::has(const std::string& key) const {
     // Similar decision: top-level or nested? Assume top-level matching get/set.
     return configData.contains(key);
@@ -0,0 +1,34 @@
+// CostModel.cpp
+#include "CostModel.h"
+#include "Config.h"
+#include "Utils.h"
+
+CommissionModel CommissionModel::fromConfig(const Config& config) {
+    CommissionModel model;
+    model.rate = config.getNested<double>("/Broker/COMMISSION_RATE", 0.0);
+    std::string name = config.getNested<std::string>("/Broker/COMMISSION_MODEL", "PERCENT");
+    if (!parseKind(name, model.kind)) {
+        Utils::logMessage("CostModel Warning: Unknown COMMISSION_MODEL '" + name + "', using PERCENT.");
+    }
+    model.minimum = config.getNested<double>("/Broker/COMMISSION_MIN", 0.0);
+    for (const auto& tier : config.getNested<nlohmann::json>("/Broker/COMMISSION_TIERS", nlohmann::json::array())) {
+        model.tiers.push_back(CommissionTier{tier.value("NOTIONAL", 0.0), tier.value("RATE", model.rate)});
+    }
+    std::sort(model.tiers.begin(), model.tiers.end(),
+              [](const CommissionTier& a, const CommissionTier& b) { return a.notional < b.notional; });
+    return model;
+}
+
+SlippageModel SlippageModel::fromConfig(const Config& config) {
+    SlippageModel model;
+    std::string name = config.getNested<std::string>("/Broker/SLIPPAGE_MODEL", "NONE");
+    if (!parseKind(name, model.kind)) {
+        Utils::logMessage("CostModel Warning: Unknown SLIPPAGE_MODEL '" + name + "', using NONE.");
+    }
+    model.bps = config.getNested<double>("/Broker/SLIPPAGE_BPS", 0.0);
+    model.factor = config.getNested<double>("/Broker/SLIPPAGE_FACTOR", 0.0);
+    model.volatility = config.getNested<double>("/Broker/SLIPPAGE_VOLATILITY", 0.0);
+    model.noise = std::max(0.0, config.getNested<double>("/Broker/SLIPPAGE_NOISE", 0.0));
+    model.seed = static_cast<uint64_t>(config.getNested<int>("/Broker/SLIPPAGE_SEED", 0));
+    return model;
+}
@@ -5,6 +5,7 @@
 #include "Bar.h"
 #include "Order.h"
 #include "Utils.h"
+#include "BinaryIO.h"
 #include "HMMModelInterface.h"
 #include <vector>
 #include <string>
@@ -83,30 +84,21 @@ void HMMStrategy::init() {
     // std::this_thread::sleep_for(std::chrono::seconds(10));
 }
 
-void HMMStrategy::next(const Bar& currentBar, size_t currentBarIndex, const double /*currentPrices*/) {
-    // Store current bar in global history
-    allBarHistory_.push_back(currentBar);
-    
-    const size_t MIN_HISTORY = 30;
-    if (allBarHistory_.size() < MIN_HISTORY) {
-        Utils::logMessage("HMMStrategy: Not enough bars for prediction yet, have " + 
-                         std::to_string(allBarHistory_.size()) + ", need " + 
-                         std::to_string(MIN_HISTORY));
-        return;
-    }
-    
+void HMMStrategy::next(const Bar& /*currentBar*/, size_t currentBarIndex, const double /*currentPrices*/) {
+    // The engine holds back next() until MIN_HISTORY bars have arrived (getWarmupBars)
     // The window size needs to be large enough to capture the regime transitions
-    const size_t WINDOW_SIZE = 100;
-    size_t startIdx = allBarHistory_.size() <= WINDOW_SIZE ? 0 : allBarHistory_.size() - WINDOW_SIZE;
+    const size_t windowLen = std::min(WINDOW_SIZE, barsAvailable());
+    Span<double> featureCols[NUM_FEATURES];
+    for (size_t j = 0; j < NUM_FEATURES; j++) {
+        featureCols[j] = column(j, windowLen);
+    }
     
     // Extract features from relevant history with a larger window
-    std::vector<std::vector<float>> rawFeatures;
-    for (size_t i = startIdx; i < allBarHistory_.size(); i++) {
-        std::vector<float> features;
-        for (int j = 0; j < 4; j++) {
-            features.push_back(static_cast<float>(allBarHistory_[i].columns[j]));
+    std::vector<std::vector<float>> rawFeatures(windowLen, std::vector<float>(NUM_FEATURES));
+    for (size_t i = 0; i < windowLen; i++) {
+        for (size_t j = 0; j < NUM_FEATURES; j++) {
+            rawFeatures[i][j] = static_cast<float>(featureCols[j][i]);
         }
-        rawFeatures.push_back(features);
     }
     
     // Apply z-score normalization (subtract mean, divide by std dev)
@@ -254,19 +246,11 @@ void HMMStrategy::handlePrediction(int regime){
     // Get the model for the current regime
     auto& model = regime_models_[regime];
     
-    // Extract features from the most recent bar (if available)
-    if (allBarHistory_.empty()) {
-        Utils::logMessage("No bar history available for prediction");
-        return;
-    }
-    
-    // Get the most recent bar
-    const Bar& currentBar = allBarHistory_.back();
-    
-    // Extract features from current bar
+    // Extract features from the current bar
     std::vector<float> features;
-    for (int i = 0; i < 4; i++) {
-        features.push_back(static_cast<float>(currentBar.columns[i]));
+    features.reserve(NUM_FEATURES);
+    for (size_t i = 0; i < NUM_FEATURES; i++) {
+        features.push_back(static_cast<float>(column(i, 1).back()));
     }
     
     // Use the shape for prediction
@@ -287,7 +271,7 @@ void HMMStrategy::handlePrediction(int regime){
     lastPrediction_ = predValue;
     
     // Trading logic based on prediction
-    double currentPrice = currentBar.columns[3]; // Assuming column 3 is the close price
+    double currentPrice = column(CLOSE_COLUMN, 1).back();
     
     // First, check if we should exit an existing position
     if (inPosition_) {
@@ -356,17 +340,10 @@ void HMMStrategy::handlePrediction(int regime){
 
 double HMMStrategy::calculateRegimeVolatility(int regime, size_t lookback) {
     // Calculate the volatility for a specific regime using historical data
-    if (allBarHistory_.size() < lookback) {
+    if (barsAvailable() < lookback) {
         return 0.01; // Default volatility if not enough history
     }
-    
-    // Find bars where this regime was active
-    std::vector<double> prices;
-    size_t startIdx = allBarHistory_.size() - std::min(lookback, allBarHistory_.size());
-    
-    for (size_t i = startIdx; i < allBarHistory_.size(); i++) {
-        prices.push_back(allBarHistory_[i].columns[3]); // Assuming close price is at index 3
-    }
+    Span<double> prices = column(CLOSE_COLUMN, lookback);
     
     // Calculate standard deviation of returns
     if (prices.size() < 2) return 0.01;
@@ -492,4 +469,37 @@ bool HMMStrategy::shouldExitPosition(int regime, float prediction, double curren
     }
     
     return false;
-}
\ No newline at end of file
+}
+// --- Checkpoint ---
+void HMMStrategy::saveState(BinaryWriter& writer) const {
+    writer.write(inPosition_);
+    writer.write(entryPrice_);
+    writer.write(static_cast<int32_t>(currentRegime_));
+    writer.write(static_cast<int32_t>(previousRegime_));
+    writer.write(static_cast<int32_t>(positionType_));
+    writer.write(lastPrediction_);
+    writer.write(trailStopPrice_);
+    writer.writeSize(regimeVolatility_.size());
+    for (const auto& [regime, volatility] : regimeVolatility_) {
+        writer.write(static_cast<int32_t>(regime));
+        writer.write(volatility);
+    }
+    metrics->saveState(writer);
+}
+
+void HMMStrategy::loadState(BinaryReader& reader) {
+    inPosition_ = reader.read<bool>();
+    entryPrice_ = reader.read<double>();
+    currentRegime_ = reader.read<int32_t>();
+    previousRegime_ = reader.read<int32_t>();
+    positionType_ = reader.read<int32_t>();
+    lastPrediction_ = reader.read<float>();
+    trailStopPrice_ = reader.read<double>();
+    regimeVolatility_.clear();
+    size_t numRegimes = reader.readSize();
+    for (size_t i = 0; i < numRegimes; ++i) {
+        int regime = reader.read<int32_t>();
+        regimeVolatility_[regime] = reader.read<double>();
+    }
+    metrics->loadState(reader);
+}
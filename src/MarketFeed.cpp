@@ -0,0 +1,114 @@
+// MarketFeed.cpp
+#include "MarketFeed.h"
+#include "BinaryIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    const char FEED_MAGIC[4] = {'B', 'T', 'T', 'F'};
+    const uint32_t FEED_VERSION = 1;
+}
+
+// --- MarketFeed ---
+bool MarketFeed::open(const std::string& path) {
+    in_.close();
+    in_.clear();
+    in_.open(path, std::ios::binary);
+    if (!in_) {
+        Utils::logMessage("MarketFeed Error: Cannot open " + path);
+        return false;
+    }
+    try {
+        BinaryReader reader(in_);
+        char magic[sizeof(FEED_MAGIC)];
+        reader.readBytes(magic, sizeof(magic));
+        if (!std::equal(magic, magic + sizeof(magic), FEED_MAGIC) || reader.read<uint32_t>() != FEED_VERSION) {
+            Utils::logMessage("MarketFeed Error: " + path + " is not a compatible feed");
+            return false;
+        }
+        tickSize_ = reader.read<double>();
+        symbols_.resize(reader.readSize());
+        for (std::string& name : symbols_) {
+            name = reader.readString();
+        }
+        count_ = reader.read<uint64_t>();
+    } catch (const std::exception& e) {
+        Utils::logMessage("MarketFeed Error: Failed to read header of " + path + ": " + e.what());
+        return false;
+    }
+    if (tickSize_ <= 0.0) {
+        Utils::logMessage("MarketFeed Error: " + path + " has no valid tick size");
+        return false;
+    }
+    read_ = 0;
+    buffer_.resize(BLOCK_RECORDS);
+    return true;
+}
+
+Span<BookUpdate> MarketFeed::nextBlock() {
+    const size_t want = static_cast<size_t>(std::min<uint64_t>(BLOCK_RECORDS, count_ - read_));
+    if (want == 0 || !in_) return {};
+    in_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(want * sizeof(BookUpdate)));
+    const size_t got = static_cast<size_t>(in_.gcount()) / sizeof(BookUpdate);
+    if (got < want) {
+        Utils::logMessage("MarketFeed Warning: Feed ended after " + std::to_string(read_ + got) + " of " +
+                          std::to_string(count_) + " records");
+        count_ = read_ + got;
+    }
+    read_ += got;
+    return Span<BookUpdate>(buffer_.data(), got);
+}
+
+// --- FeedWriter ---
+bool FeedWriter::open(const std::string& path, double tickSize, const std::vector<std::string>& symbols) {
+    if (tickSize <= 0.0 || symbols.size() > 0x10000) {
+        Utils::logMessage("FeedWriter Error: Need a positive tick size and at most 65536 symbols");
+        return false;
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        Utils::logMessage("FeedWriter Error: Cannot create " + path);
+        return false;
+    }
+    BinaryWriter writer(out_);
+    writer.writeBytes(FEED_MAGIC, sizeof(FEED_MAGIC));
+    writer.write(FEED_VERSION);
+    writer.write(tickSize);
+    writer.writeSize(symbols.size());
+    for (const std::string& name : symbols) {
+        writer.writeString(name);
+    }
+    countPos_ = out_.tellp();
+    writer.write(uint64_t{0});
+    count_ = 0;
+    buffer_.clear();
+    buffer_.reserve(MarketFeed::BLOCK_RECORDS);
+    return writer.good();
+}
+
+void FeedWriter::write(const BookUpdate& update) {
+    buffer_.push_back(update);
+    if (buffer_.size() == MarketFeed::BLOCK_RECORDS) flush();
+}
+
+void FeedWriter::flush() {
+    out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size() * sizeof(BookUpdate)));
+    count_ += buffer_.size();
+    buffer_.clear();
+}
+
+bool FeedWriter::close() {
+    if (!out_.is_open()) return false;
+    flush();
+    out_.seekp(countPos_);
+    BinaryWriter(out_).write(count_);
+    const bool ok = out_.good();
+    out_.close();
+    if (!ok) Utils::logMessage("FeedWriter Error: Failed to write feed");
+    return ok;
+}
+
+FeedWriter::~FeedWriter() {
+    if (out_.is_open()) close();
+}
@@ -0,0 +1,210 @@
+// MatchingEngine.cpp
+#include "MatchingEngine.h"
+#include "Utils.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+    std::chrono::system_clock::time_point toTime(int64_t nanoseconds) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+    }
+
+    int64_t toNanos(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+}
+
+MatchingEngine::MatchingEngine(double initialCash, double commissionRate)
+    : startingCash_(initialCash), cash_(initialCash) {
+    commission_.rate = commissionRate;
+}
+
+int MatchingEngine::ensureSymbol(const std::string& symbol) {
+    const int id = symbols_.intern(symbol);
+    if (id >= static_cast<int>(books_.size())) {
+        books_.resize(id + 1);
+        netSizes_.resize(id + 1, 0.0);
+    }
+    return id;
+}
+
+// --- Replay ---
+uint64_t MatchingEngine::replay(MarketFeed& feed) {
+    std::vector<int> ids;
+    ids.reserve(feed.symbols().size());
+    for (const std::string& name : feed.symbols()) {
+        ids.push_back(ensureSymbol(name));
+        books_[ids.back()].setTickSize(feed.tickSize());
+    }
+
+    uint64_t applied = 0;
+    for (Span<BookUpdate> block = feed.nextBlock(); !block.empty(); block = feed.nextBlock()) {
+        for (const BookUpdate& update : block) {
+            if (update.symbol >= ids.size()) continue; // Not in the feed's symbol table
+            apply(ids[update.symbol], update);
+        }
+        applied += block.size();
+    }
+    Utils::logMessage("MatchingEngine: Replayed " + std::to_string(applied) + " feed records, " +
+                      std::to_string(orderHistory_.size()) + " orders done");
+    return applied;
+}
+
+void MatchingEngine::apply(int symbolId, const BookUpdate& update) {
+    now_ = update.time;
+    if (inFlightHead_ < inFlight_.size()) activateArrived();
+
+    OrderBook& book = books_[symbolId];
+    fills_.clear();
+    book.apply(update, fills_);
+    if (!fills_.empty()) {
+        // Book every fill before notifying, so callbacks that cancel or submit
+        // never see an order that is half way through this record
+        std::vector<Order> notices;
+        notices.reserve(fills_.size());
+        for (const BookFill& fill : fills_) {
+            Order& order = orderPool_[fill.handle];
+            const bool done = settle(order, book.toPrice(fill.price), fill.size);
+            notices.push_back(order);
+            if (done) {
+                restingOrders_.erase(order.id);
+                orderHistory_.append(order);
+                orderPool_.release(fill.handle);
+            }
+        }
+        for (const Order& order : notices) {
+            notify(order);
+        }
+    }
+
+    if (listener_) listener_->onBook(*this, symbolId, update);
+    // Orders submitted from the callbacks with no latency meet the book as it is now
+    if (inFlightHead_ < inFlight_.size()) activateArrived();
+}
+
+void MatchingEngine::activateArrived() {
+    while (inFlightHead_ < inFlight_.size()) {
+        const OrderHandle handle = inFlight_[inFlightHead_];
+        const Order& order = orderPool_[handle];
+        if (order.status != OrderStatus::CANCELLED && toNanos(order.creationTime) + latency_ > now_) break;
+        inFlightHead_++;
+        if (order.status == OrderStatus::CANCELLED) {
+            orderPool_.release(handle); // Already recorded by cancelOrder
+            continue;
+        }
+        activate(handle); // May submit more orders (indices stay valid)
+    }
+    if (inFlightHead_ == inFlight_.size()) {
+        inFlight_.clear();
+        inFlightHead_ = 0;
+    }
+}
+
+void MatchingEngine::activate(OrderHandle handle) {
+    Order& order = orderPool_[handle];
+    OrderBook& book = books_[order.symbolId];
+    const double size = std::abs(order.requestedSize);
+    const bool limitOrder = order.kind == OrderKind::LIMIT;
+    if (size <= 0.0 || book.tickSize() <= 0.0 || (!limitOrder && order.kind != OrderKind::MARKET) ||
+        (limitOrder && order.requestedPrice <= 0.0)) {
+        Utils::logMessage("MatchingEngine Warning: Order " + std::to_string(order.id) +
+                          " REJECTED (needs a size, a quoted symbol and MARKET or a priced LIMIT)");
+        order.status = OrderStatus::REJECTED;
+        finish(handle);
+        return;
+    }
+
+    const BookSide side = order.type == OrderType::BUY ? BookSide::BID : BookSide::ASK;
+    int32_t limit = side == BookSide::BID ? std::numeric_limits<int32_t>::max() : std::numeric_limits<int32_t>::min() + 1;
+    if (limitOrder) limit = book.toTick(order.requestedPrice);
+
+    order.status = OrderStatus::ACCEPTED;
+    double notional = 0.0;
+    const double filled = book.take(side, size, limit, notional);
+    const bool done = filled > 0.0 && settle(order, book.tickSize() * notional / filled, filled);
+    if (done) {
+        finish(handle);
+    } else if (!limitOrder) {
+        // Market orders take what is displayed; the rest is cancelled
+        order.status = OrderStatus::CANCELLED;
+        finish(handle);
+    } else {
+        book.rest(handle, order.id, side, limit, size - filled);
+        restingOrders_[order.id] = handle;
+        if (filled > 0.0) notify(order);
+    }
+}
+
+bool MatchingEngine::settle(Order& order, double price, double size) {
+    const double signedSize = order.type == OrderType::BUY ? size : -size;
+    const double commission = commission_(size, price);
+    netSizes_[order.symbolId] += signedSize;
+    cash_ -= signedSize * price + commission;
+
+    order.filledPrice = (order.filledPrice * order.filledSize + price * size) / (order.filledSize + size);
+    order.filledSize += size;
+    order.commission += commission;
+    order.executionTime = toTime(now_);
+    const bool done = order.filledSize >= std::abs(order.requestedSize) * (1.0 - 1e-12);
+    order.status = done ? OrderStatus::FILLED : OrderStatus::ACCEPTED;
+    return done;
+}
+
+void MatchingEngine::finish(OrderHandle handle) {
+    const Order& order = orderPool_[handle];
+    orderHistory_.append(order);
+    notify(order);
+    orderPool_.release(handle); // After the notification, which may read it
+}
+
+void MatchingEngine::notify(const Order& order) {
+    if (listener_) listener_->onOrder(order);
+}
+
+// --- Orders ---
+int MatchingEngine::submitOrder(Order order) {
+    order.id = nextOrderId_++;
+    if (!symbols_.contains(order.symbolId)) order.symbolId = ensureSymbol(order.symbol);
+    else if (order.symbol.empty()) order.symbol = symbols_.name(order.symbolId);
+    order.status = OrderStatus::SUBMITTED;
+    order.filledSize = 0.0;
+    order.filledPrice = 0.0;
+    order.commission = 0.0;
+    order.creationTime = toTime(now_);
+    inFlight_.push_back(orderPool_.acquire(std::move(order)));
+    return nextOrderId_ - 1;
+}
+
+bool MatchingEngine::cancelOrder(int orderId) {
+    auto it = restingOrders_.find(orderId);
+    if (it != restingOrders_.end()) {
+        const OrderHandle handle = it->second;
+        restingOrders_.erase(it);
+        Order& order = orderPool_[handle];
+        books_[order.symbolId].cancel(handle);
+        order.status = OrderStatus::CANCELLED;
+        finish(handle);
+        return true;
+    }
+    for (size_t k = inFlightHead_; k < inFlight_.size(); ++k) {
+        Order& order = orderPool_[inFlight_[k]];
+        if (order.id == orderId && order.status == OrderStatus::SUBMITTED) {
+            order.status = OrderStatus::CANCELLED; // Dropped when it would have arrived
+            orderHistory_.append(order);
+            notify(order);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- State ---
+double MatchingEngine::getValue() const {
+    double value = cash_;
+    for (size_t id = 0; id < netSizes_.size(); ++id) {
+        if (netSizes_[id] != 0.0) value += netSizes_[id] * books_[id].midPrice();
+    }
+    return value;
+}
@@ -0,0 +1,236 @@
+// OrderBook.cpp
+#include "OrderBook.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+int OrderBook::indexOf(int32_t tick) {
+    if (bids_.empty()) {
+        bids_.assign(INITIAL_LEVELS, 0.0);
+        asks_.assign(INITIAL_LEVELS, 0.0);
+        base_ = tick - static_cast<int32_t>(INITIAL_LEVELS / 2);
+    }
+    const int64_t size = static_cast<int64_t>(bids_.size());
+    int64_t offset = static_cast<int64_t>(tick) - base_;
+    if (offset >= 0 && offset < size) return static_cast<int>(offset);
+
+    // An empty book just moves its window
+    if (bidLevels_ == 0 && askLevels_ == 0) {
+        base_ = tick - static_cast<int32_t>(size / 2);
+        return static_cast<int>(size / 2);
+    }
+
+    // Grow to twice the span covering the old window and the new tick, centred
+    const int64_t low = std::min<int64_t>(base_, tick);
+    const int64_t high = std::max<int64_t>(base_ + size - 1, tick);
+    const int64_t span = high - low + 1;
+    size_t newSize = bids_.size();
+    while (static_cast<int64_t>(newSize) < 2 * span) newSize *= 2;
+    if (newSize > MAX_LEVELS) {
+        Utils::logMessage("OrderBook Warning: Price tick " + std::to_string(tick) + " is too far from the book, update dropped");
+        return -1;
+    }
+    const int64_t newBase = low - (static_cast<int64_t>(newSize) - span) / 2;
+    const int shift = static_cast<int>(base_ - newBase);
+    std::vector<double> bids(newSize, 0.0);
+    std::vector<double> asks(newSize, 0.0);
+    std::copy(bids_.begin(), bids_.end(), bids.begin() + shift);
+    std::copy(asks_.begin(), asks_.end(), asks.begin() + shift);
+    bids_.swap(bids);
+    asks_.swap(asks);
+    base_ = static_cast<int32_t>(newBase);
+    if (bestBid_ >= 0) bestBid_ += shift;
+    if (bestAsk_ >= 0) bestAsk_ += shift;
+    return static_cast<int>(tick - base_);
+}
+
+void OrderBook::setLevel(BookSide side, int index, double size) {
+    if (size < 0.0) size = 0.0;
+    if (side == BookSide::BID) {
+        double& level = bids_[index];
+        if (level == 0.0 && size > 0.0) bidLevels_++;
+        else if (level > 0.0 && size == 0.0) bidLevels_--;
+        level = size;
+        if (size > 0.0) {
+            if (index > bestBid_) bestBid_ = index;
+        } else if (index == bestBid_) {
+            if (bidLevels_ == 0) {
+                bestBid_ = -1;
+            } else {
+                int k = index - 1;
+                while (bids_[k] == 0.0) --k;
+                bestBid_ = k;
+            }
+        }
+    } else {
+        double& level = asks_[index];
+        if (level == 0.0 && size > 0.0) askLevels_++;
+        else if (level > 0.0 && size == 0.0) askLevels_--;
+        level = size;
+        if (size > 0.0) {
+            if (bestAsk_ < 0 || index < bestAsk_) bestAsk_ = index;
+        } else if (index == bestAsk_) {
+            if (askLevels_ == 0) {
+                bestAsk_ = -1;
+            } else {
+                int k = index + 1;
+                while (asks_[k] == 0.0) ++k;
+                bestAsk_ = k;
+            }
+        }
+    }
+}
+
+void OrderBook::clearSide(BookSide side) {
+    // Walks away from the best price until every level is gone (one step for an L1 feed)
+    if (side == BookSide::BID) {
+        for (int k = bestBid_; bidLevels_ > 0; --k) {
+            if (bids_[k] > 0.0) {
+                bids_[k] = 0.0;
+                bidLevels_--;
+            }
+        }
+        bestBid_ = -1;
+    } else {
+        for (int k = bestAsk_; askLevels_ > 0; ++k) {
+            if (asks_[k] > 0.0) {
+                asks_[k] = 0.0;
+                askLevels_--;
+            }
+        }
+        bestAsk_ = -1;
+    }
+}
+
+void OrderBook::apply(const BookUpdate& update, std::vector<BookFill>& fills) {
+    switch (update.action) {
+        case UpdateAction::TRADE:
+            // A buyer lifting offers reaches our asks, a seller hitting bids our bids
+            matchOwn(update.side == BookSide::BID ? BookSide::ASK : BookSide::BID, update.price, update.size, fills);
+            return;
+        case UpdateAction::CLEAR:
+            clearSide(BookSide::BID);
+            clearSide(BookSide::ASK);
+            return;
+        case UpdateAction::TOP:
+            clearSide(update.side);
+            break;
+        case UpdateAction::LEVEL:
+            break;
+    }
+
+    const int index = indexOf(update.price);
+    if (index < 0) return;
+    setLevel(update.side, index, update.size);
+
+    // Displayed size only shrinks ahead of us: cancels behind us can't be told apart
+    std::vector<OwnOrder>& own = update.side == BookSide::BID ? ownBids_ : ownAsks_;
+    for (OwnOrder& order : own) {
+        if (order.price == update.price) order.queueAhead = std::min(order.queueAhead, update.size);
+    }
+    // A quote moving onto or through our price crosses our orders on the other side
+    if (update.side == BookSide::ASK && !ownBids_.empty()) matchOwn(BookSide::BID, NO_PRICE, 0.0, fills);
+    if (update.side == BookSide::BID && !ownAsks_.empty()) matchOwn(BookSide::ASK, NO_PRICE, 0.0, fills);
+}
+
+void OrderBook::matchOwn(BookSide side, int32_t tradePrice, double tradeSize, std::vector<BookFill>& fills) {
+    std::vector<OwnOrder>& own = side == BookSide::BID ? ownBids_ : ownAsks_;
+    const bool bid = side == BookSide::BID;
+    bool filledAny = false;
+    double usedByUs = 0.0; // Trade volume already given to our earlier orders at the trade price
+
+    for (OwnOrder& order : own) {
+        double fillSize = 0.0;
+        if (tradePrice == NO_PRICE) {
+            // Crossed by the opposite quote: fill against the liquidity up to our price
+            const int32_t opposite = bid ? bestAsk() : bestBid();
+            if (opposite == NO_PRICE || (bid ? opposite > order.price : opposite < order.price)) break;
+            double notional = 0.0;
+            fillSize = take(side, order.remaining, order.price, notional);
+            if (fillSize <= 0.0) break;
+        } else if (bid ? order.price > tradePrice : order.price < tradePrice) {
+            fillSize = order.remaining; // Traded through our price
+        } else if (order.price == tradePrice) {
+            // Volume reaching us after the displayed queue ahead and our own earlier orders
+            const double reach = tradeSize - order.queueAhead - usedByUs;
+            order.queueAhead = std::max(0.0, order.queueAhead - tradeSize);
+            if (reach <= 0.0) continue;
+            fillSize = std::min(order.remaining, reach);
+            usedByUs += fillSize;
+        } else {
+            break; // Orders further back are worse priced
+        }
+        order.remaining -= fillSize;
+        fills.push_back(BookFill{order.handle, order.price, fillSize, true});
+        filledAny = true;
+    }
+
+    if (filledAny) {
+        own.erase(std::remove_if(own.begin(), own.end(), [](const OwnOrder& order) { return order.remaining <= 0.0; }), own.end());
+    }
+}
+
+double OrderBook::take(BookSide side, double size, int32_t limit, double& notional) {
+    double filled = 0.0;
+    notional = 0.0;
+    if (side == BookSide::BID) {
+        while (filled < size && bestAsk_ >= 0 && base_ + bestAsk_ <= limit) {
+            const int index = bestAsk_;
+            const double traded = std::min(asks_[index], size - filled);
+            filled += traded;
+            notional += traded * (base_ + index);
+            setLevel(BookSide::ASK, index, traded < asks_[index] ? asks_[index] - traded : 0.0);
+        }
+    } else {
+        while (filled < size && bestBid_ >= 0 && base_ + bestBid_ >= limit) {
+            const int index = bestBid_;
+            const double traded = std::min(bids_[index], size - filled);
+            filled += traded;
+            notional += traded * (base_ + index);
+            setLevel(BookSide::BID, index, traded < bids_[index] ? bids_[index] - traded : 0.0);
+        }
+    }
+    return filled;
+}
+
+void OrderBook::rest(OrderHandle handle, int id, BookSide side, int32_t price, double size) {
+    std::vector<OwnOrder>& own = side == BookSide::BID ? ownBids_ : ownAsks_;
+    const OwnOrder order{handle, id, price, size, sizeAt(side, price)};
+    // Behind every order at a better or equal price
+    auto it = std::upper_bound(own.begin(), own.end(), order, [side](const OwnOrder& a, const OwnOrder& b) {
+        if (a.price != b.price) return side == BookSide::BID ? a.price > b.price : a.price < b.price;
+        return a.id < b.id;
+    });
+    own.insert(it, order);
+}
+
+bool OrderBook::cancel(OrderHandle handle) {
+    for (std::vector<OwnOrder>* own : {&ownBids_, &ownAsks_}) {
+        auto it = std::find_if(own->begin(), own->end(), [handle](const OwnOrder& order) { return order.handle == handle; });
+        if (it != own->end()) {
+            own->erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t OrderBook::toTick(double price) const {
+    const double ticks = std::round(price / tickSize_);
+    if (ticks >= std::numeric_limits<int32_t>::max()) return std::numeric_limits<int32_t>::max();
+    if (ticks <= std::numeric_limits<int32_t>::min() + 1.0) return std::numeric_limits<int32_t>::min() + 1;
+    return static_cast<int32_t>(ticks);
+}
+
+double OrderBook::sizeAt(BookSide side, int32_t tick) const {
+    const int64_t offset = static_cast<int64_t>(tick) - base_;
+    if (bids_.empty() || offset < 0 || offset >= static_cast<int64_t>(bids_.size())) return 0.0;
+    return side == BookSide::BID ? bids_[offset] : asks_[offset];
+}
+
+double OrderBook::midPrice() const {
+    if (bestBid_ >= 0 && bestAsk_ >= 0) return 0.5 * (toPrice(bestBid()) + toPrice(bestAsk()));
+    if (bestBid_ >= 0) return toPrice(bestBid());
+    if (bestAsk_ >= 0) return toPrice(bestAsk());
+    return 0.0;
+}
@@ -0,0 +1,49 @@
+// QuoteReplayStrategy.cpp
+#include "QuoteReplayStrategy.h"
+#include "Config.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdlib>
+
+void QuoteReplayStrategy::init(const Config& config, MatchingEngine& matching) {
+    ReplayStrategy::init(config, matching);
+    size_ = config.getNested<double>("/Replay/QUOTE_SIZE", 1.0);
+    maxPosition_ = config.getNested<double>("/Replay/MAX_POSITION", 5.0);
+    requoteTicks_ = std::max(0, config.getNested<int>("/Replay/REQUOTE_TICKS", 2));
+    quotes_.assign(matching.getSymbols().size(), SymbolQuotes());
+    Utils::logMessage("--- QuoteReplayStrategy Initialized (size " + std::to_string(size_) +
+                      ", max position " + std::to_string(maxPosition_) + ", requote " + std::to_string(requoteTicks_) + " ticks) ---");
+}
+
+void QuoteReplayStrategy::onBook(MatchingEngine& matching, int symbolId, const BookUpdate& update) {
+    // Trades fill or queue our quotes; only quote changes move them
+    if (update.action == UpdateAction::TRADE || symbolId >= static_cast<int>(quotes_.size())) return;
+    const OrderBook& book = matching.getBook(symbolId);
+    const int32_t bid = book.bestBid();
+    const int32_t ask = book.bestAsk();
+    if (bid == OrderBook::NO_PRICE || ask == OrderBook::NO_PRICE) return; // One-sided while the book is rebuilt
+
+    const double position = matching.getNetSize(symbolId);
+    SymbolQuotes& quotes = quotes_[symbolId];
+    refresh(symbolId, quotes.bid, OrderType::BUY, bid, position + size_ <= maxPosition_ + 1e-9);
+    refresh(symbolId, quotes.ask, OrderType::SELL, ask, position - size_ >= -maxPosition_ - 1e-9);
+}
+
+void QuoteReplayStrategy::refresh(int symbolId, Quote& quote, OrderType type, int32_t touch, bool allowed) {
+    if (quote.orderId >= 0) {
+        if (allowed && std::abs(touch - quote.tick) <= requoteTicks_) return;
+        cancel(quote.orderId); // onOrder clears the quote
+        if (quote.orderId >= 0) return; // Not cancellable (already done); wait for its notification
+    }
+    if (!allowed) return;
+    const double price = engine->getBook(symbolId).toPrice(touch);
+    quote.tick = touch;
+    quote.orderId = type == OrderType::BUY ? buyLimit(symbolId, size_, price) : sellLimit(symbolId, size_, price);
+}
+
+void QuoteReplayStrategy::onOrder(const Order& order) {
+    if (!order.isClosed() || order.symbolId < 0 || order.symbolId >= static_cast<int>(quotes_.size())) return;
+    SymbolQuotes& quotes = quotes_[order.symbolId];
+    if (quotes.bid.orderId == order.id) quotes.bid = Quote();
+    if (quotes.ask.orderId == order.id) quotes.ask = Quote();
+}
@@ -2,6 +2,7 @@
 #include "Broker.h"
 #include "Utils.h"
 #include "Config.h"
+#include "BinaryIO.h"
 #include <cmath>
 #include <iomanip>
 #include <sstream>
@@ -9,7 +10,6 @@
 
 // --- Constructor ---
 RandomStrategy::RandomStrategy() :
-    probDist(0.0, 1.0),
     directionDist(0, 1)
 {
     try {
@@ -33,6 +33,9 @@ void RandomStrategy::init() {
         benchmarkFixedSize = config->getNested<double>("/Strategy/BENCHMARK_FIXED_SIZE", 1.0);
         debugMode = config->getNested<bool>("/Strategy/DEBUG_MODE", false);
         one_trade = config->getNested<bool>("/Strategy/ONE_TRADE", true);
+        // 0 keeps the random_device seed from construction
+        int seed = config->getNested<int>("/Strategy/RANDOM_SEED", 0);
+        if (seed != 0) rng.seed(static_cast<unsigned int>(seed));
     } catch (const std::exception& e) {
         Utils::logMessage("RandomStrategy::init Warning: Error loading parameters: " + std::string(e.what()));
     }
@@ -45,6 +48,8 @@ void RandomStrategy::init() {
     currentOrderId = -1;
     inPosition = false;
     taken_trade = false;
+    nextEntryBar = NO_BAR;
+    lastMetricsBar = NO_BAR;
     double startingAccountValue = broker->getStartingCash();
 
     // Convert entry probability from percentage to decimal if needed
@@ -53,6 +58,10 @@ void RandomStrategy::init() {
         Utils::logMessage("Converting entry probability from percentage to decimal: " + std::to_string(entryProbability));
     }
 
+    if (entryProbability > 0.0 && entryProbability < 1.0) {
+        gapDist = std::geometric_distribution<long long>(entryProbability);
+    }
+
     // Initialize metrics tracker
     metrics = std::make_unique<TradingMetrics>(startingAccountValue);
     if (data) {
@@ -67,6 +76,15 @@ void RandomStrategy::init() {
     Utils::logMessage("-------------------------------------------------------");
 }
 
+// Number of failed per-bar rolls before a success is geometric, so drawing
+// the gap once is equivalent to rolling entryProbability on every bar and
+// lets the strategy sleep until the entry.
+size_t RandomStrategy::drawEntryBar(size_t fromBar) {
+    if (entryProbability <= 0.0) return NO_BAR;
+    if (entryProbability >= 1.0) return fromBar;
+    return fromBar + static_cast<size_t>(gapDist(rng));
+}
+
 // --- Per-Bar Logic ---
 void RandomStrategy::next(const Bar& , size_t currentBarIndex, const double currentPrices) {
     // Log position status every 500 bars for debugging
@@ -79,19 +97,21 @@ void RandomStrategy::next(const Bar& , size_t currentBarIndex, const double curr
         if(currentBarIndex == 0)Utils::logMessage(
             "inPosition:" + std::to_string(inPosition)
              + ", taken=" + std::to_string(taken_trade));
+        wakeOnFill(); // TP/SL exits arrive as fills
         return;
     }
     if (one_trade && taken_trade) {
+        sleepUntil(NO_BAR); // Nothing left to do
         return;
     }
     
     // --- Entry Logic ---
-    double roll = probDist(rng);
-    // Log roll value every 100 bars for debugging
-    if (currentBarIndex % 100 == 0) {
-        Utils::logMessage("Bar " + std::to_string(currentBarIndex) + ": Roll=" + std::to_string(roll) + ", EntryProbability=" + std::to_string(entryProbability));
+    if (nextEntryBar == NO_BAR) {
+        nextEntryBar = drawEntryBar(currentBarIndex);
+        if (debugMode) Utils::logMessage("DEBUG: Bar " + std::to_string(currentBarIndex) + ": next entry at bar " + std::to_string(nextEntryBar));
     }
-    if (roll < entryProbability) {
+    if (currentBarIndex >= nextEntryBar) {
+        nextEntryBar = NO_BAR;
         // Random direction (BUY or SELL)
         OrderType entryOrderType = (directionDist(rng) == 0) ? OrderType::BUY : OrderType::SELL;
         double desiredSize = benchmarkFixedSize;
@@ -99,7 +119,7 @@ void RandomStrategy::next(const Bar& , size_t currentBarIndex, const double curr
             desiredSize = -desiredSize;
         }
 
-        if (debugMode) Utils::logMessage("DEBUG: Random Entry Triggered (Roll: " + std::to_string(roll) + ")");
+        if (debugMode) Utils::logMessage("DEBUG: Random Entry Triggered (Bar: " + std::to_string(currentBarIndex) + ")");
 
         // --- Create Order ---
         Order entryOrder;
@@ -163,14 +183,17 @@ void RandomStrategy::next(const Bar& , size_t currentBarIndex, const double curr
 
         if (currentOrderId == -1) {
             Utils::logMessage("ERROR: Failed to submit entry order!");
-        } else if (one_trade) {
-            taken_trade = true;
+        } else {
+            wakeOnFill(); // The fill (or rejection) arrives on the next bar
+            if (one_trade) taken_trade = true;
         }
         return;
     }
+    sleepUntil(nextEntryBar);
 
     // Track portfolio value for metrics (every 10 bars to reduce overhead)
-    if (currentBarIndex % 10 == 0) {
+    if (lastMetricsBar == NO_BAR || currentBarIndex >= lastMetricsBar + 10) {
+        lastMetricsBar = currentBarIndex;
         double currentValue = broker->getValue(currentPrices);
 
         // Record return for Sharpe ratio calculation
@@ -215,16 +238,30 @@ void RandomStrategy::stop() {
 
 // --- Order Notification Handler ---
 void RandomStrategy::notifyOrder(const Order& order) {
-    if (order.id == currentOrderId) {
+    // A partly filled order (ACCEPTED with a fill) keeps working on later bars
+    const bool partFilled = order.status == OrderStatus::ACCEPTED && order.filledSize != 0.0;
+    const bool entryWorking = order.id == currentOrderId;
+    if (entryWorking && !partFilled) {
         currentOrderId = -1;
     }
 
+    if (partFilled) {
+        if (order.reason == OrderReason::ENTRY_SIGNAL && entryWorking) {
+            // The position is open with what has filled so far
+            inPosition = true;
+            currentPosition.symbol = order.symbol;
+            currentPosition.size = (order.type == OrderType::BUY) ? order.filledSize : -order.filledSize;
+            currentPosition.entryPrice = order.filledPrice;
+        }
+        return;
+    }
+
     if (order.status == OrderStatus::FILLED) {
         // Record commission on every fill
         metrics->recordCommission(order.commission);
 
-        if (order.reason == OrderReason::ENTRY_SIGNAL && !inPosition) {
-            // Entry
+        if (order.reason == OrderReason::ENTRY_SIGNAL && (!inPosition || entryWorking)) {
+            // Entry (the last fill of a partly filled one carries the totals)
             inPosition = true;
             currentPosition.symbol = order.symbol;
             currentPosition.size = (order.type == OrderType::BUY) ? order.filledSize : -order.filledSize;
@@ -243,6 +280,10 @@ void RandomStrategy::notifyOrder(const Order& order) {
                             (profitable ? " (PROFIT)" : " (LOSS)"));
             inPosition = false;
             currentPosition = Position();
+            // Closed before the entry finished filling: the rest would reopen it
+            if (currentOrderId >= 0 && broker->cancelOrder(currentOrderId)) {
+                currentOrderId = -1;
+            }
         }
     }
     else if (order.status == OrderStatus::REJECTED || order.status == OrderStatus::MARGIN || order.status == OrderStatus::CANCELLED) {
@@ -250,3 +291,29 @@ void RandomStrategy::notifyOrder(const Order& order) {
                        + " Status: " + std::to_string(static_cast<int>(order.status)));
     }
 }
+
+// --- Checkpoint ---
+void RandomStrategy::saveState(BinaryWriter& writer) const {
+    writer.write(inPosition);
+    writer.write(taken_trade);
+    writer.write(static_cast<int32_t>(currentOrderId));
+    writePosition(writer, currentPosition);
+    writer.writeSize(nextEntryBar);
+    writer.writeSize(lastMetricsBar);
+    std::ostringstream rngState;
+    rngState << rng;
+    writer.writeString(rngState.str());
+    metrics->saveState(writer);
+}
+
+void RandomStrategy::loadState(BinaryReader& reader) {
+    inPosition = reader.read<bool>();
+    taken_trade = reader.read<bool>();
+    currentOrderId = reader.read<int32_t>();
+    currentPosition = readPosition(reader);
+    nextEntryBar = reader.readSize();
+    lastMetricsBar = reader.readSize();
+    std::istringstream rngState(reader.readString());
+    rngState >> rng;
+    metrics->loadState(reader);
+}
@@ -0,0 +1,193 @@
+// ReplayRunner.cpp
+#include "ReplayRunner.h"
+#include "CostModel.h"
+#include "MarketFeed.h"
+#include "MatchingEngine.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    const double SYNTHETIC_TICK_SIZE = 0.01;
+    const int32_t SYNTHETIC_START_TICK = 10000;          // 100.00
+    const int64_t SYNTHETIC_START_TIME = 1736121600000000000LL; // 2025-01-06 00:00:00 UTC in ns
+
+    // One symbol of the synthetic feed: displayed size per level, index 0 at the touch
+    struct SyntheticBook {
+        int32_t mid = SYNTHETIC_START_TICK;
+        std::vector<double> bids; // At mid - 1 - k
+        std::vector<double> asks; // At mid + 1 + k
+    };
+}
+
+// --- Synthetic Feed ---
+bool ReplayRunner::generateFeed(const std::string& path) const {
+    const uint64_t records = static_cast<uint64_t>(std::max(0, config.getNested<int>("/Replay/SYNTHETIC_RECORDS", 10000000)));
+    const int symbolCount = std::min(0x10000, std::max(1, config.getNested<int>("/Replay/SYNTHETIC_SYMBOLS", 2)));
+    const int depth = std::max(1, config.getNested<int>("/Replay/SYNTHETIC_DEPTH", 10));
+    std::mt19937_64 rng(static_cast<uint64_t>(config.getNested<int>("/Replay/SYNTHETIC_SEED", 42)));
+
+    std::vector<std::string> names;
+    for (int s = 0; s < symbolCount; ++s) names.push_back("SYN" + std::to_string(s));
+    FeedWriter writer;
+    if (!writer.open(path, SYNTHETIC_TICK_SIZE, names)) return false;
+
+    std::uniform_int_distribution<int> sizeDraw(1, 20);
+    std::uniform_int_distribution<int> symbolDraw(0, symbolCount - 1);
+    std::uniform_int_distribution<int> levelDraw(0, depth - 1);
+    std::uniform_int_distribution<int> stepDraw(1, 200); // Microseconds between events
+    std::uniform_real_distribution<double> eventDraw(0.0, 1.0);
+
+    uint64_t written = 0;
+    int64_t time = SYNTHETIC_START_TIME;
+    auto emit = [&](int symbol, BookSide side, UpdateAction action, int32_t price, double size) {
+        BookUpdate update;
+        update.time = time;
+        update.symbol = static_cast<uint16_t>(symbol);
+        update.side = side;
+        update.action = action;
+        update.price = price;
+        update.size = size;
+        writer.write(update);
+        written++;
+    };
+
+    // Snapshot of every book
+    std::vector<SyntheticBook> books(symbolCount);
+    for (int s = 0; s < symbolCount && written < records; ++s) {
+        SyntheticBook& book = books[s];
+        emit(s, BookSide::BID, UpdateAction::CLEAR, 0, 0.0);
+        for (int k = 0; k < depth; ++k) {
+            book.bids.push_back(sizeDraw(rng));
+            book.asks.push_back(sizeDraw(rng));
+            emit(s, BookSide::BID, UpdateAction::LEVEL, book.mid - 1 - k, book.bids[k]);
+            emit(s, BookSide::ASK, UpdateAction::LEVEL, book.mid + 1 + k, book.asks[k]);
+        }
+    }
+
+    while (written < records) {
+        time += stepDraw(rng) * 1000;
+        const int s = symbolDraw(rng);
+        SyntheticBook& book = books[s];
+        const double event = eventDraw(rng);
+        const uint64_t left = records - written;
+        if (event < 0.02 && left >= 4) {
+            // The mid moves a tick: the touch on one side is taken out, a level
+            // is added behind on that side and the other side steps up to it
+            if (eventDraw(rng) < 0.5) {
+                emit(s, BookSide::ASK, UpdateAction::LEVEL, book.mid + 1, 0.0);
+                emit(s, BookSide::BID, UpdateAction::LEVEL, book.mid - depth, 0.0);
+                book.mid++;
+                book.asks.erase(book.asks.begin());
+                book.asks.push_back(sizeDraw(rng));
+                book.bids.pop_back();
+                book.bids.insert(book.bids.begin(), sizeDraw(rng));
+                emit(s, BookSide::BID, UpdateAction::LEVEL, book.mid - 1, book.bids.front());
+                emit(s, BookSide::ASK, UpdateAction::LEVEL, book.mid + depth, book.asks.back());
+            } else {
+                emit(s, BookSide::BID, UpdateAction::LEVEL, book.mid - 1, 0.0);
+                emit(s, BookSide::ASK, UpdateAction::LEVEL, book.mid + depth, 0.0);
+                book.mid--;
+                book.bids.erase(book.bids.begin());
+                book.bids.push_back(sizeDraw(rng));
+                book.asks.pop_back();
+                book.asks.insert(book.asks.begin(), sizeDraw(rng));
+                emit(s, BookSide::ASK, UpdateAction::LEVEL, book.mid + 1, book.asks.front());
+                emit(s, BookSide::BID, UpdateAction::LEVEL, book.mid - depth, book.bids.back());
+            }
+        } else if (event < 0.12 && left >= 2) {
+            // A trade at the touch, then the level it left (refilled if it was taken out)
+            const bool buyer = eventDraw(rng) < 0.5;
+            double& level = buyer ? book.asks.front() : book.bids.front();
+            const int32_t price = buyer ? book.mid + 1 : book.mid - 1;
+            const double size = std::min<double>(level, sizeDraw(rng) / 4 + 1);
+            emit(s, buyer ? BookSide::BID : BookSide::ASK, UpdateAction::TRADE, price, size);
+            level = level > size ? level - size : sizeDraw(rng);
+            emit(s, buyer ? BookSide::ASK : BookSide::BID, UpdateAction::LEVEL, price, level);
+        } else {
+            const bool bid = eventDraw(rng) < 0.5;
+            const int k = levelDraw(rng);
+            double& level = bid ? book.bids[k] : book.asks[k];
+            level = sizeDraw(rng);
+            emit(s, bid ? BookSide::BID : BookSide::ASK, UpdateAction::LEVEL, bid ? book.mid - 1 - k : book.mid + 1 + k, level);
+        }
+    }
+
+    if (!writer.close()) return false;
+    Utils::logMessage("ReplayRunner: Wrote " + std::to_string(written) + " synthetic records for " +
+                      std::to_string(symbolCount) + " symbols to " + path);
+    return true;
+}
+
+// --- Replay ---
+bool ReplayRunner::run(const std::string& path, ReplayStrategy* strategy, ReplayResult& result) const {
+    MarketFeed feed;
+    if (!feed.open(path)) return false;
+
+    MatchingEngine engine(config.getNested<double>("/Broker/STARTING_CASH", 100000.0), 0.0);
+    engine.setCommissionModel(CommissionModel::fromConfig(config));
+    engine.setLatency(static_cast<int64_t>(config.getNested<double>("/Broker/ORDER_LATENCY_MS", 0.0) * 1e6));
+    for (const std::string& name : feed.symbols()) {
+        engine.setTickSize(engine.getSymbolId(name), feed.tickSize());
+    }
+    if (strategy) {
+        engine.setListener(strategy);
+        strategy->init(config, engine);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    result.records = engine.replay(feed);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (strategy) strategy->stop();
+
+    const TradeLedger& history = engine.getOrderHistory();
+    result.finalValue = engine.getValue();
+    result.orders = history.size();
+    result.fills = static_cast<size_t>(std::count(history.statuses().begin(), history.statuses().end(),
+                                                  static_cast<uint8_t>(OrderStatus::FILLED)));
+    result.commission = 0.0;
+    for (double commission : history.commissions()) result.commission += commission;
+    return true;
+}
+
+bool ReplayRunner::runMode(const std::string& mode, ReplayStrategy* strategy) const {
+    const std::string path = config.getNested<std::string>("/Replay/FEED_PATH", "replay_feed.bin");
+    if (mode == "Generate") {
+        return generateFeed(path);
+    }
+    if (mode == "Run") {
+        ReplayResult result;
+        if (!run(path, strategy, result)) return false;
+        logResult(strategy ? strategy->getName() : "book only", result);
+        return true;
+    }
+    if (mode == "Benchmark") {
+        if (!std::filesystem::exists(path) && !generateFeed(path)) return false;
+        ReplayResult bookOnly;
+        if (!run(path, nullptr, bookOnly)) return false;
+        logResult("book only", bookOnly);
+        if (strategy) {
+            ReplayResult traded;
+            if (!run(path, strategy, traded)) return false;
+            logResult(strategy->getName(), traded);
+        }
+        return true;
+    }
+    Utils::logMessage("ReplayRunner Error: Unknown /Replay/MODE '" + mode + "'");
+    return false;
+}
+
+void ReplayRunner::logResult(const std::string& label, const ReplayResult& result) {
+    const double rate = result.seconds > 0.0 ? result.records / result.seconds : 0.0;
+    std::string line = "Replay (" + label + "): " + std::to_string(result.records) + " records in " +
+                       std::to_string(result.seconds) + " s (" + std::to_string(static_cast<uint64_t>(rate)) +
+                       " updates/s), Final: " + std::to_string(result.finalValue) +
+                       ", Orders: " + std::to_string(result.orders) + ", Fills: " + std::to_string(result.fills) +
+                       ", Commission: " + std::to_string(result.commission);
+    Utils::logMessage(line);
+    std::cout << line << std::endl;
+}
@@ -0,0 +1,33 @@
+// ReplayStrategy.cpp
+#include "ReplayStrategy.h"
+
+int ReplayStrategy::submit(int symbolId, OrderType type, OrderKind kind, double size, double price) {
+    if (!engine) return -1;
+    Order order;
+    order.type = type;
+    order.kind = kind;
+    order.symbolId = symbolId;
+    order.requestedSize = size;
+    order.requestedPrice = price;
+    return engine->submitOrder(std::move(order));
+}
+
+int ReplayStrategy::buy(int symbolId, double size) {
+    return submit(symbolId, OrderType::BUY, OrderKind::MARKET, size, 0.0);
+}
+
+int ReplayStrategy::sell(int symbolId, double size) {
+    return submit(symbolId, OrderType::SELL, OrderKind::MARKET, size, 0.0);
+}
+
+int ReplayStrategy::buyLimit(int symbolId, double size, double price) {
+    return submit(symbolId, OrderType::BUY, OrderKind::LIMIT, size, price);
+}
+
+int ReplayStrategy::sellLimit(int symbolId, double size, double price) {
+    return submit(symbolId, OrderType::SELL, OrderKind::LIMIT, size, price);
+}
+
+bool ReplayStrategy::cancel(int orderId) {
+    return engine && engine->cancelOrder(orderId);
+}
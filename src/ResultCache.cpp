@@ -0,0 +1,112 @@
+// ResultCache.cpp
+#include "ResultCache.h"
+#include "BinaryIO.h"
+#include "Utils.h"
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    const char CACHE_MAGIC[4] = {'B', 'T', 'R', 'C'};
+    const uint32_t CACHE_VERSION = 3;
+}
+
+ResultCache::ResultCache(const std::string& dir) : dir_(dir) {
+}
+
+std::string ResultCache::entryPath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(dir_) / name).string();
+}
+
+uint64_t ResultCache::makeKey(const std::string& configDump, uint64_t dataFingerprint,
+                              const std::vector<std::string>& buildIds) {
+    uint64_t key = Utils::fnv1a(configDump.data(), configDump.size());
+    key = Utils::fnv1a(&dataFingerprint, sizeof(dataFingerprint), key);
+    for (const auto& id : buildIds) {
+        key = Utils::fnv1a(id.data(), id.size() + 1, key); // Include the terminator as a separator
+    }
+    return key;
+}
+
+bool ResultCache::load(uint64_t key, RunResult& result) const {
+    std::ifstream in(entryPath(key), std::ios::binary);
+    if (!in) return false;
+    try {
+        BinaryReader reader(in);
+        char magic[sizeof(CACHE_MAGIC)];
+        reader.readBytes(magic, sizeof(magic));
+        if (!std::equal(magic, magic + sizeof(magic), CACHE_MAGIC) || reader.read<uint32_t>() != CACHE_VERSION) {
+            return false;
+        }
+        RunResult loaded;
+        loaded.finalValue = reader.read<double>();
+        loaded.trades = reader.read<int32_t>();
+        loaded.profitableTrades = reader.read<int32_t>();
+        loaded.commission = reader.read<double>();
+        loaded.maxDrawdown = reader.read<double>();
+        loaded.equityCurve = reader.readDoubles();
+        size_t numOrders = reader.readSize();
+        loaded.tradeLog.reserve(numOrders);
+        for (size_t i = 0; i < numOrders; ++i) {
+            loaded.tradeLog.push_back(readOrder(reader));
+            loaded.tradeLog.back().symbolId = reader.read<int32_t>(); // Kept so a trade log export matches the run's
+        }
+        size_t numAccounts = reader.readSize();
+        size_t accountTotal = 0;
+        for (size_t a = 0; a < numAccounts; ++a) {
+            loaded.accountOrders.push_back(reader.readSize());
+            accountTotal += loaded.accountOrders.back();
+        }
+        if (accountTotal != numOrders) {
+            throw std::runtime_error("account order counts do not add up to the trade log");
+        }
+        loaded.fromCache = true;
+        result = std::move(loaded);
+        return true;
+    } catch (const std::exception& e) {
+        Utils::logMessage("ResultCache Warning: Ignoring unreadable entry " + entryPath(key) + ": " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool ResultCache::store(uint64_t key, const RunResult& result) const {
+    std::string path = entryPath(key);
+    std::string tmpPath = path + ".tmp";
+    try {
+        std::filesystem::create_directories(dir_);
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            BinaryWriter writer(out);
+            writer.writeBytes(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+            writer.write(CACHE_VERSION);
+            writer.write(result.finalValue);
+            writer.write(static_cast<int32_t>(result.trades));
+            writer.write(static_cast<int32_t>(result.profitableTrades));
+            writer.write(result.commission);
+            writer.write(result.maxDrawdown);
+            writer.writeDoubles(result.equityCurve);
+            writer.writeSize(result.tradeLog.size());
+            for (const Order& order : result.tradeLog) {
+                writeOrder(writer, order);
+                writer.write(static_cast<int32_t>(order.symbolId));
+            }
+            writer.writeSize(result.accountOrders.size());
+            for (size_t count : result.accountOrders) {
+                writer.writeSize(count);
+            }
+            if (!writer.good()) {
+                Utils::logMessage("ResultCache Error: Failed to write " + tmpPath);
+                return false;
+            }
+        }
+        std::filesystem::rename(tmpPath, path);
+        return true;
+    } catch (const std::exception& e) {
+        Utils::logMessage("ResultCache Error: Failed to store " + path + ": " + std::string(e.what()));
+        return false;
+    }
+}
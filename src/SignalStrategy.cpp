@@ -0,0 +1,99 @@
+// SignalStrategy.cpp
+#include "SignalStrategy.h"
+#include "Broker.h"
+#include "Config.h"
+#include "Utils.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void SignalStrategy::init() {
+    if (!config || !broker || !series) {
+        throw std::runtime_error("SignalStrategy::init Error: Config, Broker or data not set");
+    }
+    signalColumn_ = config->getNested<std::string>("/Vectorized/SIGNAL_COLUMN", "signal");
+    size_ = config->getNested<double>("/Vectorized/SIZE", 1.0);
+    if (series->columnIndex(signalColumn_) < 0) {
+        throw std::runtime_error("SignalStrategy::init Error: Signal column '" + signalColumn_ + "' not found");
+    }
+    symbolId_ = broker->getSymbolId(dataName);
+    metrics_ = std::make_unique<TradingMetrics>(broker->getStartingCash());
+    metrics_->setTotalBars(series->size());
+    Utils::logMessage("--- SignalStrategy Initialized (column '" + signalColumn_ + "', size " + std::to_string(size_) + ") ---");
+}
+
+void SignalStrategy::submit(OrderType type, double requestedSize, OrderReason reason) {
+    Order order;
+    order.type = type;
+    order.symbol = dataName;
+    order.symbolId = symbolId_;
+    order.reason = reason;
+    order.requestedSize = requestedSize;
+    broker->submitOrder(order);
+}
+
+void SignalStrategy::next(const Bar&, size_t, const double) {
+    if (broker->hasPendingOrders()) return; // Previous orders still in flight (order latency) or partly filled
+    const double signal = column(signalColumn_, 1).back();
+    const double target = std::isnan(signal) ? 0.0 : std::clamp(signal, -1.0, 1.0) * size_;
+    const Position* pos = broker->getPosition(symbolId_);
+    const double current = pos ? pos->size : 0.0;
+    if (target == current) return;
+
+    // Broker closing orders flatten the whole position, so a resize or
+    // reversal is a close followed by a fresh open
+    if (current != 0.0) {
+        submit(current > 0 ? OrderType::SELL : OrderType::BUY, std::abs(current), OrderReason::EXIT_SIGNAL);
+    }
+    if (target != 0.0) {
+        submit(target > 0 ? OrderType::BUY : OrderType::SELL, target, OrderReason::ENTRY_SIGNAL); // Signed size opens shorts
+    }
+}
+
+void SignalStrategy::stop() {
+    double finalValue = (data && !data->empty()) ? broker->getValue(data->back().columns[1]) : broker->getCash();
+    Utils::logMessage(metrics_->generateSummaryReport(finalValue, "SignalStrategy"));
+}
+
+void SignalStrategy::notifyOrder(const Order& order) {
+    if (order.status == OrderStatus::ACCEPTED && order.filledSize != 0.0) {
+        // Partly filled: the position holds what has filled and the rest keeps working;
+        // commission is recorded once, with the order's total, when it is done
+        Utils::logMessage("SignalStrategy: Order " + std::to_string(order.id) + " partly filled (" +
+                          std::to_string(order.filledSize) + " of " + std::to_string(order.requestedSize) + ")");
+        return;
+    }
+    if (order.status != OrderStatus::FILLED) {
+        Utils::logMessage("SignalStrategy: Order " + std::to_string(order.id) + " not filled (" +
+                          std::to_string(static_cast<int>(order.status)) + ")");
+        return;
+    }
+    metrics_->recordCommission(order.commission);
+    if (order.reason == OrderReason::EXIT_SIGNAL) {
+        metrics_->recordTrade(order.realizedPnL > 0.0);
+    }
+}
+
+void SignalStrategy::saveState(BinaryWriter& writer) const {
+    metrics_->saveState(writer);
+}
+
+void SignalStrategy::loadState(BinaryReader& reader) {
+    metrics_->loadState(reader);
+}
+
+// The position entering bar b was targeted at b-2 and the order filled at b
+// was submitted at b-1, so both signals flat means no position and nothing
+// pending. The only other state is metrics.
+std::vector<size_t> SignalStrategy::getResetPoints() const {
+    std::vector<size_t> points;
+    const int col = series->columnIndex(signalColumn_);
+    if (col < 0) return points;
+    const double* signal = series->column(static_cast<size_t>(col));
+    auto flat = [](double s) { return std::isnan(s) || s == 0.0; };
+    for (size_t b = 2; b < series->size(); ++b) {
+        if (flat(signal[b - 2]) && flat(signal[b - 1])) points.push_back(b);
+    }
+    return points;
+}
@@ -1,5 +1,110 @@
 #include "Strategy.h"
+#include "BinaryIO.h"
+#include "SimClock.h"
+#include <algorithm>
+#include <stdexcept>
 
 std::string Strategy::getName() const {
     return "BaseStrategy";
 }
+
+Indicator* Strategy::addIndicator(std::unique_ptr<Indicator> indicator) {
+    indicators.push_back(std::move(indicator));
+    return indicators.back().get();
+}
+
+Span<Bar> Strategy::history(size_t n) const {
+    if (!data || barIndex >= data->size()) {
+        throw std::out_of_range(getName() + "::history: no data at bar " + std::to_string(barIndex));
+    }
+    if (n > barsAvailable()) {
+        throw std::out_of_range(getName() + "::history: requested " + std::to_string(n) +
+                                " bars, only " + std::to_string(barsAvailable()) + " available");
+    }
+    return Span<Bar>(data->data() + (barIndex + 1 - n), n);
+}
+
+Span<double> Strategy::column(const std::string& name, size_t n) const {
+    int col = series ? series->columnIndex(name) : -1;
+    if (col < 0) {
+        throw std::out_of_range(getName() + "::column: unknown column '" + name + "'");
+    }
+    return column(static_cast<size_t>(col), n);
+}
+
+Span<double> Strategy::column(size_t col, size_t n) const {
+    if (!series || barIndex >= series->size() || col >= series->numColumns()) {
+        throw std::out_of_range(getName() + "::column: no column " + std::to_string(col) + " at bar " + std::to_string(barIndex));
+    }
+    if (n > barsAvailable()) {
+        throw std::out_of_range(getName() + "::column: requested " + std::to_string(n) +
+                                " bars, only " + std::to_string(barsAvailable()) + " available");
+    }
+    return Span<double>(series->column(col) + (barIndex + 1 - n), n);
+}
+
+void Strategy::sleepUntil(size_t bar) {
+    wakeHint.active = true;
+    wakeHint.untilBar = std::min(wakeHint.untilBar, bar);
+}
+
+void Strategy::wakeOnPriceCross(double below, double above) {
+    wakeHint.active = true;
+    wakeHint.below = std::max(wakeHint.below, below);
+    wakeHint.above = std::min(wakeHint.above, above);
+}
+
+void Strategy::wakeOnFill() {
+    wakeHint.active = true;
+    wakeHint.onFill = true;
+}
+
+TimerId Strategy::scheduleAt(std::chrono::system_clock::time_point due, std::chrono::system_clock::duration period) {
+    if (!timers) {
+        throw std::runtime_error(getName() + "::scheduleAt: no timer wheel, the strategy is not hosted by an engine");
+    }
+    return timers->schedule(timerOwner, due, period);
+}
+
+TimerId Strategy::scheduleAfter(std::chrono::system_clock::duration delay, std::chrono::system_clock::duration period) {
+    if (!clock) {
+        throw std::runtime_error(getName() + "::scheduleAfter: no clock, the strategy is not hosted by an engine");
+    }
+    return scheduleAt(clock->now() + delay, period);
+}
+
+bool Strategy::cancelTimer(TimerId id) {
+    return timers && timers->cancel(id);
+}
+
+size_t Strategy::getRequiredWarmup() const {
+    size_t warmup = getWarmupBars();
+    for (const auto& indicator : indicators) {
+        warmup = std::max(warmup, indicator->getMinPeriod());
+    }
+    return warmup;
+}
+
+void Strategy::updateIndicators(const Bar& bar) {
+    for (auto& indicator : indicators) {
+        indicator->update(bar);
+    }
+}
+
+void Strategy::saveCheckpoint(BinaryWriter& writer) const {
+    writer.write(wakeHint.active);
+    writer.writeSize(wakeHint.untilBar);
+    writer.write(wakeHint.below);
+    writer.write(wakeHint.above);
+    writer.write(wakeHint.onFill);
+    saveState(writer);
+}
+
+void Strategy::loadCheckpoint(BinaryReader& reader) {
+    wakeHint.active = reader.read<bool>();
+    wakeHint.untilBar = reader.readSize();
+    wakeHint.below = reader.read<double>();
+    wakeHint.above = reader.read<double>();
+    wakeHint.onFill = reader.read<bool>();
+    loadState(reader);
+}
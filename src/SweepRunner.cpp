@@ -0,0 +1,614 @@
+// SweepRunner.cpp
+#include "SweepRunner.h"
+#include "BacktestEngine.h"
+#include "Utils.h"
+#include "ResultCache.h"
+#include "CostModel.h"
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+SweepRunner::SweepRunner(const Config& cfg, const BarSeries& data) :
+    config(cfg),
+    series(data)
+{
+}
+
+std::vector<ParamSet> SweepRunner::expandGrid(const nlohmann::json& grid) {
+    std::vector<ParamSet> sets(1);
+    if (!grid.is_object()) return sets;
+
+    for (auto it = grid.begin(); it != grid.end(); ++it) {
+        nlohmann::json values = it.value().is_array() ? it.value() : nlohmann::json::array({it.value()});
+        if (values.empty()) continue;
+        std::vector<ParamSet> expanded;
+        expanded.reserve(sets.size() * values.size());
+        for (const auto& set : sets) {
+            for (const auto& v : values) {
+                ParamSet next = set;
+                next[it.key()] = v;
+                expanded.push_back(std::move(next));
+            }
+        }
+        sets = std::move(expanded);
+    }
+    return sets;
+}
+
+bool SweepRunner::checkGrid(const BatchStrategy& strategy, const nlohmann::json& grid) {
+    const std::vector<std::string> known = strategy.getParamPaths();
+    if (known.empty() || !grid.is_object()) return true;
+    bool ok = true;
+    for (auto it = grid.begin(); it != grid.end(); ++it) {
+        if (std::find(known.begin(), known.end(), it.key()) != known.end()) continue;
+        Utils::logMessage("SweepRunner Error: " + strategy.getName() + " does not read grid path '" + it.key() +
+                          "'; sweep it with /Sweep/EVALUATOR Engine.");
+        ok = false;
+    }
+    return ok;
+}
+
+void SweepRunner::useEngine(const std::vector<Bar>& bars, StrategySetup setup) {
+    engineBars = &bars;
+    strategySetup = std::move(setup);
+}
+
+uint64_t SweepRunner::cacheKey(const BatchStrategy& strategy, const ParamSet& params, uint64_t dataFingerprint) const {
+    nlohmann::json paramJson(params);
+    return ResultCache::makeKey(config.dump({"Engine", "Sweep"}) + "|lockstep|" + paramJson.dump(),
+                                dataFingerprint, {strategy.getBuildId()});
+}
+
+// --- Lock-step Mode ---
+std::vector<SweepResult> SweepRunner::runLockstep(BatchStrategy& strategy, const std::vector<ParamSet>& params) {
+    if (!config.getNested<bool>("/Engine/RESULT_CACHE", false)) {
+        return runParallel(strategy, params, series.size());
+    }
+
+    ResultCache cache(config.getNested<std::string>("/Engine/RESULT_CACHE_DIR", "result_cache"));
+    const uint64_t fingerprint = series.fingerprint();
+    std::vector<SweepResult> results(params.size());
+    std::vector<uint64_t> keys(params.size());
+    std::vector<size_t> missing;
+    std::vector<ParamSet> missingParams;
+    for (size_t k = 0; k < params.size(); ++k) {
+        keys[k] = cacheKey(strategy, params[k], fingerprint);
+        RunResult cached;
+        if (cache.load(keys[k], cached)) {
+            results[k].params = params[k];
+            results[k].finalValue = cached.finalValue;
+            results[k].trades = cached.trades;
+            results[k].profitableTrades = cached.profitableTrades;
+            results[k].commission = cached.commission;
+            results[k].maxDrawdown = cached.maxDrawdown;
+            results[k].fromCache = true;
+        } else {
+            missing.push_back(k);
+            missingParams.push_back(params[k]);
+        }
+    }
+    Utils::logMessage("SweepRunner: " + std::to_string(params.size() - missing.size()) + " of " +
+                      std::to_string(params.size()) + " parameter sets served from the result cache");
+    if (missing.empty()) return results;
+
+    std::vector<SweepResult> computed = runParallel(strategy, missingParams, series.size());
+    if (computed.size() != missing.size()) return computed; // Pass failed, already logged
+    for (size_t m = 0; m < missing.size(); ++m) {
+        const SweepResult& r = computed[m];
+        results[missing[m]] = r;
+        if (!r.stopReason.empty()) continue; // A truncated run is not the result of its parameters
+        RunResult entry;
+        entry.finalValue = r.finalValue;
+        entry.trades = r.trades;
+        entry.profitableTrades = r.profitableTrades;
+        entry.commission = r.commission;
+        entry.maxDrawdown = r.maxDrawdown;
+        cache.store(keys[missing[m]], entry);
+    }
+    return results;
+}
+
+std::vector<SweepResult> SweepRunner::runParallel(BatchStrategy& strategy, const std::vector<ParamSet>& params, size_t endBar) {
+    int configured = config.getNested<int>("/Sweep/THREADS", 0);
+    size_t threads = configured > 0 ? static_cast<size_t>(configured) : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, params.size());
+    if (threads <= 1) return runLockstepPass(strategy, params, endBar);
+
+    std::vector<std::unique_ptr<BatchStrategy>> clones;
+    for (size_t t = 0; t < threads; ++t) {
+        clones.push_back(strategy.clone());
+        if (!clones.back()) {
+            Utils::logMessage("SweepRunner: " + strategy.getName() + " cannot be cloned, running a single pass.");
+            return runLockstepPass(strategy, params, endBar);
+        }
+    }
+
+    std::vector<std::future<std::vector<SweepResult>>> futures;
+    for (size_t t = 0; t < threads; ++t) {
+        size_t begin = params.size() * t / threads;
+        size_t end = params.size() * (t + 1) / threads;
+        std::vector<ParamSet> chunk(params.begin() + begin, params.begin() + end);
+        futures.emplace_back(std::async(std::launch::async, [this, &clones, t, endBar, chunk = std::move(chunk)] {
+            return runLockstepPass(*clones[t], chunk, endBar);
+        }));
+    }
+    std::vector<SweepResult> results;
+    results.reserve(params.size());
+    for (auto& future : futures) {
+        std::vector<SweepResult> part = future.get();
+        results.insert(results.end(), part.begin(), part.end());
+    }
+    if (results.size() != params.size()) {
+        Utils::logMessage("SweepRunner Error: A parallel lock-step pass failed.");
+        results.clear();
+    }
+    return results;
+}
+
+// --- Engine-backed Evaluation ---
+std::vector<SweepResult> SweepRunner::runEngines(const std::vector<ParamSet>& params, size_t endBar) {
+    if (!engineBars || !strategySetup || params.empty() || series.empty()) {
+        Utils::logMessage("SweepRunner Error: Engine evaluation needs parameter sets, loaded bars and a strategy setup.");
+        return {};
+    }
+
+    // A shorter rung runs on a copy of its prefix, so the engines simulate
+    // (and cache results for) exactly those bars
+    const std::vector<Bar>* bars = engineBars;
+    const BarSeries* view = &series;
+    std::vector<Bar> prefixBars;
+    BarSeries prefixSeries;
+    if (endBar < engineBars->size()) {
+        prefixBars.assign(engineBars->begin(), engineBars->begin() + endBar);
+        prefixSeries = series.head(endBar);
+        bars = &prefixBars;
+        view = &prefixSeries;
+    }
+
+    const double startCash = config.getNested<double>("/Broker/STARTING_CASH", 1000.0);
+    std::vector<SweepResult> results(params.size());
+    std::atomic<size_t> nextSet{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        for (size_t k = nextSet++; k < params.size() && !failed.load(); k = nextSet++) {
+            SweepResult& out = results[k];
+            out.params = params[k];
+            if (cancelRequested.load(std::memory_order_relaxed)) {
+                out.finalValue = startCash;
+                out.stopReason = "cancelled";
+                continue;
+            }
+            try {
+                Config candidate = config;
+                for (const auto& entry : params[k]) {
+                    if (!candidate.setNested(entry.first, entry.second)) throw std::runtime_error("invalid grid path " + entry.first);
+                }
+                BacktestEngine engine(candidate, *bars, *view);
+                strategySetup(engine, candidate);
+                engine.run();
+                const RunResult& r = engine.getResult();
+                out.finalValue = r.finalValue;
+                out.trades = r.trades;
+                out.profitableTrades = r.profitableTrades;
+                out.commission = r.commission;
+                out.maxDrawdown = r.maxDrawdown;
+                out.fromCache = r.fromCache;
+                out.stopReason = r.stopReason;
+            } catch (const std::exception& e) {
+                Utils::logMessage("SweepRunner Error: Engine run failed: " + std::string(e.what()));
+                failed.store(true);
+            }
+        }
+    };
+
+    Utils::logMessage("SweepRunner: Engine runs over " + std::to_string(view->size()) + " bars for " +
+                      std::to_string(params.size()) + " parameter sets");
+    int configured = config.getNested<int>("/Sweep/THREADS", 0);
+    size_t threads = configured > 0 ? static_cast<size_t>(configured) : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, params.size());
+    std::vector<std::future<void>> futures;
+    for (size_t t = 1; t < threads; ++t) futures.emplace_back(std::async(std::launch::async, worker));
+    worker();
+    for (auto& future : futures) future.get();
+    if (failed.load()) results.clear();
+    return results;
+}
+
+// --- Successive Halving ---
+std::vector<SweepResult> SweepRunner::runHalving(BatchStrategy& strategy, const nlohmann::json& grid) {
+    std::vector<ParamSet> candidates = expandGrid(grid);
+    const size_t totalBars = series.size();
+    const double eta = std::max(2.0, config.getNested<double>("/Sweep/ETA", 3.0));
+    double fraction = std::clamp(config.getNested<double>("/Sweep/MIN_FRACTION", 0.1), 0.0, 1.0);
+    const size_t surrogatePoints = static_cast<size_t>(std::max(0, config.getNested<int>("/Sweep/SURROGATE_POINTS", 0)));
+    std::mt19937_64 rng(static_cast<uint64_t>(config.getNested<int>("/Sweep/SEED", 42)));
+    const size_t gridSize = candidates.size();
+    double evaluatedBars = 0.0;
+
+    auto byValue = [](const SweepResult& a, const SweepResult& b) { return a.finalValue > b.finalValue; };
+    std::vector<SweepResult> results;
+    for (int rung = 0; ; ++rung) {
+        size_t endBar = std::clamp(static_cast<size_t>(std::ceil(fraction * totalBars - 1e-9)), size_t(1), totalBars);
+        results = strategySetup ? runEngines(candidates, endBar) : runParallel(strategy, candidates, endBar);
+        if (results.size() != candidates.size()) return results; // Pass failed, already logged
+        evaluatedBars += static_cast<double>(endBar) * candidates.size();
+        std::stable_sort(results.begin(), results.end(), byValue);
+        nlohmann::json best(results.front().params);
+        Utils::logMessage("SweepRunner: Rung " + std::to_string(rung) + ": " + std::to_string(candidates.size()) +
+                          " candidates on the first " + std::to_string(endBar) + " bars, best " +
+                          std::to_string(results.front().finalValue) + " " + best.dump());
+        if (endBar >= totalBars) break;
+
+        size_t keep = std::max<size_t>(1, static_cast<size_t>(candidates.size() / eta));
+        candidates.clear();
+        for (size_t k = 0; k < keep; ++k) candidates.push_back(results[k].params);
+        for (ParamSet& proposal : proposeCandidates(grid, results, surrogatePoints, rng)) {
+            candidates.push_back(std::move(proposal));
+        }
+        fraction = std::min(1.0, fraction * eta);
+    }
+
+    if (gridSize > 0 && totalBars > 0) {
+        Utils::logMessage("SweepRunner: Halving evaluated " + std::to_string(evaluatedBars / (static_cast<double>(gridSize) * totalBars) * 100.0) +
+                          "% of the bars of an exhaustive grid run");
+    }
+    return results;
+}
+
+// --- Genetic Search ---
+std::vector<SweepResult> SweepRunner::runGenetic(BatchStrategy& strategy, const nlohmann::json& grid) {
+    using Genome = std::vector<size_t>;
+    std::vector<std::string> paths;
+    std::vector<nlohmann::json> choices;
+    if (grid.is_object()) {
+        for (auto it = grid.begin(); it != grid.end(); ++it) {
+            nlohmann::json values = it.value().is_array() ? it.value() : nlohmann::json::array({it.value()});
+            if (values.empty()) continue;
+            paths.push_back(it.key());
+            choices.push_back(std::move(values));
+        }
+    }
+    if (paths.empty()) {
+        Utils::logMessage("SweepRunner Error: Genetic search needs a non-empty /Sweep/GRID.");
+        return {};
+    }
+
+    const size_t population = static_cast<size_t>(std::max(2, config.getNested<int>("/Sweep/GENETIC/POPULATION", 32)));
+    const int generations = std::max(1, config.getNested<int>("/Sweep/GENETIC/GENERATIONS", 20));
+    const size_t elite = std::min(population, static_cast<size_t>(std::max(0, config.getNested<int>("/Sweep/GENETIC/ELITE", 2))));
+    const bool tournament = config.getNested<std::string>("/Sweep/GENETIC/SELECTION", "Tournament") != "Rank";
+    const size_t tournamentSize = static_cast<size_t>(std::max(1, config.getNested<int>("/Sweep/GENETIC/TOURNAMENT_SIZE", 3)));
+    const bool onePoint = config.getNested<std::string>("/Sweep/GENETIC/CROSSOVER", "Uniform") == "OnePoint";
+    const double crossoverRate = std::clamp(config.getNested<double>("/Sweep/GENETIC/CROSSOVER_RATE", 0.9), 0.0, 1.0);
+    const double mutationRate = std::clamp(config.getNested<double>("/Sweep/GENETIC/MUTATION_RATE", 0.1), 0.0, 1.0);
+    std::mt19937_64 rng(static_cast<uint64_t>(config.getNested<int>("/Sweep/SEED", 42)));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto randomIndex = [&rng](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+
+    auto toParams = [&](const Genome& genome) {
+        ParamSet params;
+        for (size_t g = 0; g < genome.size(); ++g) params[paths[g]] = choices[g][genome[g]];
+        return params;
+    };
+
+    // --- Fitness, memoized by genome across generations ---
+    std::map<Genome, SweepResult> memo;
+    size_t reused = 0;
+    auto evaluate = [&](const std::vector<Genome>& genomes) {
+        std::vector<Genome> fresh;
+        std::vector<ParamSet> params;
+        for (const Genome& genome : genomes) {
+            if (memo.count(genome) || std::find(fresh.begin(), fresh.end(), genome) != fresh.end()) {
+                ++reused;
+                continue;
+            }
+            fresh.push_back(genome);
+            params.push_back(toParams(genome));
+        }
+        if (params.empty()) return true;
+        std::vector<SweepResult> results = strategySetup ? runEngines(params, series.size()) : runLockstep(strategy, params);
+        if (results.size() != params.size()) return false; // Already logged
+        for (size_t k = 0; k < fresh.size(); ++k) memo[fresh[k]] = results[k];
+        return true;
+    };
+    auto fitness = [&memo](const Genome& genome) { return memo.at(genome).finalValue; };
+
+    std::vector<Genome> pop(population, Genome(paths.size()));
+    for (Genome& genome : pop) {
+        for (size_t g = 0; g < genome.size(); ++g) genome[g] = randomIndex(choices[g].size());
+    }
+
+    for (int gen = 0; ; ++gen) {
+        if (!evaluate(pop)) return {};
+        std::stable_sort(pop.begin(), pop.end(), [&](const Genome& a, const Genome& b) { return fitness(a) > fitness(b); });
+        nlohmann::json best(toParams(pop.front()));
+        Utils::logMessage("SweepRunner: Generation " + std::to_string(gen) + " best " + std::to_string(fitness(pop.front())) +
+                          " " + best.dump() + " (" + std::to_string(memo.size()) + " genomes evaluated, " +
+                          std::to_string(reused) + " reused)");
+        if (gen + 1 >= generations || cancelRequested.load()) break;
+
+        // --- Selection (pop is sorted best first) ---
+        auto select = [&]() -> const Genome& {
+            if (tournament) {
+                size_t winner = randomIndex(pop.size());
+                for (size_t t = 1; t < tournamentSize; ++t) winner = std::min(winner, randomIndex(pop.size()));
+                return pop[winner];
+            }
+            // Linear ranking: rank r (0 = best) has weight n - r
+            const size_t n = pop.size();
+            double pick = unit(rng) * n * (n + 1) / 2.0;
+            for (size_t r = 0; r < n; ++r) {
+                pick -= static_cast<double>(n - r);
+                if (pick <= 0.0) return pop[r];
+            }
+            return pop.back();
+        };
+
+        std::vector<Genome> next(pop.begin(), pop.begin() + elite);
+        while (next.size() < population) {
+            Genome child = select();
+            if (unit(rng) < crossoverRate) {
+                const Genome& other = select();
+                if (onePoint) {
+                    size_t cut = randomIndex(child.size() + 1);
+                    std::copy(other.begin() + cut, other.end(), child.begin() + cut);
+                } else {
+                    for (size_t g = 0; g < child.size(); ++g) {
+                        if (unit(rng) < 0.5) child[g] = other[g];
+                    }
+                }
+            }
+            for (size_t g = 0; g < child.size(); ++g) {
+                if (unit(rng) < mutationRate) child[g] = randomIndex(choices[g].size());
+            }
+            next.push_back(std::move(child));
+        }
+        pop = std::move(next);
+    }
+
+    std::vector<SweepResult> results;
+    std::vector<Genome> distinct;
+    for (const Genome& genome : pop) {
+        if (std::find(distinct.begin(), distinct.end(), genome) != distinct.end()) continue;
+        distinct.push_back(genome);
+        results.push_back(memo.at(genome));
+    }
+    return results;
+}
+
+std::vector<ParamSet> SweepRunner::proposeCandidates(const nlohmann::json& grid, const std::vector<SweepResult>& evaluated,
+                                                     size_t count, std::mt19937_64& rng) const {
+    std::vector<ParamSet> proposals;
+    if (count == 0 || evaluated.empty() || !grid.is_object()) return proposals;
+
+    // Numeric dimensions of the grid, searched in unit coordinates
+    struct Dimension {
+        std::string path;
+        double lo;
+        double hi;
+        bool integer;
+    };
+    std::vector<Dimension> dims;
+    for (auto it = grid.begin(); it != grid.end(); ++it) {
+        if (!it.value().is_array() || it.value().empty()) continue;
+        Dimension dim{it.key(), std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), true};
+        bool numeric = true;
+        for (const auto& v : it.value()) {
+            numeric = numeric && v.is_number();
+            if (!numeric) break;
+            dim.lo = std::min(dim.lo, v.get<double>());
+            dim.hi = std::max(dim.hi, v.get<double>());
+            dim.integer = dim.integer && v.is_number_integer();
+        }
+        if (numeric && dim.hi > dim.lo) dims.push_back(dim);
+    }
+    if (dims.empty()) return proposals;
+
+    const size_t d = dims.size();
+    std::vector<double> points; // Row-major, one row per evaluated set
+    std::vector<double> scores;
+    double best = -std::numeric_limits<double>::infinity();
+    double worst = std::numeric_limits<double>::infinity();
+    for (const SweepResult& r : evaluated) {
+        for (const Dimension& dim : dims) {
+            auto it = r.params.find(dim.path);
+            double v = (it != r.params.end() && it->second.is_number()) ? it->second.get<double>() : dim.lo;
+            points.push_back((v - dim.lo) / (dim.hi - dim.lo));
+        }
+        scores.push_back(r.finalValue);
+        best = std::max(best, r.finalValue);
+        worst = std::min(worst, r.finalValue);
+    }
+    for (double& s : scores) s = best > worst ? (s - worst) / (best - worst) : 0.5;
+
+    // Acquisition: Nadaraya-Watson mean + distance to the nearest evaluated point
+    const double bandwidth = 0.15;
+    const double explore = 1.0;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<std::pair<double, std::vector<double>>> samples(64 * count);
+    for (auto& sample : samples) {
+        sample.second.resize(d);
+        for (double& x : sample.second) x = unit(rng);
+        double weightSum = 0.0, weighted = 0.0, nearest = std::numeric_limits<double>::infinity();
+        for (size_t e = 0; e < scores.size(); ++e) {
+            double dist2 = 0.0;
+            for (size_t j = 0; j < d; ++j) {
+                double diff = sample.second[j] - points[e * d + j];
+                dist2 += diff * diff;
+            }
+            double w = std::exp(-dist2 / (2.0 * bandwidth * bandwidth));
+            weightSum += w;
+            weighted += w * scores[e];
+            nearest = std::min(nearest, dist2);
+        }
+        double mean = weightSum > 1e-12 ? weighted / weightSum : 0.5;
+        sample.first = mean + explore * std::sqrt(nearest / d);
+    }
+    std::sort(samples.begin(), samples.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    for (const auto& sample : samples) {
+        if (proposals.size() >= count) break;
+        ParamSet proposal = evaluated.front().params; // Non-numeric parameters from the best set
+        for (size_t j = 0; j < d; ++j) {
+            double v = dims[j].lo + sample.second[j] * (dims[j].hi - dims[j].lo);
+            if (dims[j].integer) proposal[dims[j].path] = static_cast<long long>(std::llround(v));
+            else proposal[dims[j].path] = v;
+        }
+        bool seen = std::find(proposals.begin(), proposals.end(), proposal) != proposals.end();
+        for (const SweepResult& r : evaluated) seen = seen || r.params == proposal;
+        if (!seen) proposals.push_back(std::move(proposal));
+    }
+    return proposals;
+}
+
+std::vector<SweepResult> SweepRunner::runLockstepPass(BatchStrategy& strategy, const std::vector<ParamSet>& params, size_t endBar) {
+    std::vector<SweepResult> results;
+    const double* prices = series.prices();
+    if (params.empty() || series.empty() || !prices) {
+        Utils::logMessage("SweepRunner Error: Lock-step run needs parameter sets and a series with a price column.");
+        return results;
+    }
+
+    const size_t n = params.size();
+    const size_t totalBars = std::min(endBar, series.size());
+    const double startCash = config.getNested<double>("/Broker/STARTING_CASH", 1000.0);
+    const CommissionModel commissionModel = CommissionModel::fromConfig(config);
+    SlippageModel slippageModel = SlippageModel::fromConfig(config);
+    slippageModel.resolveColumns(series);
+
+    // --- Budgets ---
+    const double maxSeconds = config.getNested<double>("/Engine/MAX_SECONDS", 0.0);
+    const size_t maxBars = static_cast<size_t>(std::max(0, config.getNested<int>("/Engine/MAX_BARS", 0)));
+    const int maxOrders = std::max(0, config.getNested<int>("/Engine/MAX_ORDERS", 0));
+    const double maxDrawdownStop = config.getNested<double>("/Engine/MAX_DRAWDOWN", 0.0);
+    const size_t checkInterval = static_cast<size_t>(std::max(1, config.getNested<int>("/Engine/BUDGET_CHECK_INTERVAL", 256)));
+    const auto budgetStart = std::chrono::steady_clock::now();
+
+    Utils::logMessage("SweepRunner: Lock-step " + strategy.getName() + " over " + std::to_string(totalBars) +
+                      " bars for " + std::to_string(n) + " parameter sets");
+    auto startTime = std::chrono::high_resolution_clock::now();
+    strategy.init(params, config, series);
+
+    // --- Accounts (SoA) ---
+    std::vector<double> equity(n, startCash), position(n, 0.0), target(n, 0.0), entry(n, 0.0);
+    std::vector<double> commission(n, 0.0), peak(n, startCash), maxDrawdown(n, 0.0);
+    std::vector<int> trades(n, 0), wins(n, 0), orders(n, 0);
+    std::vector<std::string> stopReason(n);
+    size_t stoppedSets = 0;
+    std::string passStopReason;
+
+    double prevPrice = prices[0];
+    for (size_t i = 0; i < totalBars; ++i) {
+        const double price = prices[i];
+        if (std::isnan(price)) continue;
+        const double change = price - prevPrice;
+
+        // Fill last bar's targets at this bar's price, net of the broker's costs, and mark to market
+        for (size_t k = 0; k < n; ++k) {
+            const double pos = position[k];
+            const double tgt = target[k];
+            double fee = 0.0;
+            double slip = 0.0;
+            if (tgt != pos) {
+                const RebalanceCost cost(commissionModel, slippageModel, series, i, price, pos, tgt);
+                fee = cost.commission;
+                slip = cost.slippage;
+            }
+            // A round trip closes when an open position is flattened or reversed
+            const bool closes = (pos != 0.0) & ((tgt == 0.0) | ((tgt > 0.0) != (pos > 0.0)));
+            const bool win = closes & ((price - entry[k]) * pos > 0.0);
+            const bool opens = (tgt != 0.0) & ((pos == 0.0) | closes);
+
+            const double eq = equity[k] + pos * change - fee - slip;
+            equity[k] = eq;
+            commission[k] += fee;
+            trades[k] += closes;
+            wins[k] += win;
+            orders[k] += closes + opens;
+            entry[k] = opens ? price : entry[k];
+            position[k] = tgt;
+
+            const double pk = std::max(peak[k], eq);
+            peak[k] = pk;
+            const double dd = pk > 0.0 ? (pk - eq) / pk * 100.0 : 0.0;
+            maxDrawdown[k] = std::max(maxDrawdown[k], dd);
+        }
+
+        strategy.next(i, position.data(), target.data());
+        prevPrice = price;
+
+        // --- Budgets and early-stop rules ---
+        if (stoppedSets > 0) {
+            bool allFlat = true;
+            for (size_t k = 0; k < n; ++k) {
+                if (stopReason[k].empty()) { allFlat = false; continue; }
+                target[k] = 0.0; // Stopped sets are flattened on the next bar and stay flat
+                allFlat = allFlat && position[k] == 0.0;
+            }
+            if (allFlat) {
+                Utils::logMessage("SweepRunner: Every parameter set stopped early at bar " + std::to_string(i));
+                break;
+            }
+        }
+        if ((i + 1) % checkInterval != 0) continue;
+        if (cancelRequested.load(std::memory_order_relaxed)) {
+            passStopReason = "cancelled";
+        } else if (maxBars > 0 && i + 1 >= maxBars) {
+            passStopReason = "bar budget of " + std::to_string(maxBars) + " reached";
+        } else if (maxSeconds > 0.0 &&
+                   std::chrono::duration<double>(std::chrono::steady_clock::now() - budgetStart).count() >= maxSeconds) {
+            passStopReason = "time budget of " + std::to_string(maxSeconds) + " seconds reached";
+        }
+        if (!passStopReason.empty()) {
+            Utils::logMessage("SweepRunner: Pass stopped early at bar " + std::to_string(i) + ": " + passStopReason);
+            break;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (!stopReason[k].empty()) continue;
+            if (maxDrawdownStop > 0.0 && maxDrawdown[k] > maxDrawdownStop) {
+                stopReason[k] = "drawdown above " + std::to_string(maxDrawdownStop) + "% at bar " + std::to_string(i);
+            } else if (maxOrders > 0 && orders[k] >= maxOrders) {
+                stopReason[k] = "order budget of " + std::to_string(maxOrders) + " reached at bar " + std::to_string(i);
+            } else {
+                continue;
+            }
+            target[k] = 0.0;
+            ++stoppedSets;
+        }
+    }
+
+    results.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        results[k].params = params[k];
+        results[k].finalValue = equity[k];
+        results[k].trades = trades[k];
+        results[k].profitableTrades = wins[k];
+        results[k].commission = commission[k];
+        results[k].maxDrawdown = maxDrawdown[k];
+        results[k].stopReason = stopReason[k].empty() ? passStopReason : stopReason[k];
+    }
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - startTime;
+    Utils::logMessage("SweepRunner: Lock-step pass finished in " + std::to_string(duration.count()) + " seconds");
+    return results;
+}
+
+void SweepRunner::logResults(const std::vector<SweepResult>& results) {
+    for (size_t k = 0; k < results.size(); ++k) {
+        const SweepResult& r = results[k];
+        nlohmann::json params(r.params);
+        Utils::logMessage("Sweep #" + std::to_string(k) + " " + params.dump() +
+                          " Final: " + std::to_string(r.finalValue) +
+                          ", Trades: " + std::to_string(r.trades) +
+                          ", Wins: " + std::to_string(r.profitableTrades) +
+                          ", Commission: " + std::to_string(r.commission) +
+                          ", MaxDD: " + std::to_string(r.maxDrawdown) + "%" +
+                          (r.fromCache ? " (cached)" : "") +
+                          (r.stopReason.empty() ? "" : " (stopped: " + r.stopReason + ")"));
+    }
+}
@@ -0,0 +1,287 @@
+// TimerWheel.cpp
+#include "TimerWheel.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    // Index of the lowest set bit (word must be non-zero), via a de Bruijn
+    // multiply so it stays portable without compiler intrinsics
+    inline int lowestBit(uint64_t word) {
+        static const int table[64] = {
+            0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6};
+        return table[((word & (~word + 1)) * 0x03F79D71B4CB0A89ULL) >> 58];
+    }
+}
+
+TimerWheel::TimerWheel(duration resolution) : resolution_(resolution) {
+    if (resolution_ <= duration::zero()) {
+        throw std::runtime_error("TimerWheel Error: Resolution must be positive");
+    }
+    reset(time_point{}, time_point{});
+}
+
+void TimerWheel::reset(time_point origin, time_point now) {
+    origin_ = origin;
+    nodes_.clear();
+    free_.clear();
+    heads_.fill(NIL);
+    tails_.fill(NIL);
+    for (auto& level : occupied_) level.fill(0);
+    live_ = 0;
+    now_ = now > origin_ ? static_cast<uint64_t>((now - origin_) / resolution_) : 0;
+}
+
+uint64_t TimerWheel::toTick(time_point t) const {
+    if (t <= origin_) return 0;
+    const auto elapsed = (t - origin_).count();
+    const auto step = resolution_.count();
+    return static_cast<uint64_t>((elapsed + step - 1) / step);
+}
+
+// --- Slot Lists ---
+void TimerWheel::link(uint32_t index, uint32_t slot) {
+    Node& node = nodes_[index];
+    node.slot = slot;
+    node.prev = tails_[slot];
+    node.next = NIL;
+    if (tails_[slot] == NIL) {
+        heads_[slot] = index;
+    } else {
+        nodes_[tails_[slot]].next = index;
+    }
+    tails_[slot] = index;
+    if (slot < READY) {
+        occupied_[slot / SLOTS][(slot % SLOTS) / 64] |= 1ULL << (slot % 64);
+    }
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev == NIL) heads_[node.slot] = node.next; else nodes_[node.prev].next = node.next;
+    if (node.next == NIL) tails_[node.slot] = node.prev; else nodes_[node.next].prev = node.prev;
+    if (heads_[node.slot] == NIL && node.slot < READY) {
+        occupied_[node.slot / SLOTS][(node.slot % SLOTS) / 64] &= ~(1ULL << (node.slot % 64));
+    }
+    node.slot = NIL;
+    node.prev = node.next = NIL;
+}
+
+// Level L holds timers due in the block (tick >> 8L) that is 1..256 blocks
+// ahead of the current one, so each slot is cascaded exactly when its block starts
+void TimerWheel::place(uint32_t index) {
+    const uint64_t tick = nodes_[index].tick;
+    if (tick <= now_) {
+        link(index, READY);
+        return;
+    }
+    const uint64_t delta = tick - now_;
+    for (int level = 0; level < LEVELS; ++level) {
+        if (delta < (1ULL << (LEVEL_BITS * (level + 1)))) {
+            link(index, static_cast<uint32_t>(level * SLOTS + ((tick >> (LEVEL_BITS * level)) & SLOT_MASK)));
+            return;
+        }
+    }
+    // Beyond the wheel: park in the furthest top-level slot and re-place on cascade
+    const uint64_t parked = now_ + (1ULL << (LEVEL_BITS * LEVELS)) - 1;
+    link(index, static_cast<uint32_t>((LEVELS - 1) * SLOTS + ((parked >> (LEVEL_BITS * (LEVELS - 1))) & SLOT_MASK)));
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.live = false;
+    node.generation++;
+    free_.push_back(index);
+    live_--;
+}
+
+uint64_t TimerWheel::nextOccupied(int level) const {
+    const auto& bits = occupied_[level];
+    const uint64_t current = (now_ >> (LEVEL_BITS * level)) & SLOT_MASK;
+    const uint64_t start = (current + 1) & SLOT_MASK;
+    const size_t words = SLOTS / 64;
+    // First set bit from start, wrapping round to current itself (the start
+    // word is visited twice: masked first, whole at the end)
+    for (size_t k = 0; k <= words; ++k) {
+        const size_t w = (start / 64 + k) % words;
+        uint64_t word = bits[w];
+        if (k == 0) word &= ~0ULL << (start % 64);
+        if (word) {
+            const uint64_t distance = (w * 64 + lowestBit(word) - current) & SLOT_MASK;
+            return distance == 0 ? SLOTS : distance;
+        }
+    }
+    return 0;
+}
+
+void TimerWheel::cascade(int level) {
+    const uint32_t slot = static_cast<uint32_t>(level * SLOTS + ((now_ >> (LEVEL_BITS * level)) & SLOT_MASK));
+    uint32_t index = heads_[slot];
+    heads_[slot] = tails_[slot] = NIL;
+    occupied_[level][(slot % SLOTS) / 64] &= ~(1ULL << (slot % 64));
+    while (index != NIL) {
+        const uint32_t next = nodes_[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+void TimerWheel::expire(uint32_t slot, time_point now, std::vector<Expired>& expired) {
+    uint32_t index = heads_[slot];
+    if (index == NIL) return;
+    heads_[slot] = tails_[slot] = NIL;
+    if (slot < READY) {
+        occupied_[slot / SLOTS][(slot % SLOTS) / 64] &= ~(1ULL << (slot % 64));
+    }
+    while (index != NIL) {
+        Node& node = nodes_[index];
+        const uint32_t next = node.next;
+        expired.push_back({(static_cast<uint64_t>(node.generation) << 32) | index, node.owner, node.due});
+        if (node.period > duration::zero()) {
+            const auto missed = (now - node.due) / node.period; // Whole periods already passed
+            node.due += node.period * (std::max<int64_t>(missed, 0) + 1);
+            node.tick = toTick(node.due);
+            node.prev = node.next = NIL;
+            place(index);
+        } else {
+            release(index);
+        }
+        index = next;
+    }
+}
+
+// --- Public Interface ---
+TimerId TimerWheel::schedule(int owner, time_point due, duration period) {
+    uint32_t index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        if (nodes_.size() >= NIL) throw std::runtime_error("TimerWheel Error: Too many timers");
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    Node& node = nodes_[index];
+    node.live = true;
+    node.owner = owner;
+    node.due = due;
+    node.period = std::max(period, duration::zero());
+    node.tick = toTick(due);
+    live_++;
+    place(index);
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    const uint64_t index = id & 0xFFFFFFFFULL;
+    if (index >= nodes_.size()) return false;
+    Node& node = nodes_[index];
+    if (!node.live || node.generation != static_cast<uint32_t>(id >> 32)) return false;
+    unlink(static_cast<uint32_t>(index));
+    release(static_cast<uint32_t>(index));
+    return true;
+}
+
+void TimerWheel::advance(time_point now, std::vector<Expired>& expired) {
+    const uint64_t target = std::max(now_, now > origin_ ? static_cast<uint64_t>((now - origin_) / resolution_) : uint64_t{0});
+    expire(READY, now, expired);
+    while (live_ > 0) {
+        // Next tick where a level-0 slot expires or a higher slot cascades
+        uint64_t next = std::numeric_limits<uint64_t>::max();
+        for (int level = 0; level < LEVELS; ++level) {
+            const uint64_t distance = nextOccupied(level);
+            if (distance == 0) continue;
+            const int shift = LEVEL_BITS * level;
+            next = std::min(next, (((now_ >> shift) + distance) << shift));
+        }
+        if (next > target) break;
+        now_ = next;
+        for (int level = LEVELS - 1; level > 0; --level) {
+            if ((now_ & ((1ULL << (LEVEL_BITS * level)) - 1)) == 0) cascade(level);
+        }
+        expire(static_cast<uint32_t>(now_ & SLOT_MASK), now, expired);
+        expire(READY, now, expired); // Cascaded timers due on this very tick
+    }
+    now_ = target;
+}
+
+TimerWheel::time_point TimerWheel::nextDue() const {
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    for (uint32_t index = heads_[READY]; index != NIL; index = nodes_[index].next) {
+        best = std::min(best, nodes_[index].tick);
+    }
+    // The first occupied slot of each level holds that level's earliest timers
+    for (int level = 0; level < LEVELS; ++level) {
+        const uint64_t distance = nextOccupied(level);
+        if (distance == 0) continue;
+        const uint32_t slot = static_cast<uint32_t>(level * SLOTS + (((now_ >> (LEVEL_BITS * level)) + distance) & SLOT_MASK));
+        for (uint32_t index = heads_[slot]; index != NIL; index = nodes_[index].next) {
+            best = std::min(best, nodes_[index].tick);
+        }
+    }
+    if (best == std::numeric_limits<uint64_t>::max()) return time_point::max();
+    return origin_ + resolution_ * static_cast<int64_t>(best);
+}
+
+// --- Checkpoint ---
+void TimerWheel::saveState(BinaryWriter& writer) const {
+    writer.write(static_cast<int64_t>(resolution_.count()));
+    writer.writeTime(origin_);
+    writer.write(now_);
+    writer.writeSize(nodes_.size());
+    for (const Node& node : nodes_) {
+        writer.write(node.generation);
+    }
+    writer.writeSize(free_.size());
+    for (uint32_t index : free_) {
+        writer.write(index);
+    }
+    writer.writeSize(live_);
+    for (uint32_t slot = 0; slot <= READY; ++slot) {
+        for (uint32_t index = heads_[slot]; index != NIL; index = nodes_[index].next) {
+            const Node& node = nodes_[index];
+            writer.write(index);
+            writer.write(slot);
+            writer.write(node.owner);
+            writer.writeTime(node.due);
+            writer.write(static_cast<int64_t>(node.period.count()));
+            writer.write(node.tick);
+        }
+    }
+}
+
+void TimerWheel::loadState(BinaryReader& reader) {
+    if (reader.read<int64_t>() != static_cast<int64_t>(resolution_.count())) {
+        throw std::runtime_error("TimerWheel Error: Checkpoint was written with a different resolution");
+    }
+    reset(reader.readTime(), time_point{});
+    now_ = reader.read<uint64_t>();
+    nodes_.resize(reader.readSize());
+    for (Node& node : nodes_) {
+        node.generation = reader.read<uint32_t>();
+    }
+    free_.resize(reader.readSize());
+    for (uint32_t& index : free_) {
+        index = reader.read<uint32_t>();
+    }
+    const size_t live = reader.readSize();
+    for (size_t k = 0; k < live; ++k) {
+        const uint32_t index = reader.read<uint32_t>();
+        const uint32_t slot = reader.read<uint32_t>();
+        if (index >= nodes_.size() || slot > READY) {
+            throw std::runtime_error("TimerWheel Error: Corrupt timer state in checkpoint");
+        }
+        Node& node = nodes_[index];
+        node.live = true;
+        node.owner = reader.read<int>();
+        node.due = reader.readTime();
+        node.period = duration(reader.read<int64_t>());
+        node.tick = reader.read<uint64_t>();
+        link(index, slot);
+        live_++;
+    }
+}
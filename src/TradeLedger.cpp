@@ -0,0 +1,265 @@
+// TradeLedger.cpp
+#include "TradeLedger.h"
+#include "BinaryIO.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+    const char LEDGER_MAGIC[4] = {'B', 'T', 'T', 'L'};
+    const uint32_t LEDGER_VERSION = 2;
+    const std::string NO_SYMBOL;
+
+    const char* typeName(uint8_t type) {
+        return static_cast<OrderType>(type) == OrderType::BUY ? "BUY" : "SELL";
+    }
+
+    const char* kindName(uint8_t kind) {
+        switch (static_cast<OrderKind>(kind)) {
+            case OrderKind::MARKET:     return "MARKET";
+            case OrderKind::LIMIT:      return "LIMIT";
+            case OrderKind::STOP:       return "STOP";
+            case OrderKind::STOP_LIMIT: return "STOP_LIMIT";
+        }
+        return "UNKNOWN";
+    }
+
+    const char* statusName(uint8_t status) {
+        switch (static_cast<OrderStatus>(status)) {
+            case OrderStatus::CREATED:   return "CREATED";
+            case OrderStatus::SUBMITTED: return "SUBMITTED";
+            case OrderStatus::ACCEPTED:  return "ACCEPTED";
+            case OrderStatus::FILLED:    return "FILLED";
+            case OrderStatus::CLOSED:    return "CLOSED";
+            case OrderStatus::CANCELLED: return "CANCELLED";
+            case OrderStatus::REJECTED:  return "REJECTED";
+            case OrderStatus::MARGIN:    return "MARGIN";
+        }
+        return "UNKNOWN";
+    }
+
+    const char* reasonName(uint8_t reason) {
+        switch (static_cast<OrderReason>(reason)) {
+            case OrderReason::ENTRY_SIGNAL:          return "ENTRY_SIGNAL";
+            case OrderReason::EXIT_SIGNAL:           return "EXIT_SIGNAL";
+            case OrderReason::STOP_LOSS:             return "STOP_LOSS";
+            case OrderReason::TAKE_PROFIT:           return "TAKE_PROFIT";
+            case OrderReason::BANKRUPTCY_PROTECTION: return "BANKRUPTCY_PROTECTION";
+            case OrderReason::MANUAL_CLOSE:          return "MANUAL_CLOSE";
+        }
+        return "UNKNOWN";
+    }
+
+    int64_t toNanos(const std::chrono::system_clock::time_point& t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    std::chrono::system_clock::time_point fromNanos(int64_t ns) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    template <typename T>
+    void writeColumn(BinaryWriter& writer, const std::vector<T>& column) {
+        writer.writeBytes(column.data(), column.size() * sizeof(T));
+    }
+
+    template <typename T>
+    void readColumn(BinaryReader& reader, std::vector<T>& column, size_t rows) {
+        column.resize(rows);
+        reader.readBytes(column.data(), rows * sizeof(T));
+    }
+}
+
+void TradeLedger::reserve(size_t rows) {
+    ids_.reserve(rows);
+    strategyIds_.reserve(rows);
+    symbolIds_.reserve(rows);
+    types_.reserve(rows);
+    kinds_.reserve(rows);
+    statuses_.reserve(rows);
+    reasons_.reserve(rows);
+    requestedSizes_.reserve(rows);
+    filledSizes_.reserve(rows);
+    requestedPrices_.reserve(rows);
+    stopPrices_.reserve(rows);
+    filledPrices_.reserve(rows);
+    commissions_.reserve(rows);
+    realizedPnLs_.reserve(rows);
+    takeProfits_.reserve(rows);
+    stopLosses_.reserve(rows);
+    creationTimes_.reserve(rows);
+    executionTimes_.reserve(rows);
+}
+
+void TradeLedger::clear() {
+    *this = TradeLedger();
+}
+
+void TradeLedger::append(const Order& order) {
+    ids_.push_back(order.id);
+    strategyIds_.push_back(order.strategyId);
+    symbolIds_.push_back(order.symbolId);
+    types_.push_back(static_cast<uint8_t>(order.type));
+    kinds_.push_back(static_cast<uint8_t>(order.kind));
+    statuses_.push_back(static_cast<uint8_t>(order.status));
+    reasons_.push_back(static_cast<uint8_t>(order.reason));
+    requestedSizes_.push_back(order.requestedSize);
+    filledSizes_.push_back(order.filledSize);
+    requestedPrices_.push_back(order.requestedPrice);
+    stopPrices_.push_back(order.stopPrice);
+    filledPrices_.push_back(order.filledPrice);
+    commissions_.push_back(order.commission);
+    realizedPnLs_.push_back(order.realizedPnL);
+    takeProfits_.push_back(order.takeProfit);
+    stopLosses_.push_back(order.stopLoss);
+    creationTimes_.push_back(order.creationTime);
+    executionTimes_.push_back(order.executionTime);
+    // Names are only copied the first time an id shows up
+    if (order.symbolId >= static_cast<int>(symbols_.size())) {
+        symbols_.resize(order.symbolId + 1);
+    }
+    if (order.symbolId >= 0 && symbols_[order.symbolId].empty()) {
+        symbols_[order.symbolId] = order.symbol;
+    }
+}
+
+const std::string& TradeLedger::symbolName(int32_t symbolId) const {
+    if (symbolId < 0 || symbolId >= static_cast<int32_t>(symbols_.size())) return NO_SYMBOL;
+    return symbols_[symbolId];
+}
+
+Order TradeLedger::get(size_t row) const {
+    if (row >= size()) {
+        throw std::out_of_range("TradeLedger::get: row " + std::to_string(row) + " of " + std::to_string(size()));
+    }
+    Order order;
+    order.id = ids_[row];
+    order.strategyId = strategyIds_[row];
+    order.symbolId = symbolIds_[row];
+    order.symbol = symbolName(symbolIds_[row]);
+    order.type = static_cast<OrderType>(types_[row]);
+    order.kind = static_cast<OrderKind>(kinds_[row]);
+    order.status = static_cast<OrderStatus>(statuses_[row]);
+    order.reason = static_cast<OrderReason>(reasons_[row]);
+    order.requestedSize = requestedSizes_[row];
+    order.filledSize = filledSizes_[row];
+    order.requestedPrice = requestedPrices_[row];
+    order.stopPrice = stopPrices_[row];
+    order.filledPrice = filledPrices_[row];
+    order.commission = commissions_[row];
+    order.realizedPnL = realizedPnLs_[row];
+    order.takeProfit = takeProfits_[row];
+    order.stopLoss = stopLosses_[row];
+    order.creationTime = creationTimes_[row];
+    order.executionTime = executionTimes_[row];
+    return order;
+}
+
+// --- Export ---
+bool TradeLedger::exportCsv(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        Utils::logMessage("TradeLedger Error: Cannot open " + path + " for writing");
+        return false;
+    }
+    out << std::setprecision(10);
+    out << "id,strategy_id,symbol,type,kind,status,reason,requested_size,filled_size,requested_price,stop_price,filled_price,"
+           "commission,realized_pnl,take_profit,stop_loss,creation_time,execution_time\n";
+    for (size_t r = 0; r < size(); ++r) {
+        out << ids_[r] << ',' << strategyIds_[r] << ',' << symbolName(symbolIds_[r]) << ','
+            << typeName(types_[r]) << ',' << kindName(kinds_[r]) << ',' << statusName(statuses_[r]) << ',' << reasonName(reasons_[r]) << ','
+            << requestedSizes_[r] << ',' << filledSizes_[r] << ',' << requestedPrices_[r] << ',' << stopPrices_[r] << ',' << filledPrices_[r] << ','
+            << commissions_[r] << ',' << realizedPnLs_[r] << ',' << takeProfits_[r] << ',' << stopLosses_[r] << ','
+            << Utils::formatTimestamp(creationTimes_[r]) << ',' << Utils::formatTimestamp(executionTimes_[r]) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool TradeLedger::saveColumns(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    BinaryWriter writer(out);
+    writer.writeBytes(LEDGER_MAGIC, sizeof(LEDGER_MAGIC));
+    writer.write(LEDGER_VERSION);
+    writer.writeSize(size());
+    writeColumn(writer, ids_);
+    writeColumn(writer, strategyIds_);
+    writeColumn(writer, symbolIds_);
+    writeColumn(writer, types_);
+    writeColumn(writer, kinds_);
+    writeColumn(writer, statuses_);
+    writeColumn(writer, reasons_);
+    writeColumn(writer, requestedSizes_);
+    writeColumn(writer, filledSizes_);
+    writeColumn(writer, requestedPrices_);
+    writeColumn(writer, stopPrices_);
+    writeColumn(writer, filledPrices_);
+    writeColumn(writer, commissions_);
+    writeColumn(writer, realizedPnLs_);
+    writeColumn(writer, takeProfits_);
+    writeColumn(writer, stopLosses_);
+    std::vector<int64_t> times(size());
+    for (size_t r = 0; r < size(); ++r) times[r] = toNanos(creationTimes_[r]);
+    writeColumn(writer, times);
+    for (size_t r = 0; r < size(); ++r) times[r] = toNanos(executionTimes_[r]);
+    writeColumn(writer, times);
+    writer.writeSize(symbols_.size());
+    for (const std::string& name : symbols_) {
+        writer.writeString(name);
+    }
+    if (!writer.good()) {
+        Utils::logMessage("TradeLedger Error: Failed to write " + path);
+        return false;
+    }
+    return true;
+}
+
+bool TradeLedger::loadColumns(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    try {
+        BinaryReader reader(in);
+        char magic[sizeof(LEDGER_MAGIC)];
+        reader.readBytes(magic, sizeof(magic));
+        if (!std::equal(magic, magic + sizeof(magic), LEDGER_MAGIC) || reader.read<uint32_t>() != LEDGER_VERSION) {
+            Utils::logMessage("TradeLedger Warning: " + path + " is not a compatible trade ledger");
+            return false;
+        }
+        TradeLedger loaded;
+        const size_t rows = reader.readSize();
+        readColumn(reader, loaded.ids_, rows);
+        readColumn(reader, loaded.strategyIds_, rows);
+        readColumn(reader, loaded.symbolIds_, rows);
+        readColumn(reader, loaded.types_, rows);
+        readColumn(reader, loaded.kinds_, rows);
+        readColumn(reader, loaded.statuses_, rows);
+        readColumn(reader, loaded.reasons_, rows);
+        readColumn(reader, loaded.requestedSizes_, rows);
+        readColumn(reader, loaded.filledSizes_, rows);
+        readColumn(reader, loaded.requestedPrices_, rows);
+        readColumn(reader, loaded.stopPrices_, rows);
+        readColumn(reader, loaded.filledPrices_, rows);
+        readColumn(reader, loaded.commissions_, rows);
+        readColumn(reader, loaded.realizedPnLs_, rows);
+        readColumn(reader, loaded.takeProfits_, rows);
+        readColumn(reader, loaded.stopLosses_, rows);
+        std::vector<int64_t> times;
+        readColumn(reader, times, rows);
+        loaded.creationTimes_.reserve(rows);
+        for (int64_t ns : times) loaded.creationTimes_.push_back(fromNanos(ns));
+        readColumn(reader, times, rows);
+        loaded.executionTimes_.reserve(rows);
+        for (int64_t ns : times) loaded.executionTimes_.push_back(fromNanos(ns));
+        loaded.symbols_.resize(reader.readSize());
+        for (std::string& name : loaded.symbols_) {
+            name = reader.readString();
+        }
+        *this = std::move(loaded);
+        return true;
+    } catch (const std::exception& e) {
+        Utils::logMessage("TradeLedger Error: Failed to read " + path + ": " + e.what());
+        return false;
+    }
+}
@@ -1,5 +1,6 @@
 #include "TradingMetrics.h"
 #include "Utils.h"
+#include "BinaryIO.h"
 #include <cmath>
 #include <sstream>
 #include <iomanip>
@@ -107,3 +108,27 @@ std::string TradingMetrics::generateSummaryReport(double finalValue, const std::
 
     return report.str();
 }
+
+void TradingMetrics::saveState(BinaryWriter& writer) const {
+    writer.write(startingValue);
+    writer.write(highestValue);
+    writer.write(maxDrawdown);
+    writer.write(static_cast<int32_t>(tradeCount));
+    writer.write(static_cast<int32_t>(profitableTrades));
+    writer.write(totalCommission);
+    writer.write(previousValue);
+    writer.writeDoubles(returns);
+    writer.writeSize(totalBars);
+}
+
+void TradingMetrics::loadState(BinaryReader& reader) {
+    startingValue = reader.read<double>();
+    highestValue = reader.read<double>();
+    maxDrawdown = reader.read<double>();
+    tradeCount = reader.read<int32_t>();
+    profitableTrades = reader.read<int32_t>();
+    totalCommission = reader.read<double>();
+    previousValue = reader.read<double>();
+    returns = reader.readDoubles();
+    totalBars = reader.readSize();
+}
@@ -146,6 +146,16 @@ namespace Utils {
         return oss.str();
     }
 
+    uint64_t fnv1a(const void* data, size_t size, uint64_t seed) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
     #ifdef _WIN32
     #include <Windows.h>
 
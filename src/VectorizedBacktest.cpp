@@ -0,0 +1,106 @@
+// VectorizedBacktest.cpp
+#include "VectorizedBacktest.h"
+#include "CostModel.h"
+#include "Utils.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+VectorizedBacktest::VectorizedBacktest(const Config& config, const BarSeries& series) :
+    config_(config),
+    series_(series)
+{
+}
+
+VectorizedResult VectorizedBacktest::run() const {
+    std::string name = config_.getNested<std::string>("/Vectorized/SIGNAL_COLUMN", "signal");
+    int col = series_.columnIndex(name);
+    if (col < 0) {
+        throw std::runtime_error("VectorizedBacktest Error: Signal column '" + name + "' not found");
+    }
+    return run(series_.column(static_cast<size_t>(col)));
+}
+
+VectorizedResult VectorizedBacktest::run(const double* signal) const {
+    VectorizedResult result;
+    const double* prices = series_.prices();
+    const size_t n = series_.size();
+    if (!prices || !signal || n == 0) {
+        Utils::logMessage("VectorizedBacktest Error: Needs a series with a price column and a signal.");
+        return result;
+    }
+
+    const double size = config_.getNested<double>("/Vectorized/SIZE", 1.0);
+    const double startCash = config_.getNested<double>("/Broker/STARTING_CASH", 1000.0);
+    const CommissionModel commissionModel = CommissionModel::fromConfig(config_);
+    SlippageModel slippageModel = SlippageModel::fromConfig(config_);
+    slippageModel.resolveColumns(series_);
+
+    // --- Pass 1: targets and executed positions (shifted by one bar) ---
+    std::vector<double>& pos = result.positions;
+    pos.assign(n, 0.0);
+    for (size_t i = 1; i < n; ++i) {
+        const double s = signal[i - 1];
+        const double clamped = std::min(1.0, std::max(-1.0, s));
+        pos[i] = (s == s) ? clamped * size : 0.0; // NaN signal = flat
+    }
+
+    // --- Pass 2: per-bar PnL net of commission and slippage ---
+    std::vector<double> pnl(n, 0.0);
+    std::vector<double> fee(n, 0.0);
+    for (size_t i = 1; i < n; ++i) {
+        double slip = 0.0;
+        if (pos[i] != pos[i - 1]) {
+            const RebalanceCost cost(commissionModel, slippageModel, series_, i, prices[i], pos[i - 1], pos[i]);
+            fee[i] = cost.commission;
+            slip = cost.slippage;
+        }
+        pnl[i] = pos[i - 1] * (prices[i] - prices[i - 1]) - fee[i] - slip;
+    }
+
+    // --- Pass 3: scans (equity, drawdown) and reductions ---
+    std::vector<double>& equity = result.equity;
+    equity.resize(n);
+    double value = startCash;
+    double peak = startCash;
+    for (size_t i = 0; i < n; ++i) {
+        value += pnl[i];
+        equity[i] = value;
+        peak = std::max(peak, value);
+        result.maxDrawdown = std::max(result.maxDrawdown, peak > 0.0 ? (peak - value) / peak * 100.0 : 0.0);
+    }
+    double commission = 0.0;
+    int fills = 0;
+    for (size_t i = 1; i < n; ++i) {
+        commission += fee[i];
+        fills += (pos[i] != pos[i - 1]);
+    }
+    result.commission = commission;
+    result.fills = fills;
+    result.finalValue = equity.back();
+    return result;
+}
+
+double VectorizedBacktest::compare(const VectorizedResult& result, const std::vector<double>& eventEquity) {
+    if (result.equity.size() != eventEquity.size()) {
+        Utils::logMessage("VectorizedBacktest: Equity curve lengths differ (" + std::to_string(result.equity.size()) +
+                          " vs " + std::to_string(eventEquity.size()) + ")");
+        return std::numeric_limits<double>::infinity();
+    }
+    double maxDiff = 0.0;
+    size_t firstBar = result.equity.size();
+    for (size_t i = 0; i < eventEquity.size(); ++i) {
+        double diff = std::abs(result.equity[i] - eventEquity[i]);
+        if (diff > maxDiff) {
+            if (firstBar == result.equity.size() && diff > 1e-9) firstBar = i;
+            maxDiff = diff;
+        }
+    }
+    if (firstBar < result.equity.size()) {
+        Utils::logMessage("VectorizedBacktest: First divergence at bar " + std::to_string(firstBar) +
+                          " (vectorized " + std::to_string(result.equity[firstBar]) +
+                          ", event-driven " + std::to_string(eventEquity[firstBar]) + ")");
+    }
+    return maxDiff;
+}
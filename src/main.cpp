@@ -5,6 +5,12 @@
 #include "HMMStrategy.h"
 #include "Utils.h"
 #include "BenchmarkStrategy.h"
+#include "BatchRandomStrategy.h"
+#include "SweepRunner.h"
+#include "SignalStrategy.h"
+#include "VectorizedBacktest.h"
+#include "ReplayRunner.h"
+#include "QuoteReplayStrategy.h"
 #include <iostream>
 #include <memory>
 #include <string>
@@ -24,7 +30,50 @@ void waitForKeypress() {
     getchar();
 }
 
-int main() {
+// Creates a strategy instance from its config type name
+std::unique_ptr<Strategy> createStrategy(const std::string& stratType) {
+    if (stratType == "ML") {
+        return std::make_unique<HMMStrategy>();
+    } else if (stratType == "Benchmark") {
+        return std::make_unique<BenchmarkStrategy>();
+    } else if (stratType == "Signal") {
+        return std::make_unique<SignalStrategy>();
+    }
+    return std::make_unique<RandomStrategy>();
+}
+
+// Adds the strategies of /Portfolio/STRATEGIES (or the single /Strategy/Type)
+// to the engine; announce also reports each one on stdout
+void addConfiguredStrategies(BacktestEngine& engine, const Config& config, bool announce) {
+    nlohmann::json portfolio = config.getNested<nlohmann::json>("/Portfolio/STRATEGIES", nlohmann::json::array());
+    if (portfolio.is_array() && !portfolio.empty()) {
+        for (const auto& entry : portfolio) {
+            std::string stratType = entry.value("Type", std::string("Random"));
+            double allocation = entry.value("ALLOCATION", 1.0);
+            std::unique_ptr<Strategy> strategy = createStrategy(stratType);
+            Utils::logMessage("Main: Adding " + strategy->getName() + " strategy to portfolio.");
+            if (announce) std::cout << "Adding " << strategy->getName() << " strategy..." << std::endl;
+            engine.addStrategy(std::move(strategy), allocation);
+        }
+    } else {
+        std::string stratType = config.getNested<std::string>("/Strategy/Type", "Random");
+        std::unique_ptr<Strategy> strategy = createStrategy(stratType);
+        Utils::logMessage("Main: Creating " + strategy->getName() + " strategy.");
+        if (announce) std::cout << "Creating " << strategy->getName() << " strategy..." << std::endl;
+        engine.setStrategy(std::move(strategy));
+    }
+}
+
+// Creates a tick-level replay strategy from its /Replay/STRATEGY name (nullptr = book only)
+std::unique_ptr<ReplayStrategy> createReplayStrategy(const std::string& stratType) {
+    if (stratType == "Quote") {
+        return std::make_unique<QuoteReplayStrategy>();
+    }
+    return nullptr;
+}
+
+// Usage: backtester [config file] (default config.json)
+int main(int argc, char* argv[]) {
     try {
         Utils::logMessage("--- C++ Backtester Starting ---");
         //set python path
@@ -32,7 +81,7 @@ int main() {
 
         // 1. Create and Load Configuration
         Config config;
-        std::string configFilename = "config.json"; // Define config file name
+        std::string configFilename = argc > 1 ? argv[1] : "config.json"; // e.g. verify_config.json checks the vectorized runner
         if (!config.loadFromFile(configFilename)) {
             // Log message already handled in loadFromFile if creation failed
             Utils::logMessage("Main Warning: Proceeding with internal default configuration.");
@@ -44,6 +93,19 @@ int main() {
         // Override a value after loading (e.g., from command line later)
         // config.set<bool>("/Strategy/DEBUG_MODE"_json_pointer, true);
 
+        // 1.5 Tick-level replay through the matching engine instead of a bar backtest
+        std::string replayMode = config.getNested<std::string>("/Replay/MODE", "None");
+        if (replayMode != "None") {
+            std::cout << "Running tick-level replay (" << replayMode << ")..." << std::endl;
+            std::unique_ptr<ReplayStrategy> replayStrategy =
+                createReplayStrategy(config.getNested<std::string>("/Replay/STRATEGY", "Quote"));
+            ReplayRunner runner(config);
+            const bool ok = runner.runMode(replayMode, replayStrategy.get());
+            Utils::logMessage("--- C++ Backtester Finished ---");
+            waitForKeypress();
+            return ok ? 0 : 1;
+        }
+
         // 2. Create Backtest Engine (Pass the loaded config)
         std::unique_ptr<BacktestEngine> engine;
         try {
@@ -65,23 +127,76 @@ int main() {
             return 1;
         }
 
+        // 3.25 Lock-step parameter sweep instead of a single backtest
+        std::string sweepMode = config.getNested<std::string>("/Sweep/MODE", "None");
+        if (sweepMode == "Lockstep" || sweepMode == "Halving" || sweepMode == "Genetic") {
+            nlohmann::json grid = config.getNested<nlohmann::json>("/Sweep/GRID", nlohmann::json::object());
+            SweepRunner runner(config, engine->getSeries());
+            BatchRandomStrategy batchStrategy;
+            // Halving and Genetic can run every candidate through a full engine instead of the batch strategy
+            bool engineEvaluated = config.getNested<std::string>("/Sweep/EVALUATOR", "Batch") == "Engine";
+            if (engineEvaluated && sweepMode == "Lockstep") {
+                Utils::logMessage("Main Warning: Lockstep sweeps always run " + batchStrategy.getName() + "; /Sweep/EVALUATOR ignored.");
+                engineEvaluated = false;
+            }
+            if (engineEvaluated) {
+                runner.useEngine(engine->getBars(), [](BacktestEngine& candidate, const Config& candidateConfig) {
+                    addConfiguredStrategies(candidate, candidateConfig, false);
+                });
+            } else if (!SweepRunner::checkGrid(batchStrategy, grid)) {
+                std::cerr << "Main Error: /Sweep/GRID has paths " << batchStrategy.getName() << " does not read. Exiting." << std::endl;
+                waitForKeypress();
+                return 1;
+            }
+            if (sweepMode == "Halving") {
+                std::cout << "Running successive-halving sweep..." << std::endl;
+                SweepRunner::logResults(runner.runHalving(batchStrategy, grid));
+            } else if (sweepMode == "Genetic") {
+                std::cout << "Running genetic sweep..." << std::endl;
+                SweepRunner::logResults(runner.runGenetic(batchStrategy, grid));
+            } else {
+                std::vector<ParamSet> params = SweepRunner::expandGrid(grid);
+                std::cout << "Running lock-step sweep over " << params.size() << " parameter sets..." << std::endl;
+                SweepRunner::logResults(runner.runLockstep(batchStrategy, params));
+            }
+            Utils::logMessage("--- C++ Backtester Finished ---");
+            waitForKeypress();
+            return 0;
+        }
+
+        // 3.3 Vectorized signal-array backtest instead of the event loop
+        std::string vectorizedMode = config.getNested<std::string>("/Vectorized/MODE", "None");
+        if (vectorizedMode == "Run" || vectorizedMode == "Verify") {
+            std::cout << "Running vectorized signal backtest..." << std::endl;
+            VectorizedBacktest vectorized(config, engine->getSeries());
+            VectorizedResult vr = vectorized.run();
+            Utils::logMessage("Vectorized: Final: " + std::to_string(vr.finalValue) +
+                              ", Fills: " + std::to_string(vr.fills) +
+                              ", Commission: " + std::to_string(vr.commission) +
+                              ", MaxDD: " + std::to_string(vr.maxDrawdown) + "%");
+            int exitCode = 0;
+            if (vectorizedMode == "Verify") {
+                engine->setStrategy(std::make_unique<SignalStrategy>());
+                engine->run();
+                double diff = VectorizedBacktest::compare(vr, engine->getEquityCurve());
+                double tolerance = config.getNested<double>("/Vectorized/TOLERANCE", 1e-6);
+                bool match = diff <= tolerance;
+                Utils::logMessage(std::string("Vectorized: ") + (match ? "Matches" : "DOES NOT match") +
+                                  " the event-driven engine (max equity difference " + std::to_string(diff) + ")");
+                std::cout << "Vectorized verify: " << (match ? "OK" : "MISMATCH") << std::endl;
+                exitCode = match ? 0 : 1;
+            }
+            Utils::logMessage("--- C++ Backtester Finished ---");
+            waitForKeypress();
+            return exitCode;
+        }
+
         // 3.5 See if ONNX runtime is setup correctly
         // OnnxModelInterface model = OnnxModelInterface();
         // model.PrintModelInfo();
 
-        // 4. Create and Set Strategy based on config
-        std::string stratType = config.getNested<std::string>("/Strategy/Type", "Random");
-        std::unique_ptr<Strategy> strategy;
-        if (stratType == "ML") {
-            strategy = std::make_unique<HMMStrategy>();
-        } else if (stratType == "Benchmark") {
-            strategy = std::make_unique<BenchmarkStrategy>();
-        } else {
-            strategy = std::make_unique<RandomStrategy>();
-        }
-        Utils::logMessage("Main: Creating " + strategy->getName() + " strategy.");
-        std::cout << "Creating " << strategy->getName() << " strategy..." << std::endl;
-        engine->setStrategy(std::move(strategy));
+        // 4. Create and Set Strategies based on config
+        addConfiguredStrategies(*engine, config, true);
 
         // 5. Run the Backtest
         std::cout << "Starting backtest..." << std::endl;